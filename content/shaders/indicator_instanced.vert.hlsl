@@ -0,0 +1,46 @@
+struct VertexInput
+{
+    float3 Position : TEXCOORD0;
+    float3 Normal : TEXCOORD1;
+    float3 Color : TEXCOORD2;
+    float2 UV : TEXCOORD3;
+    float3 InstancePosition : TEXCOORD4;
+    float3 InstanceAxisX : TEXCOORD5;
+    float3 InstanceAxisY : TEXCOORD6;
+    float3 InstanceAxisZ : TEXCOORD7;
+};
+
+struct VertexOutput
+{
+    float4 Position : SV_Position;
+    float3 Normal : TEXCOORD0;
+    float3 Color : TEXCOORD1;
+    float2 UV : TEXCOORD2;
+};
+
+cbuffer UniformBlock : register(b0, space1)
+{
+    float4x4 ViewProjectionMatrix : packoffset(c0);
+    float4   ModelPosition        : packoffset(c4);
+    float4x4 ModelMatrix          : packoffset(c5);
+};
+
+VertexOutput main(VertexInput input)
+{
+    VertexOutput output;
+
+    // The instance transform arrives as its three columns
+    float3 rotatedPos = input.Position.x * input.InstanceAxisX + input.Position.y * input.InstanceAxisY +
+        input.Position.z * input.InstanceAxisZ;
+
+    // Instances are stored relative to the origin of the draw, ModelPosition is the origin relative to the camera
+    float3 cameraRelativePos = ModelPosition.xyz + input.InstancePosition + rotatedPos;
+
+    output.Position = mul(ViewProjectionMatrix, float4(cameraRelativePos, 1.0));
+    output.Color = input.Color;
+    output.Normal = normalize(input.Normal.x * input.InstanceAxisX + input.Normal.y * input.InstanceAxisY +
+        input.Normal.z * input.InstanceAxisZ);
+    output.UV = input.UV;
+
+    return output;
+}
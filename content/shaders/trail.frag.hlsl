@@ -0,0 +1,14 @@
+struct PixelInput
+{
+    float4 Position : SV_Position;
+};
+
+cbuffer ColorBlock : register(b0, space3)
+{
+    float4 TrailColor : packoffset(c0);
+};
+
+float4 main(PixelInput input) : SV_Target0
+{
+    return TrailColor;
+}
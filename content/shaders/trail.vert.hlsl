@@ -0,0 +1,28 @@
+struct VertexInput
+{
+    float3 Position : TEXCOORD0;
+};
+
+struct VertexOutput
+{
+    float4 Position : SV_Position;
+};
+
+cbuffer UniformBlock : register(b0, space1)
+{
+    float4x4 ViewProjectionMatrix : packoffset(c0);
+    float4   ModelPosition        : packoffset(c4);
+    float4x4 ModelMatrix          : packoffset(c5);
+};
+
+VertexOutput main(VertexInput input)
+{
+    VertexOutput output;
+
+    // Trail points are stored relative to the trail origin, ModelPosition is the origin relative to the camera
+    float3 cameraRelativePos = ModelPosition.xyz + mul(ModelMatrix, float4(input.Position, 1.0)).xyz;
+
+    output.Position = mul(ViewProjectionMatrix, float4(cameraRelativePos, 1.0));
+
+    return output;
+}
@@ -0,0 +1,312 @@
+#include "adsb_receiver.hpp"
+
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace flb
+{
+namespace
+{
+constexpr std::size_t SBSFieldCount = 22;
+constexpr double FeetToMeters = 0.3048;
+constexpr double KnotsToMetersPerSecond = 1852.0 / 3600.0;
+constexpr double FeetPerMinuteToMetersPerSecond = FeetToMeters / 60.0;
+// longest the receive thread blocks on the socket before checking whether it was stopped
+constexpr int PollTimeoutMs = 100;
+
+bool parseNumber(std::string_view text, double& outValue)
+{
+  const char* end = text.data() + text.size();
+  const auto [next, error] = std::from_chars(text.data(), end, outValue);
+  return !text.empty() && error == std::errc{} && next == end;
+}
+
+bool parseAddress(std::string_view text, std::uint32_t& outAddress)
+{
+  std::uint32_t flags = 0;
+  if (text.starts_with('~'))
+  {
+    flags = TrafficReport::NON_ICAO_ADDRESS;
+    text.remove_prefix(1);
+  }
+  if (text.empty() || text.size() > 6)
+  {
+    return false;
+  }
+
+  const char* end = text.data() + text.size();
+  const auto [next, error] = std::from_chars(text.data(), end, outAddress, 16);
+  outAddress |= flags;
+  return error == std::errc{} && next == end;
+}
+} // namespace
+
+bool parseSBSMessage(std::string_view line, TrafficReport& outReport)
+{
+  // message type, transmission type, session, aircraft and flight ids, hex ident, four date and time fields, callsign,
+  // altitude, ground speed, track, latitude, longitude, vertical rate, squawk and four flags
+  std::array<std::string_view, SBSFieldCount> fields{};
+  std::size_t fieldCount = 0;
+  for (std::size_t start = 0; fieldCount < SBSFieldCount;)
+  {
+    const std::size_t end = line.find(',', start);
+    fields[fieldCount++] = line.substr(start, end == std::string_view::npos ? end : end - start);
+    if (end == std::string_view::npos)
+    {
+      break;
+    }
+    start = end + 1;
+  }
+
+  outReport = {};
+  if (fieldCount <= 4 || fields[0] != "MSG" || !parseAddress(fields[4], outReport.address))
+  {
+    return false;
+  }
+
+  std::string_view callsign = fields[10];
+  while (!callsign.empty() && callsign.back() == ' ')
+  {
+    callsign.remove_suffix(1);
+  }
+  if (!callsign.empty())
+  {
+    outReport.callsign.fill(' ');
+    std::copy_n(callsign.begin(), std::min(callsign.size(), outReport.callsign.size()), outReport.callsign.begin());
+    outReport.fields |= TrafficReport::CALLSIGN;
+  }
+
+  double altitude = 0.0;
+  if (parseNumber(fields[11], altitude))
+  {
+    outReport.altitude = altitude * FeetToMeters;
+    outReport.fields |= TrafficReport::ALTITUDE;
+  }
+
+  double groundSpeed = 0.0;
+  double track = 0.0;
+  if (parseNumber(fields[12], groundSpeed) && parseNumber(fields[13], track))
+  {
+    outReport.groundSpeed = static_cast<float>(groundSpeed * KnotsToMetersPerSecond);
+    outReport.track = static_cast<float>(track);
+    outReport.fields |= TrafficReport::VELOCITY;
+  }
+
+  double latitude = 0.0;
+  double longitude = 0.0;
+  if (
+    parseNumber(fields[14], latitude) && parseNumber(fields[15], longitude) && std::abs(latitude) <= 90.0 &&
+    std::abs(longitude) <= 180.0)
+  {
+    outReport.latitude = latitude;
+    outReport.longitude = longitude;
+    outReport.fields |= TrafficReport::POSITION;
+  }
+
+  double verticalRate = 0.0;
+  if (parseNumber(fields[16], verticalRate))
+  {
+    outReport.verticalRate = static_cast<float>(verticalRate * FeetPerMinuteToMetersPerSecond);
+    outReport.fields |= TrafficReport::VERTICAL_RATE;
+  }
+
+  return true;
+}
+
+bool ADSBReceiver::init(std::string_view address)
+{
+  const std::size_t colon = address.rfind(':');
+  if (colon == std::string_view::npos || colon == 0 || colon + 1 == address.size())
+  {
+    SDL_Log(
+      "Invalid ADS-B feed address %.*s, expected host:port", static_cast<int>(address.size()), address.data());
+    return false;
+  }
+
+  host = address.substr(0, colon);
+  port = address.substr(colon + 1);
+
+  running.store(true, std::memory_order_relaxed);
+  receiveThread = std::thread([this]() { run(); });
+  return true;
+}
+
+void ADSBReceiver::cleanup()
+{
+  running.store(false, std::memory_order_relaxed);
+  if (receiveThread.joinable())
+  {
+    receiveThread.join();
+  }
+}
+
+void ADSBReceiver::run()
+{
+  // a feed that isn't up is only reported once until it comes up
+  bool logFailure = true;
+  while (running.load(std::memory_order_relaxed))
+  {
+    const int socket = connectToFeed(logFailure);
+    logFailure = socket >= 0;
+    if (socket >= 0)
+    {
+      SDL_Log("Receiving ADS-B traffic from %s:%s", host.c_str(), port.c_str());
+      receive(socket);
+      ::close(socket);
+    }
+
+    // waits in short steps so that cleanup() doesn't have to wait for the whole interval
+    const TimePoint retryAt = now() + fromSeconds(RECONNECT_INTERVAL);
+    while (running.load(std::memory_order_relaxed) && now() < retryAt)
+    {
+      SDL_Delay(PollTimeoutMs);
+    }
+  }
+}
+
+int ADSBReceiver::connectToFeed(bool logFailure) const
+{
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  addrinfo* addresses = nullptr;
+  const int resolveError = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+  if (resolveError != 0)
+  {
+    if (logFailure)
+    {
+      SDL_Log("Failed to resolve ADS-B feed %s:%s: %s", host.c_str(), port.c_str(), ::gai_strerror(resolveError));
+    }
+    return -1;
+  }
+
+  int result = -1;
+  for (const addrinfo* address = addresses; address != nullptr && result < 0; address = address->ai_next)
+  {
+    const int socket =
+      ::socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, address->ai_protocol);
+    if (socket < 0)
+    {
+      continue;
+    }
+
+    // the connection completes in the background, its outcome is known once the socket becomes writable
+    bool connected = ::connect(socket, address->ai_addr, address->ai_addrlen) == 0;
+    if (!connected && errno == EINPROGRESS && waitFor(socket, POLLOUT))
+    {
+      int socketError = 0;
+      socklen_t length = sizeof(socketError);
+      connected = ::getsockopt(socket, SOL_SOCKET, SO_ERROR, &socketError, &length) == 0 && socketError == 0;
+    }
+
+    if (connected)
+    {
+      result = socket;
+    }
+    else
+    {
+      ::close(socket);
+    }
+  }
+  ::freeaddrinfo(addresses);
+
+  if (result < 0 && logFailure && running.load(std::memory_order_relaxed))
+  {
+    SDL_Log(
+      "Failed to connect to ADS-B feed %s:%s, retrying every %.0f s",
+      host.c_str(),
+      port.c_str(),
+      RECONNECT_INTERVAL);
+  }
+  return result;
+}
+
+void ADSBReceiver::receive(int socket)
+{
+  std::vector<char> buffer(BUFFER_SIZE);
+  std::size_t filled = 0;
+  while (waitFor(socket, POLLIN))
+  {
+    const ssize_t received = ::recv(socket, buffer.data() + filled, buffer.size() - filled, 0);
+    if (received == 0)
+    {
+      SDL_Log("ADS-B feed %s:%s closed the connection", host.c_str(), port.c_str());
+      return;
+    }
+    if (received < 0)
+    {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+      {
+        continue;
+      }
+      SDL_Log("Failed to read the ADS-B feed %s:%s: %s", host.c_str(), port.c_str(), std::strerror(errno));
+      return;
+    }
+
+    filled += static_cast<std::size_t>(received);
+    const TimePoint receivedAt = now();
+
+    std::string_view pending{buffer.data(), filled};
+    for (std::size_t end = pending.find('\n'); end != std::string_view::npos; end = pending.find('\n'))
+    {
+      std::string_view line = pending.substr(0, end);
+      if (line.ends_with('\r'))
+      {
+        line.remove_suffix(1);
+      }
+
+      TrafficReport report;
+      if (parseSBSMessage(line, report))
+      {
+        report.receivedAt = receivedAt;
+        if (!queue.push(report))
+        {
+          droppedReports.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+      pending.remove_prefix(end + 1);
+    }
+
+    // the partial last line is completed by the next read, one that fills the whole buffer isn't a message
+    if (pending.size() == buffer.size())
+    {
+      filled = 0;
+    }
+    else
+    {
+      std::memmove(buffer.data(), pending.data(), pending.size());
+      filled = pending.size();
+    }
+  }
+}
+
+bool ADSBReceiver::waitFor(int socket, short events) const
+{
+  pollfd descriptor{.fd = socket, .events = events, .revents = 0};
+  while (running.load(std::memory_order_relaxed))
+  {
+    const int ready = ::poll(&descriptor, 1, PollTimeoutMs);
+    if (ready > 0)
+    {
+      // errors and hangups are reported by the connect or recv that follows
+      return true;
+    }
+    if (ready < 0 && errno != EINTR)
+    {
+      return false;
+    }
+  }
+  return false;
+}
+
+} // namespace flb
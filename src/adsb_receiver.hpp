@@ -0,0 +1,118 @@
+#pragma once
+
+#include "spsc_queue.hpp"
+#include "time.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace flb
+{
+
+/**
+ * A single decoded SBS-1 (BaseStation) message. Each transmission type carries only some of the fields, fields holds
+ * the Field bits of those present.
+ */
+struct TrafficReport
+{
+  enum Field : std::uint8_t
+  {
+    CALLSIGN = 1 << 0,
+    // latitude and longitude
+    POSITION = 1 << 1,
+    ALTITUDE = 1 << 2,
+    // groundSpeed and track
+    VELOCITY = 1 << 3,
+    VERTICAL_RATE = 1 << 4,
+  };
+
+  // addresses dump1090 marks as not being ICAO ones, such as TIS-B tracks, have this bit set
+  static constexpr std::uint32_t NON_ICAO_ADDRESS = 1u << 24;
+
+  std::uint32_t address = 0;
+  std::uint8_t fields = 0;
+  // space padded, not null terminated
+  std::array<char, 8> callsign{};
+  TimePoint receivedAt = 0;
+  double latitude = 0.0;
+  double longitude = 0.0;
+  // barometric altitude in meters
+  double altitude = 0.0;
+  // meters per second
+  float groundSpeed = 0.0f;
+  // degrees clockwise from true north
+  float track = 0.0f;
+  // meters per second, positive up
+  float verticalRate = 0.0f;
+};
+
+/**
+ * Parses a single SBS-1 line without its line ending, reading the fields in place. Returns false for anything other
+ * than a MSG line with a valid hex ident, fields that are empty or malformed are left out of outReport.fields.
+ */
+bool parseSBSMessage(std::string_view line, TrafficReport& outReport);
+
+/**
+ * Reads an SBS-1 feed, such as the one dump1090 serves on port 30003, from a TCP socket on a dedicated thread. The
+ * stream is received into a fixed buffer and every complete line is parsed where it lies, so a message costs no
+ * allocation or copy before it is queued. The frame thread drains the reports without ever blocking on the socket.
+ *
+ * The receiver reconnects every RECONNECT_INTERVAL seconds while the feed is unreachable, a replay of a recorded feed
+ * only has to listen on a port, e.g. with `nc -l 30003 < feed.sbs`.
+ */
+class ADSBReceiver
+{
+public:
+  // several seconds of a busy 10k messages per second feed at 60 frames per second
+  static constexpr std::size_t QUEUE_CAPACITY = 16384;
+  static constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+  static constexpr double RECONNECT_INTERVAL = 2.0;
+
+  /**
+   * Starts receiving from address, given as host:port. Returns false if address isn't of that form.
+   */
+  bool init(std::string_view address);
+  void cleanup();
+
+  // Called only from the frame thread. Passes every pending report to the callback in arrival order.
+  template <typename Func>
+  std::size_t drain(Func callback)
+  {
+    const std::size_t count = queue.drain(callback);
+
+    const std::uint64_t dropped = droppedReports.load(std::memory_order_relaxed);
+    if (dropped != reportedDroppedReports)
+    {
+      SDL_Log(
+        "ADS-B queue overflowed, %llu reports dropped",
+        static_cast<unsigned long long>(dropped - reportedDroppedReports));
+      reportedDroppedReports = dropped;
+    }
+
+    return count;
+  }
+
+private:
+  void run();
+  int connectToFeed(bool logFailure) const;
+  void receive(int socket);
+  bool waitFor(int socket, short events) const;
+
+  std::string host;
+  std::string port;
+
+  SPSCQueue<TrafficReport, QUEUE_CAPACITY> queue;
+  std::atomic<std::uint64_t> droppedReports{0};
+  std::uint64_t reportedDroppedReports = 0;
+
+  std::atomic<bool> running{false};
+  std::thread receiveThread;
+};
+
+} // namespace flb
@@ -1,6 +1,8 @@
 #include "app.hpp"
 #include "components.hpp"
 #include "math.hpp"
+#include "mesh_cache.hpp"
+#include "model_culling.hpp"
 #include "obj_loader.hpp"
 
 #include <glm/ext/vector_common.hpp>
@@ -8,6 +10,9 @@
 #include <cstddef>
 #include <filesystem>
 #include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 using namespace flb;
 
@@ -21,10 +26,10 @@ Model loadModel(
   const std::filesystem::path& texturePath,
   int textureWidth,
   int textureHeight,
-  const char* modelName)
+  const char* modelName,
+  bool useMeshlets)
 {
-  const auto [vertexData, indexData] = loadOBJ(objPath);
-  const MeshHandle meshHandle = meshManager.allocate(vertexData, indexData);
+  const MeshHandle meshHandle = loadCachedMesh(meshManager, objPath, useMeshlets);
   const Mesh mesh = meshManager.get(meshHandle);
   if (!meshHandle.isValid() || mesh.vertexBuffer.buffer == nullptr || mesh.indexBuffer.buffer == nullptr)
   {
@@ -137,7 +142,87 @@ void App::toggleCameraMode()
   }
 }
 
-SDL_AppResult App::init()
+CameraState App::getCameraState() const
+{
+  return {
+    .position = activeCamera().position,
+    .up = activeCamera().up,
+    .yaw = activeCamera().yaw,
+    .pitch = perspectiveCamera.pitch,
+    .fov = perspectiveCamera.fov,
+    .orthographicHeight = orthographicCamera.orthographicHeight,
+    .orthographicAltitude = orthographicCamera.orthographicAltitude,
+    .mode = static_cast<std::uint32_t>(activeCameraMode),
+  };
+}
+
+void App::applyCameraState(const CameraState& state)
+{
+  perspectiveCamera.position = state.position;
+  perspectiveCamera.up = state.up;
+  perspectiveCamera.yaw = state.yaw;
+  perspectiveCamera.pitch = state.pitch;
+  perspectiveCamera.fov = state.fov;
+
+  if (static_cast<CameraMode>(state.mode) == CameraMode::Orthographic)
+  {
+    orthographicCamera.orthographicHeight = state.orthographicHeight;
+    orthographicCamera.orthographicAltitude = state.orthographicAltitude;
+    orthographicCamera.resetFrom(perspectiveCamera);
+    activeCameraMode = CameraMode::Orthographic;
+  }
+  else
+  {
+    activeCameraMode = CameraMode::Perspective;
+  }
+}
+
+void App::handleReplayKey(SDL_Keycode key)
+{
+  constexpr double seekStep = 10.0;
+
+  switch (key)
+  {
+    case SDLK_SPACE:
+      replayPaused = !replayPaused;
+      break;
+    case SDLK_LEFT:
+    case SDLK_RIGHT:
+    {
+      const double target = flightReplay.getTime() + (key == SDLK_LEFT ? -seekStep : seekStep);
+      vehicleRegistry.resetStates(registry);
+      trailManager.reset();
+      // rewind by the render delay so the estimators have samples around the target time
+      flightReplay.seek(target - VehicleStateEstimator::DEFAULT_RENDER_DELAY);
+      flightReplay.advance(
+        VehicleStateEstimator::DEFAULT_RENDER_DELAY,
+        [this](const TelemetrySample& sample) { vehicleRegistry.ingest(registry, sample); },
+        [](const CameraState&) {});
+      break;
+    }
+    case SDLK_UP:
+      replaySpeed = glm::min(replaySpeed * 2.0, 256.0);
+      break;
+    case SDLK_DOWN:
+      replaySpeed = glm::max(replaySpeed * 0.5, 1.0 / 16.0);
+      break;
+    case SDLK_F:
+      followReplayCamera = !followReplayCamera;
+      break;
+    default:
+      return;
+  }
+
+  SDL_Log(
+    "Replay %.1f / %.1f s, speed %.2fx%s%s",
+    flightReplay.getTime(),
+    flightReplay.getEndTime(),
+    replaySpeed,
+    replayPaused ? ", paused" : "",
+    followReplayCamera ? ", following recorded camera" : "");
+}
+
+SDL_AppResult App::init(const AppOptions& options)
 {
   {
     Timer timer("Initialization");
@@ -169,8 +254,10 @@ SDL_AppResult App::init()
     textureManager.init(&allocator);
     meshManager.init(&allocator);
     tileManager.init(&registry, &allocator, &textureManager);
+    trailManager.init(&registry, &allocator);
 
-    const Model vehicleModel = loadModel(
+    std::unordered_map<std::string, Model> vehicleModels;
+    vehicleModels["floatplane"] = loadModel(
       meshManager,
       textureManager,
       allocator,
@@ -178,13 +265,9 @@ SDL_AppResult App::init()
       "content/models/floatplane/textures/floatplane_Albedo.png",
       4096,
       4096,
-      "vehicle");
-    if (!vehicleModel.isValid())
-    {
-      return SDL_APP_FAILURE;
-    }
-
-    const Model tb2Model = loadModel(
+      "floatplane",
+      options.useMeshlets);
+    vehicleModels["tb2"] = loadModel(
       meshManager,
       textureManager,
       allocator,
@@ -192,22 +275,20 @@ SDL_AppResult App::init()
       "content/models/tb2/Image_0.png",
       1024,
       1024,
-      "tb2");
-    if (!tb2Model.isValid())
+      "tb2",
+      options.useMeshlets);
+    for (const auto& [name, model] : vehicleModels)
     {
-      return SDL_APP_FAILURE;
+      if (!model.isValid())
+      {
+        return SDL_APP_FAILURE;
+      }
     }
 
-    auto vehicle = registry.create();
-    registry.emplace<component::Position>(vehicle, perspectiveCamera.position);
-    registry.emplace<component::Transform>(vehicle, getSurfaceAlignedTransform(startCoords));
-    registry.emplace<component::Model>(vehicle, vehicleModel);
-
-    GeoCoords tb2Coords{39.811224, 30.528496};
-    auto tb2 = registry.create();
-    registry.emplace<component::Position>(tb2, geoToECEF(tb2Coords));
-    registry.emplace<component::Transform>(tb2, getSurfaceAlignedTransform(tb2Coords));
-    registry.emplace<component::Model>(tb2, tb2Model);
+    if (vehicleRegistry.init(registry, vehicleModels) != SDL_APP_CONTINUE)
+    {
+      return SDL_APP_FAILURE;
+    }
 
     if (flightBoundary.init(registry, meshManager) != SDL_APP_CONTINUE)
     {
@@ -219,10 +300,38 @@ SDL_AppResult App::init()
       return SDL_APP_FAILURE;
     }
 
+    if (trafficManager.init(registry, meshManager, allocator) != SDL_APP_CONTINUE)
+    {
+      return SDL_APP_FAILURE;
+    }
+    if (!options.adsbAddress.empty() && !adsbReceiver.init(options.adsbAddress))
+    {
+      return SDL_APP_FAILURE;
+    }
+
     renderer.initDebugSphere(allocator);
     renderer.initTileIndexBuffer(allocator);
 
-    ros.init();
+    if (!options.replayPath.empty())
+    {
+      if (!flightReplay.open(options.replayPath))
+      {
+        return SDL_APP_FAILURE;
+      }
+      replaySpeed = options.replaySpeed;
+    }
+    else
+    {
+      if (!options.recordPath.empty() && !flightRecorder.open(options.recordPath, now()))
+      {
+        return SDL_APP_FAILURE;
+      }
+      telemetryLink.init(vehicleRegistry.getNamespaces());
+      if (!options.sharedTelemetryName.empty())
+      {
+        sharedTelemetry.open(options.sharedTelemetryName);
+      }
+    }
   }
 
   return SDL_APP_CONTINUE;
@@ -231,10 +340,17 @@ SDL_AppResult App::init()
 void App::cleanup()
 {
   imGuiLayer.cleanup(renderer.getDevice().getPtr());
-  ros.cleanup();
+  telemetryLink.cleanup();
+  sharedTelemetry.close();
+  adsbReceiver.cleanup();
+  flightRecorder.close();
   tileManager.cleanup();
+  trailManager.cleanup();
+  separationMonitor.clear(registry);
+  trafficManager.clear(registry);
   noFlyZones.clear(registry);
   flightBoundary.clear(registry);
+  vehicleRegistry.clear(registry);
   releaseRegistryGpuResources(registry, allocator, meshManager, textureManager);
   registry.clear();
   allocator.cleanup();
@@ -287,6 +403,15 @@ SDL_AppResult App::handleEvent(SDL_Event* event)
     return SDL_APP_CONTINUE;
   }
 
+  if (event->type == SDL_EVENT_KEY_DOWN && flightReplay.isOpen())
+  {
+    if (!imGuiLayer.wantsKeyboardCapture() || imGuiLayer.isMainViewFocused())
+    {
+      handleReplayKey(event->key.key);
+    }
+    return SDL_APP_CONTINUE;
+  }
+
   if (event->type == SDL_EVENT_MOUSE_WHEEL)
   {
     if (imGuiLayer.wantsMouseCapture() && !imGuiLayer.isMainViewHovered())
@@ -307,8 +432,40 @@ SDL_AppResult App::handleEvent(SDL_Event* event)
 
 SDL_AppResult App::update(float dt)
 {
-  ros.update();
-  glm::dvec3 coords = ros.getVehicleCoords();
+  const TimePoint frameTime = now();
+
+  if (flightReplay.isOpen())
+  {
+    flightReplay.advance(
+      replayPaused ? 0.0 : dt * replaySpeed,
+      [this](const TelemetrySample& sample) { vehicleRegistry.ingest(registry, sample); },
+      [this](const CameraState& state)
+      {
+        if (followReplayCamera)
+        {
+          applyCameraState(state);
+        }
+      });
+    vehicleRegistry.updatePoses(registry, flightReplay.getFrameTime());
+  }
+  else
+  {
+    const auto ingest = [this](const TelemetrySample& sample)
+    {
+      flightRecorder.recordTelemetry(sample);
+      vehicleRegistry.ingest(registry, sample);
+    };
+    telemetryLink.getChannel().drain(ingest);
+    sharedTelemetry.drain(ingest);
+    vehicleRegistry.updatePoses(registry, frameTime);
+  }
+
+  noFlyZones.update(registry);
+  flightBoundary.update(registry);
+  separationMonitor.update(registry);
+
+  adsbReceiver.drain([this](const TrafficReport& report) { trafficManager.ingest(report); });
+  trafficManager.update(registry, frameTime);
 
   const bool* keyStates = SDL_GetKeyboardState(NULL);
   if (cameraMouseLook || imGuiLayer.isMainViewFocused() || !imGuiLayer.wantsKeyboardCapture())
@@ -317,7 +474,14 @@ SDL_AppResult App::update(float dt)
     camera.updateKeyboard(dt, keyStates);
   }
 
-  tileManager.update(activeCamera(), now());
+  flightRecorder.recordCamera(getCameraState(), frameTime);
+
+  // trails and traffic instances only queue their uploads, the tile manager update flushes them
+  trailManager.update();
+  trafficManager.uploadInstances(registry, activeCamera());
+  tileManager.update(activeCamera(), mainViewHeight, frameTime);
+  // after the tile manager, which clears the visibility tags of the previous frame
+  markVisibleModels(registry, activeCamera());
 
   return SDL_APP_CONTINUE;
 }
@@ -334,11 +498,15 @@ SDL_AppResult App::draw()
       return SDL_APP_FAILURE;
     }
     setCameraAspect(mainViewRect.aspect());
+    mainViewHeight = mainViewRect.height;
   }
 
   imGuiLayer.endMainView(renderer.getSceneTexture());
   Camera& camera = activeCamera();
-  if (imGuiLayer.drawSidePanel(activeCameraMode, camera.speed))
+  double cameraHeight = 0.0;
+  const GeoCoords cameraCoords = ecefToGeo(camera.position, cameraHeight);
+  if (imGuiLayer.drawSidePanel(
+        activeCameraMode, camera.speed, tileManager.maxScreenSpaceError, cameraCoords, cameraHeight))
   {
     toggleCameraMode();
   }
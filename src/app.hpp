@@ -1,28 +1,53 @@
 #pragma once
 
+#include "adsb_receiver.hpp"
 #include "camera.hpp"
 #include "flight_boundary.hpp"
+#include "flight_log.hpp"
 #include "gpu/allocator.hpp"
 #include "gpu/renderer.hpp"
 #include "imgui_layer.hpp"
 #include "mesh_manager.hpp"
 #include "model.hpp"
 #include "no_fly_zones.hpp"
-#include "ros.hpp"
+#include "separation_monitor.hpp"
+#include "shared_telemetry.hpp"
+#include "telemetry_link.hpp"
 #include "texture_manager.hpp"
 #include "tile_manager.hpp"
+#include "traffic_manager.hpp"
+#include "trail_manager.hpp"
 #include "time.hpp"
+#include "vehicle_registry.hpp"
 #include "window.hpp"
 
 #include <entt/entt.hpp>
 #include <glm/glm.hpp>
 
+#include <filesystem>
+#include <string>
+
 namespace flb
 {
+struct AppOptions
+{
+  // record live telemetry and camera state to this flight log
+  std::filesystem::path recordPath;
+  // replay this flight log instead of receiving live telemetry
+  std::filesystem::path replayPath;
+  double replaySpeed = 1.0;
+  // host:port of an SBS-1 feed, such as port 30003 of dump1090, empty to show no ADS-B traffic
+  std::string adsbAddress;
+  // shared memory telemetry ring written by a simulator on this host, read alongside the telemetry link
+  std::string sharedTelemetryName;
+  // split vehicle meshes too large for 16-bit indices into meshlets instead of drawing them with 32-bit indices
+  bool useMeshlets = false;
+};
+
 class App
 {
 public:
-  SDL_AppResult init();
+  SDL_AppResult init(const AppOptions& options);
   void cleanup();
   SDL_AppResult handleEvent(SDL_Event* event);
   SDL_AppResult update(float dt);
@@ -36,6 +61,9 @@ private:
   bool isPerspectiveCameraActive() const;
   void setCameraAspect(float aspect);
   void toggleCameraMode();
+  CameraState getCameraState() const;
+  void applyCameraState(const CameraState& state);
+  void handleReplayKey(SDL_Keycode key);
 
   Window window;
   Renderer renderer;
@@ -49,14 +77,27 @@ private:
   PerspectiveCamera perspectiveCamera;
   OrthographicCamera orthographicCamera;
   bool cameraMouseLook = false;
+  // height in pixels of the main view as last drawn, zero until the first frame is drawn
+  float mainViewHeight = 0.0f;
   entt::registry registry;
 
-  ROS ros;
+  TelemetryLink telemetryLink;
+  SharedTelemetryReader sharedTelemetry;
+  ADSBReceiver adsbReceiver;
+  VehicleRegistry vehicleRegistry;
+  FlightRecorder flightRecorder;
+  FlightReplay flightReplay;
+  double replaySpeed = 1.0;
+  bool replayPaused = false;
+  bool followReplayCamera = true;
 
   TextureManager textureManager;
   MeshManager meshManager;
   TileManager tileManager;
+  TrailManager trailManager;
   FlightBoundary flightBoundary;
   NoFlyZones noFlyZones;
+  SeparationMonitor separationMonitor;
+  TrafficManager trafficManager;
 };
 } // namespace flb
@@ -86,6 +86,10 @@ public:
   virtual glm::vec3 getFront() const = 0;
   virtual glm::vec3 getRight() const = 0;
   virtual Frustum createFrustum() const = 0;
+  /**
+   * Share of half the viewport height covered by one meter at the given distance from the camera.
+   */
+  virtual double getScreenScale(double distance) const = 0;
 
   virtual glm::vec3 getViewUp() const { return up; }
 
@@ -202,6 +206,12 @@ public:
 
   glm::vec3 getRight() const override { return glm::normalize(glm::cross(getFront(), up)); }
 
+  double getScreenScale(double distance) const override
+  {
+    const double halfFovTangent = glm::tan(glm::radians(static_cast<double>(fov)) * 0.5);
+    return 1.0 / (glm::max(distance, static_cast<double>(near)) * halfFovTangent);
+  }
+
   Frustum createFrustum() const override
   {
     // 1. Compute orthogonal camera local axes
@@ -328,6 +338,8 @@ public:
 
   glm::vec3 getViewUp() const override { return getSurfaceForward(); }
 
+  double getScreenScale(double) const override { return 1.0 / static_cast<double>(getOrthographicHalfHeight()); }
+
   float getOrthographicHalfHeight() const { return orthographicHeight * 0.5f; }
   float getOrthographicHalfWidth() const { return getOrthographicHalfHeight() * aspect; }
 
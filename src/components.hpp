@@ -2,11 +2,17 @@
 
 #include "indicator_model.hpp"
 #include "model.hpp"
+#include "telemetry.hpp"
 #include "texture_manager.hpp"
+#include "vehicle_state_estimator.hpp"
+#include "vehicle_trail.hpp"
 
 #include <SDL3/SDL_gpu.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
+#include <limits>
+
 #include "culling.hpp"
 
 namespace flb
@@ -36,6 +42,14 @@ struct Position
   glm::dvec3 value;
 };
 
+/**
+ * ECEF velocity in meters per second.
+ */
+struct Velocity
+{
+  glm::dvec3 value;
+};
+
 struct Transform
 {
   glm::mat3 value{1.0f};
@@ -61,6 +75,18 @@ struct IndicatorModel
   flb::IndicatorModel value;
 };
 
+/**
+ * Copies of an indicator drawn with a single instanced draw, see TrafficManager. The first count instances of the
+ * buffer are drawn, their positions are relative to origin.
+ */
+struct IndicatorInstances
+{
+  flb::IndicatorModel indicator;
+  gpu::BufferHandle instanceBuffer{};
+  glm::dvec3 origin{0.0};
+  Uint32 count = 0;
+};
+
 struct Visible
 {
 };
@@ -75,5 +101,83 @@ struct HorizonCullingPoint
   glm::dvec3 value;
 };
 
+struct Vehicle
+{
+  VehicleID id;
+};
+
+/**
+ * An aircraft known from the ADS-B feed, see TrafficManager.
+ */
+struct Traffic
+{
+  // 24-bit ICAO address, with TrafficReport::NON_ICAO_ADDRESS set for other kinds of addresses
+  std::uint32_t address;
+};
+
+struct VehicleEstimator
+{
+  VehicleStateEstimator value;
+};
+
+struct Trail
+{
+  VehicleTrail value;
+};
+
+/**
+ * Where a vehicle stands relative to the no-fly zones, see NoFlyZones.
+ */
+struct NoFlyZoneStatus
+{
+  static constexpr std::uint32_t NO_ZONE = std::numeric_limits<std::uint32_t>::max();
+
+  // zone the vehicle is inside
+  std::uint32_t zone = NO_ZONE;
+  // first zone the vehicle enters on its current course, same as zone while inside one
+  std::uint32_t nextZone = NO_ZONE;
+  // seconds until the vehicle enters nextZone, infinity if it doesn't
+  double timeToViolation = std::numeric_limits<double>::infinity();
+};
+
+/**
+ * Where a vehicle stands relative to the flight boundary, see FlightBoundary.
+ */
+struct BoundaryStatus
+{
+  enum class Alert
+  {
+    None,
+    Warning,
+    Violation,
+  };
+
+  // horizontal distance to the nearest boundary edge, positive inside the boundary
+  double signedDistance = 0.0;
+  Alert alert = Alert::None;
+};
+
+/**
+ * The most urgent conflict of a vehicle with another one, see SeparationMonitor.
+ */
+struct SeparationStatus
+{
+  enum class Alert
+  {
+    None,
+    Warning,
+    Violation,
+  };
+
+  static constexpr VehicleID NO_VEHICLE = std::numeric_limits<VehicleID>::max();
+
+  VehicleID other = NO_VEHICLE;
+  // seconds until the closest point of approach with other, zero once the vehicles are moving apart
+  double timeToClosestApproach = std::numeric_limits<double>::infinity();
+  // distance between the vehicles at the closest point of approach
+  double closestDistance = std::numeric_limits<double>::infinity();
+  Alert alert = Alert::None;
+};
+
 } // namespace component
 } // namespace flb
@@ -0,0 +1,215 @@
+#include "cylinder_grid.hpp"
+
+#include "math.hpp"
+
+#include <algorithm>
+
+namespace flb
+{
+namespace
+{
+constexpr double Infinity = std::numeric_limits<double>::infinity();
+
+/**
+ * Times at which offset + velocity * t lies within the given radius around the origin.
+ */
+Interval getDiscInterval(glm::dvec2 offset, glm::dvec2 velocity, double radius)
+{
+  const double a = glm::dot(velocity, velocity);
+  const double b = 2.0 * glm::dot(offset, velocity);
+  const double c = glm::dot(offset, offset) - radius * radius;
+  if (a < 1e-12)
+  {
+    return c <= 0.0 ? Interval{-Infinity, Infinity} : Interval{Infinity, -Infinity};
+  }
+
+  const double discriminant = b * b - 4.0 * a * c;
+  if (discriminant < 0.0)
+  {
+    return {Infinity, -Infinity};
+  }
+
+  const double root = glm::sqrt(discriminant);
+  return {(-b - root) / (2.0 * a), (-b + root) / (2.0 * a)};
+}
+} // namespace
+
+void CylinderGrid::build(std::span<const Cylinder> cylinders)
+{
+  clear();
+  if (cylinders.empty())
+  {
+    return;
+  }
+
+  const std::size_t count = cylinders.size();
+  centerX.reserve(count);
+  centerY.reserve(count);
+  radius.reserve(count);
+  bottom.reserve(count);
+  top.reserve(count);
+
+  glm::dvec2 boundsMin{Infinity};
+  glm::dvec2 boundsMax{-Infinity};
+  double radiusSum = 0.0;
+  for (const Cylinder& cylinder : cylinders)
+  {
+    centerX.push_back(cylinder.center.x);
+    centerY.push_back(cylinder.center.y);
+    radius.push_back(cylinder.radius);
+    bottom.push_back(cylinder.bottom);
+    top.push_back(cylinder.top);
+
+    boundsMin = glm::min(boundsMin, cylinder.center - cylinder.radius);
+    boundsMax = glm::max(boundsMax, cylinder.center + cylinder.radius);
+    radiusSum += cylinder.radius;
+  }
+
+  // Cells about the size of an average cylinder keep both the cell lists and the number of cells per query short.
+  const glm::dvec2 extent = boundsMax - boundsMin;
+  double cellSize = glm::max(2.0 * radiusSum / static_cast<double>(count), 1.0);
+  cellSize = glm::max(cellSize, glm::max(extent.x, extent.y) / MAX_CELLS_PER_AXIS);
+
+  gridMin = boundsMin;
+  inverseCellSize = 1.0 / cellSize;
+  cellsX = glm::clamp(static_cast<std::uint32_t>(glm::ceil(extent.x * inverseCellSize)), 1u, MAX_CELLS_PER_AXIS);
+  cellsY = glm::clamp(static_cast<std::uint32_t>(glm::ceil(extent.y * inverseCellSize)), 1u, MAX_CELLS_PER_AXIS);
+
+  // counting sort of the cylinders into the cells they overlap
+  std::vector<CellRange> ranges(count);
+  firstCellX.resize(count);
+  firstCellY.resize(count);
+  cellStart.assign(static_cast<std::size_t>(cellsX) * cellsY + 1, 0);
+  for (std::uint32_t i = 0; i < count; ++i)
+  {
+    const glm::dvec2 center{centerX[i], centerY[i]};
+    getCellRange(center - radius[i], center + radius[i], ranges[i]);
+    firstCellX[i] = ranges[i].minX;
+    firstCellY[i] = ranges[i].minY;
+
+    for (std::uint32_t y = ranges[i].minY; y <= ranges[i].maxY; ++y)
+    {
+      for (std::uint32_t x = ranges[i].minX; x <= ranges[i].maxX; ++x)
+      {
+        ++cellStart[y * cellsX + x + 1];
+      }
+    }
+  }
+
+  for (std::size_t cell = 1; cell < cellStart.size(); ++cell)
+  {
+    cellStart[cell] += cellStart[cell - 1];
+  }
+
+  cellItems.resize(cellStart.back());
+  std::vector<std::uint32_t> cursors(cellStart.begin(), cellStart.end() - 1);
+  for (std::uint32_t i = 0; i < count; ++i)
+  {
+    for (std::uint32_t y = ranges[i].minY; y <= ranges[i].maxY; ++y)
+    {
+      for (std::uint32_t x = ranges[i].minX; x <= ranges[i].maxX; ++x)
+      {
+        cellItems[cursors[y * cellsX + x]++] = i;
+      }
+    }
+  }
+}
+
+void CylinderGrid::clear()
+{
+  centerX.clear();
+  centerY.clear();
+  radius.clear();
+  bottom.clear();
+  top.clear();
+  firstCellX.clear();
+  firstCellY.clear();
+  cellStart.clear();
+  cellItems.clear();
+  cellsX = 0;
+  cellsY = 0;
+}
+
+void CylinderGrid::query(
+  std::span<const glm::dvec3> positions,
+  std::span<const glm::dvec3> velocities,
+  double horizon,
+  std::span<Hit> outHits) const
+{
+  const std::size_t count = std::min(positions.size(), outHits.size());
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const glm::dvec3 velocity = i < velocities.size() ? velocities[i] : glm::dvec3{0.0};
+    outHits[i] = empty() ? Hit{} : queryPoint(positions[i], velocity, horizon);
+  }
+}
+
+CylinderGrid::Hit CylinderGrid::queryPoint(const glm::dvec3& position, const glm::dvec3& velocity, double horizon) const
+{
+  Hit hit{};
+
+  const glm::dvec2 start{position};
+  const glm::dvec2 end = start + glm::dvec2{velocity} * horizon;
+  forEachCandidate(
+    glm::min(start, end),
+    glm::max(start, end),
+    [&](std::uint32_t index)
+    {
+      if (contains(index, position))
+      {
+        hit.containing = index;
+        hit.next = index;
+        hit.timeToEntry = 0.0;
+        return false;
+      }
+
+      const double entryTime = getEntryTime(index, position, velocity, horizon);
+      if (entryTime < hit.timeToEntry)
+      {
+        hit.next = index;
+        hit.timeToEntry = entryTime;
+      }
+      return true;
+    });
+
+  return hit;
+}
+
+bool CylinderGrid::getCellRange(glm::dvec2 min, glm::dvec2 max, CellRange& outRange) const
+{
+  const glm::dvec2 cellMin = glm::floor((min - gridMin) * inverseCellSize);
+  const glm::dvec2 cellMax = glm::floor((max - gridMin) * inverseCellSize);
+  if (cellMax.x < 0.0 || cellMax.y < 0.0 || cellMin.x >= cellsX || cellMin.y >= cellsY)
+  {
+    return false;
+  }
+
+  outRange = {
+    .minX = static_cast<std::uint32_t>(glm::max(cellMin.x, 0.0)),
+    .minY = static_cast<std::uint32_t>(glm::max(cellMin.y, 0.0)),
+    .maxX = static_cast<std::uint32_t>(glm::min(cellMax.x, cellsX - 1.0)),
+    .maxY = static_cast<std::uint32_t>(glm::min(cellMax.y, cellsY - 1.0)),
+  };
+  return true;
+}
+
+bool CylinderGrid::contains(std::uint32_t index, const glm::dvec3& position) const
+{
+  const double dx = position.x - centerX[index];
+  const double dy = position.y - centerY[index];
+  return dx * dx + dy * dy <= radius[index] * radius[index] && position.z >= bottom[index] && position.z <= top[index];
+}
+
+double CylinderGrid::getEntryTime(
+  std::uint32_t index, const glm::dvec3& position, const glm::dvec3& velocity, double horizon) const
+{
+  const glm::dvec2 offset{position.x - centerX[index], position.y - centerY[index]};
+  const Interval horizontal = getDiscInterval(offset, glm::dvec2{velocity}, radius[index]);
+  const Interval vertical = getSlabInterval(position.z, velocity.z, bottom[index], top[index]);
+
+  const double begin = glm::max(glm::max(horizontal.begin, vertical.begin), 0.0);
+  const double end = glm::min(glm::min(horizontal.end, vertical.end), horizon);
+  return begin <= end ? begin : Infinity;
+}
+
+} // namespace flb
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace flb
+{
+
+/**
+ * Spatial index over vertical cylinders in a local ENU frame. Answers which cylinder a point is inside and how soon a
+ * point moving in a straight line enters one.
+ *
+ * Cylinders are bucketed into a uniform grid of square cells by their horizontal bounding box. All cell lists are
+ * stored back to back, cell i owns cellItems[cellStart[i], cellStart[i + 1]), and the cylinders themselves are kept as
+ * structure of arrays, so a query only walks a few contiguous arrays. A cylinder that overlaps several of the cells
+ * a query visits is only tested in the first of them, which avoids duplicate tests without per-query bookkeeping.
+ */
+class CylinderGrid
+{
+public:
+  static constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+  static constexpr std::uint32_t MAX_CELLS_PER_AXIS = 1024;
+
+  struct Cylinder
+  {
+    glm::dvec2 center;
+    double radius;
+    double bottom;
+    double top;
+  };
+
+  struct Hit
+  {
+    // cylinder containing the point, NONE if it is outside all of them
+    std::uint32_t containing = NONE;
+    // first cylinder the point enters within the horizon, same as containing if it is already inside one
+    std::uint32_t next = NONE;
+    // seconds until the point enters next, infinity if it doesn't enter any
+    double timeToEntry = std::numeric_limits<double>::infinity();
+  };
+
+  void build(std::span<const Cylinder> cylinders);
+  void clear();
+  bool empty() const { return radius.empty(); }
+  std::size_t size() const { return radius.size(); }
+
+  /**
+   * Runs the query for every position, the results are written to the same index of outHits. Points are assumed to
+   * keep their velocity for horizon seconds. velocities may be empty, then only containment is tested.
+   */
+  void query(
+    std::span<const glm::dvec3> positions,
+    std::span<const glm::dvec3> velocities,
+    double horizon,
+    std::span<Hit> outHits) const;
+
+  /**
+   * Calls func(index) once for every cylinder whose bounding box shares a cell with the box [min, max], which is a
+   * superset of the cylinders overlapping the box. Returning false from func ends the search.
+   */
+  template <typename Func>
+  void forEachCandidate(glm::dvec2 min, glm::dvec2 max, Func func) const
+  {
+    CellRange range{};
+    if (empty() || !getCellRange(min, max, range))
+    {
+      return;
+    }
+
+    for (std::uint32_t y = range.minY; y <= range.maxY; ++y)
+    {
+      for (std::uint32_t x = range.minX; x <= range.maxX; ++x)
+      {
+        const std::uint32_t cell = y * cellsX + x;
+        for (std::uint32_t item = cellStart[cell]; item < cellStart[cell + 1]; ++item)
+        {
+          // a cylinder spanning several cells of the range is only reported in the first of them
+          const std::uint32_t index = cellItems[item];
+          if (std::max(firstCellX[index], range.minX) != x || std::max(firstCellY[index], range.minY) != y)
+          {
+            continue;
+          }
+
+          if (!func(index))
+          {
+            return;
+          }
+        }
+      }
+    }
+  }
+
+private:
+  struct CellRange
+  {
+    std::uint32_t minX;
+    std::uint32_t minY;
+    std::uint32_t maxX;
+    std::uint32_t maxY;
+  };
+
+  Hit queryPoint(const glm::dvec3& position, const glm::dvec3& velocity, double horizon) const;
+  bool getCellRange(glm::dvec2 min, glm::dvec2 max, CellRange& outRange) const;
+  bool contains(std::uint32_t index, const glm::dvec3& position) const;
+  double getEntryTime(
+    std::uint32_t index, const glm::dvec3& position, const glm::dvec3& velocity, double horizon) const;
+
+  // cylinders, structure of arrays
+  std::vector<double> centerX;
+  std::vector<double> centerY;
+  std::vector<double> radius;
+  std::vector<double> bottom;
+  std::vector<double> top;
+  // first cell of each cylinder's bounding box, used to test every cylinder only once per query
+  std::vector<std::uint32_t> firstCellX;
+  std::vector<std::uint32_t> firstCellY;
+
+  glm::dvec2 gridMin{0.0};
+  double inverseCellSize = 1.0;
+  std::uint32_t cellsX = 0;
+  std::uint32_t cellsY = 0;
+  std::vector<std::uint32_t> cellStart;
+  std::vector<std::uint32_t> cellItems;
+};
+
+} // namespace flb
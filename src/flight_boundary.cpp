@@ -1,7 +1,9 @@
 #include "flight_boundary.hpp"
 
 #include "components.hpp"
-#include "indicator_model_loader.hpp"
+#include "geodesy.hpp"
+#include "merged_mesh_builder.hpp"
+#include "obj_loader.hpp"
 
 #include <SDL3/SDL.h>
 #include <glm/geometric.hpp>
@@ -18,20 +20,12 @@ constexpr float WallHeightMeters = 200.0f;
 constexpr float WallThicknessMeters = 20.0f;
 const glm::vec4 BoundaryWallColor{1.0f, 0.8f, 0.0f, 0.35f};
 
-GeoCoords midpoint(const GeoCoords& a, const GeoCoords& b)
-{
-  return {
-    .latitude = (a.latitude + b.latitude) * 0.5,
-    .longitude = (a.longitude + b.longitude) * 0.5,
-  };
-}
-
 bool createWallPlacement(const GeoCoords& start, const GeoCoords& end, glm::dvec3& outPosition, glm::mat3& outTransform)
 {
   const glm::dvec3 startEcef = geoToECEF(start);
   const glm::dvec3 endEcef = geoToECEF(end);
-  const GeoCoords centerGeo = midpoint(start, end);
-  const glm::dvec3 up = glm::normalize(glm::dvec3{getSurfaceNormal(centerGeo)});
+  // up at the middle of the edge on the ellipsoid, averaging the coordinates would break edges across the antimeridian
+  const glm::dvec3 up{getSurfaceNormal(projectToEllipsoidSurface((startEcef + endEcef) * 0.5))};
 
   const glm::dvec3 edge = endEcef - startEcef;
   const glm::dvec3 projectedEdge = edge - up * glm::dot(edge, up);
@@ -72,13 +66,27 @@ SDL_AppResult FlightBoundary::init(
     return SDL_APP_FAILURE;
   }
 
-  const IndicatorModel wallModel = loadIndicatorModel(meshManager, cubePath, BoundaryWallColor, "flight boundary wall");
-  if (!wallModel.isValid())
+  const auto [cubeVertices, cubeIndices] = loadOBJ(cubePath);
+  if (cubeVertices.empty() || cubeIndices.empty())
   {
+    SDL_Log("Failed to load flight boundary wall mesh %s", cubePath.string().c_str());
     return SDL_APP_FAILURE;
   }
 
-  wallEntities.reserve(points.size());
+  std::vector<ECEFCoords> groundPoints(points.size());
+  geoToECEF(points, groundPoints);
+  frame = makeENUFrame(groundPoints);
+
+  std::vector<glm::dvec2> ring;
+  ring.reserve(points.size());
+  for (const ECEFCoords& point : groundPoints)
+  {
+    ring.emplace_back(frame.toENU(point));
+  }
+  boundaryGrid.build(ring);
+
+  // all walls are baked into one mesh around the frame origin, drawing them doesn't depend on the edge count
+  MergedMeshBuilder meshBuilder(meshManager);
   for (std::size_t i = 0; i < points.size(); ++i)
   {
     const GeoCoords& start = points[i];
@@ -92,10 +100,15 @@ SDL_AppResult FlightBoundary::init(
       continue;
     }
 
+    meshBuilder.addMesh(cubeVertices, cubeIndices, transform, glm::vec3{position - frame.origin});
+  }
+
+  const MeshHandle meshHandle = meshBuilder.finish();
+  if (meshHandle.isValid())
+  {
     const entt::entity wall = registry.create();
-    registry.emplace<component::Position>(wall, position);
-    registry.emplace<component::Transform>(wall, transform);
-    registry.emplace<component::IndicatorModel>(wall, wallModel);
+    registry.emplace<component::Position>(wall, frame.origin);
+    registry.emplace<component::IndicatorModel>(wall, IndicatorModel{&meshManager, meshHandle, BoundaryWallColor});
     wallEntities.push_back(wall);
   }
 
@@ -112,6 +125,56 @@ void FlightBoundary::clear(entt::registry& registry)
     }
   }
   wallEntities.clear();
+  boundaryGrid.clear();
+  registry.clear<component::BoundaryStatus>();
+}
+
+void FlightBoundary::update(entt::registry& registry)
+{
+  if (boundaryGrid.empty())
+  {
+    return;
+  }
+
+  queryEntities.clear();
+  queryPoints.clear();
+
+  const auto view = registry.view<component::Vehicle, component::Position>();
+  for (const auto [entity, vehicle, position] : view.each())
+  {
+    queryEntities.push_back(entity);
+    queryPoints.emplace_back(frame.toENU(position.value));
+  }
+
+  queryDistances.resize(queryEntities.size());
+  boundaryGrid.query(queryPoints, queryDistances);
+
+  for (std::size_t i = 0; i < queryEntities.size(); ++i)
+  {
+    using Alert = component::BoundaryStatus::Alert;
+
+    const double distance = queryDistances[i];
+    const Alert alert = distance < 0.0                ? Alert::Violation
+                        : distance < WARNING_DISTANCE ? Alert::Warning
+                                                      : Alert::None;
+
+    auto& status = registry.get_or_emplace<component::BoundaryStatus>(queryEntities[i]);
+    if (alert > status.alert)
+    {
+      const VehicleID id = registry.get<component::Vehicle>(queryEntities[i]).id;
+      if (alert == Alert::Violation)
+      {
+        SDL_Log("Vehicle %u left the flight boundary, %.1f m outside", id, -distance);
+      }
+      else
+      {
+        SDL_Log("Vehicle %u is %.1f m from the flight boundary", id, distance);
+      }
+    }
+
+    status.signedDistance = distance;
+    status.alert = alert;
+  }
 }
 
 std::vector<GeoCoords> FlightBoundary::parseBoundaryFile(const std::filesystem::path& boundaryPath)
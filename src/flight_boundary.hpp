@@ -2,6 +2,7 @@
 
 #include "math.hpp"
 #include "mesh_manager.hpp"
+#include "polygon_grid.hpp"
 
 #include <SDL3/SDL_init.h>
 #include <entt/entt.hpp>
@@ -12,9 +13,18 @@
 namespace flb
 {
 
+/**
+ * Loads the flight boundary polygon, bakes its walls into one merged mesh and checks every vehicle against it.
+ *
+ * The polygon is indexed in an ENU frame on the ellipsoid under the centroid of its points. update() gives every
+ * vehicle a component::BoundaryStatus with its signed horizontal distance to the boundary and raises an alert when the
+ * vehicle gets within WARNING_DISTANCE of the boundary or leaves it.
+ */
 class FlightBoundary
 {
 public:
+  static constexpr double WARNING_DISTANCE = 50.0;
+
   SDL_AppResult init(
     entt::registry& registry,
     MeshManager& meshManager,
@@ -23,10 +33,20 @@ public:
 
   void clear(entt::registry& registry);
 
+  void update(entt::registry& registry);
+
 private:
   static std::vector<GeoCoords> parseBoundaryFile(const std::filesystem::path& boundaryPath);
 
   std::vector<entt::entity> wallEntities;
+
+  ENUFrame frame;
+  PolygonGrid boundaryGrid;
+
+  // per-update scratch buffers
+  std::vector<entt::entity> queryEntities;
+  std::vector<glm::dvec2> queryPoints;
+  std::vector<double> queryDistances;
 };
 
 } // namespace flb
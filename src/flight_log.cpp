@@ -0,0 +1,307 @@
+#include "flight_log.hpp"
+
+#include <SDL3/SDL.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace flb
+{
+
+bool FlightRecorder::open(const std::filesystem::path& path, TimePoint startTime)
+{
+  close();
+
+  file.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+  if (!file.is_open())
+  {
+    SDL_Log("Failed to open flight log for writing: %s", path.string().c_str());
+    return false;
+  }
+
+  flightlog::FileHeader header{};
+  std::memcpy(header.magic, flightlog::FILE_MAGIC, sizeof(header.magic));
+  header.version = flightlog::FILE_VERSION;
+  header.recordSize = sizeof(flightlog::Record);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  this->startTime = startTime;
+  lastCameraTime = -CAMERA_INTERVAL;
+  lastFlushedTime = 0.0;
+  pendingRecords.clear();
+  pendingRecords.reserve(RECORDS_PER_CHUNK);
+  compressedBuffer.resize(compressBound(RECORDS_PER_CHUNK * sizeof(flightlog::Record)));
+
+  SDL_Log("Recording flight log to %s", path.string().c_str());
+  return true;
+}
+
+void FlightRecorder::close()
+{
+  if (!file.is_open())
+  {
+    return;
+  }
+
+  flush();
+  file.close();
+}
+
+void FlightRecorder::recordTelemetry(const TelemetrySample& sample)
+{
+  if (!file.is_open())
+  {
+    return;
+  }
+
+  flightlog::Record record{};
+  record.type = flightlog::RecordType::Telemetry;
+  // samples drained right after opening may have been received before it
+  record.time = sample.receivedAt > startTime ? toSeconds(sample.receivedAt - startTime) : 0.0;
+  record.telemetry = {
+    .vehicleId = sample.vehicleId,
+    .reserved = 0,
+    .sourceTimestampUs = sample.sourceTimestampUs,
+    .latitude = sample.latitude,
+    .longitude = sample.longitude,
+    .altitude = sample.altitude,
+  };
+  append(record);
+}
+
+void FlightRecorder::recordCamera(const CameraState& camera, TimePoint frameTime)
+{
+  if (!file.is_open())
+  {
+    return;
+  }
+
+  const double time = toSeconds(frameTime - startTime);
+  if (time - lastCameraTime < CAMERA_INTERVAL)
+  {
+    return;
+  }
+  lastCameraTime = time;
+
+  flightlog::Record record{};
+  record.type = flightlog::RecordType::Camera;
+  record.time = time;
+  record.camera = {
+    .position = {camera.position.x, camera.position.y, camera.position.z},
+    .up = {camera.up.x, camera.up.y, camera.up.z},
+    .yaw = camera.yaw,
+    .pitch = camera.pitch,
+    .fov = camera.fov,
+    .orthographicHeight = camera.orthographicHeight,
+    .mode = camera.mode,
+    .orthographicAltitude = camera.orthographicAltitude,
+  };
+  append(record);
+}
+
+void FlightRecorder::append(const flightlog::Record& record)
+{
+  pendingRecords.push_back(record);
+  // a sample received before the previous chunk was written but drained after it is moved up to that chunk's end,
+  // chunks never overlap in time
+  pendingRecords.back().time = std::max(record.time, lastFlushedTime);
+
+  if (pendingRecords.size() == RECORDS_PER_CHUNK || record.time - pendingRecords.front().time >= FLUSH_INTERVAL)
+  {
+    flush();
+  }
+}
+
+void FlightRecorder::flush()
+{
+  if (pendingRecords.empty())
+  {
+    return;
+  }
+
+  // Telemetry is stamped when it is received on its own thread and camera states when the frame started, so records
+  // arrive a frame out of order. They are sorted here, seeking relies on each chunk being in time order.
+  std::stable_sort(
+    pendingRecords.begin(),
+    pendingRecords.end(),
+    [](const flightlog::Record& a, const flightlog::Record& b) { return a.time < b.time; });
+
+  const uLong sourceSize = static_cast<uLong>(pendingRecords.size() * sizeof(flightlog::Record));
+  uLongf compressedSize = static_cast<uLongf>(compressedBuffer.size());
+  const int result = compress2(
+    reinterpret_cast<Bytef*>(compressedBuffer.data()),
+    &compressedSize,
+    reinterpret_cast<const Bytef*>(pendingRecords.data()),
+    sourceSize,
+    Z_BEST_SPEED);
+  if (result != Z_OK)
+  {
+    SDL_Log("Failed to compress flight log chunk: %d", result);
+    pendingRecords.clear();
+    return;
+  }
+
+  const flightlog::ChunkHeader header{
+    .magic = flightlog::CHUNK_MAGIC,
+    .compressedSize = static_cast<std::uint32_t>(compressedSize),
+    .recordCount = static_cast<std::uint32_t>(pendingRecords.size()),
+    .reserved = 0,
+    .firstTime = pendingRecords.front().time,
+    .lastTime = pendingRecords.back().time,
+  };
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(compressedBuffer.data()), static_cast<std::streamsize>(compressedSize));
+  file.flush();
+
+  lastFlushedTime = header.lastTime;
+  pendingRecords.clear();
+}
+
+bool FlightReplay::open(const std::filesystem::path& path)
+{
+  file.open(path, std::ios::binary | std::ios::in);
+  if (!file.is_open())
+  {
+    SDL_Log("Failed to open flight log: %s", path.string().c_str());
+    return false;
+  }
+
+  flightlog::FileHeader header{};
+  if (
+    !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+    std::memcmp(header.magic, flightlog::FILE_MAGIC, sizeof(header.magic)) != 0 ||
+    header.version != flightlog::FILE_VERSION || header.recordSize != sizeof(flightlog::Record))
+  {
+    SDL_Log("Invalid flight log: %s", path.string().c_str());
+    file.close();
+    return false;
+  }
+
+  // Build the time index from the chunk headers, payloads are skipped without being read.
+  chunks.clear();
+  while (true)
+  {
+    ChunkIndexEntry entry{};
+    entry.offset = file.tellg();
+    if (!file.read(reinterpret_cast<char*>(&entry.header), sizeof(entry.header)))
+    {
+      break;
+    }
+
+    if (entry.header.magic != flightlog::CHUNK_MAGIC)
+    {
+      SDL_Log("Corrupted flight log chunk at offset %lld", static_cast<long long>(entry.offset));
+      break;
+    }
+
+    file.seekg(entry.header.compressedSize, std::ios::cur);
+    if (!file || file.tellg() < entry.offset + static_cast<std::streamoff>(sizeof(entry.header)))
+    {
+      break;
+    }
+
+    chunks.push_back(entry);
+  }
+  file.clear();
+
+  SDL_Log(
+    "Opened flight log %s, %zu chunks, %.1f seconds",
+    path.string().c_str(),
+    chunks.size(),
+    getEndTime() - getStartTime());
+
+  records.clear();
+  nextChunk = 0;
+  nextRecord = 0;
+  currentTime = getStartTime();
+  return true;
+}
+
+void FlightReplay::seek(double time)
+{
+  currentTime = time;
+
+  // first chunk that still has records at or after the target time
+  const auto chunk = std::partition_point(
+    chunks.begin(), chunks.end(), [time](const ChunkIndexEntry& entry) { return entry.header.lastTime < time; });
+
+  records.clear();
+  nextRecord = 0;
+  nextChunk = static_cast<std::size_t>(chunk - chunks.begin());
+  if (!loadChunk(nextChunk))
+  {
+    return;
+  }
+
+  const auto record = std::partition_point(
+    records.begin(), records.end(), [time](const flightlog::Record& entry) { return entry.time < time; });
+  nextRecord = static_cast<std::size_t>(record - records.begin());
+}
+
+bool FlightReplay::loadChunk(std::size_t index)
+{
+  if (index >= chunks.size())
+  {
+    return false;
+  }
+
+  const ChunkIndexEntry& entry = chunks[index];
+  nextChunk = index + 1;
+  nextRecord = 0;
+  records.resize(entry.header.recordCount);
+  compressedBuffer.resize(entry.header.compressedSize);
+
+  file.clear();
+  file.seekg(entry.offset + static_cast<std::streamoff>(sizeof(flightlog::ChunkHeader)));
+  if (!file.read(reinterpret_cast<char*>(compressedBuffer.data()), entry.header.compressedSize))
+  {
+    SDL_Log("Failed to read flight log chunk %zu", index);
+    records.clear();
+    return false;
+  }
+
+  uLongf uncompressedSize = static_cast<uLongf>(records.size() * sizeof(flightlog::Record));
+  const int result = uncompress(
+    reinterpret_cast<Bytef*>(records.data()),
+    &uncompressedSize,
+    reinterpret_cast<const Bytef*>(compressedBuffer.data()),
+    static_cast<uLong>(compressedBuffer.size()));
+  if (result != Z_OK || uncompressedSize != records.size() * sizeof(flightlog::Record))
+  {
+    SDL_Log("Failed to decompress flight log chunk %zu: %d", index, result);
+    records.clear();
+    return false;
+  }
+
+  return true;
+}
+
+TelemetrySample FlightReplay::toSample(const flightlog::Record& record)
+{
+  return {
+    .vehicleId = record.telemetry.vehicleId,
+    .sourceTimestampUs = record.telemetry.sourceTimestampUs,
+    .receivedAt = toReplayTimePoint(record.time),
+    .latitude = record.telemetry.latitude,
+    .longitude = record.telemetry.longitude,
+    .altitude = record.telemetry.altitude,
+  };
+}
+
+CameraState FlightReplay::toCameraState(const flightlog::Record& record)
+{
+  const flightlog::CameraRecord& camera = record.camera;
+  return {
+    .position = {camera.position[0], camera.position[1], camera.position[2]},
+    .up = {camera.up[0], camera.up[1], camera.up[2]},
+    .yaw = camera.yaw,
+    .pitch = camera.pitch,
+    .fov = camera.fov,
+    .orthographicHeight = camera.orthographicHeight,
+    .orthographicAltitude = camera.orthographicAltitude,
+    .mode = camera.mode,
+  };
+}
+
+} // namespace flb
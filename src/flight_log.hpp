@@ -0,0 +1,224 @@
+#pragma once
+
+#include "telemetry.hpp"
+#include "time.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include <vector>
+
+namespace flb
+{
+
+/**
+ * Binary flight log format.
+ *
+ * A log is a FileHeader followed by any number of chunks. Every chunk is a ChunkHeader followed by compressedSize
+ * bytes of zlib data which inflate to recordCount fixed-size Records. Records are sorted by time within the log,
+ * time is in seconds since the start of the recording. The file is only ever appended to, a log cut short by a crash
+ * is readable up to its last complete chunk. The chunk headers double as the time index used for seeking.
+ */
+namespace flightlog
+{
+constexpr char FILE_MAGIC[8] = {'F', 'L', 'B', 'L', 'O', 'G', '\0', '\0'};
+constexpr std::uint32_t FILE_VERSION = 1;
+constexpr std::uint32_t CHUNK_MAGIC = 0x4B4E4843; // "CHNK"
+
+struct FileHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t recordSize;
+};
+
+struct ChunkHeader
+{
+  std::uint32_t magic;
+  std::uint32_t compressedSize;
+  std::uint32_t recordCount;
+  std::uint32_t reserved;
+  double firstTime;
+  double lastTime;
+};
+
+enum class RecordType : std::uint32_t
+{
+  Telemetry = 1,
+  Camera = 2,
+};
+
+struct TelemetryRecord
+{
+  VehicleID vehicleId;
+  std::uint32_t reserved;
+  std::uint64_t sourceTimestampUs;
+  double latitude;
+  double longitude;
+  double altitude;
+};
+
+struct CameraRecord
+{
+  double position[3];
+  float up[3];
+  float yaw;
+  float pitch;
+  float fov;
+  float orthographicHeight;
+  std::uint32_t mode;
+  double orthographicAltitude;
+};
+
+struct Record
+{
+  RecordType type;
+  std::uint32_t reserved;
+  double time;
+  union
+  {
+    TelemetryRecord telemetry;
+    CameraRecord camera;
+  };
+};
+
+static_assert(std::is_trivially_copyable_v<Record>);
+static_assert(sizeof(ChunkHeader) == 32);
+static_assert(sizeof(Record) == 80);
+} // namespace flightlog
+
+/**
+ * Camera pose as stored in the flight log. mode is a CameraMode value.
+ */
+struct CameraState
+{
+  glm::dvec3 position{0.0};
+  glm::vec3 up{0.0f, 0.0f, 1.0f};
+  float yaw = 0.0f;
+  float pitch = 0.0f;
+  float fov = 75.0f;
+  float orthographicHeight = 0.0f;
+  double orthographicAltitude = 0.0;
+  std::uint32_t mode = 0;
+};
+
+/**
+ * Streams telemetry samples and camera states to a flight log. Records are buffered into chunks which are compressed
+ * and appended once they are full or older than FLUSH_INTERVAL seconds.
+ */
+class FlightRecorder
+{
+public:
+  static constexpr std::size_t RECORDS_PER_CHUNK = 4096;
+  static constexpr double FLUSH_INTERVAL = 1.0;
+  static constexpr double CAMERA_INTERVAL = 0.1;
+
+  ~FlightRecorder() { close(); }
+
+  bool open(const std::filesystem::path& path, TimePoint startTime);
+  void close();
+  bool isOpen() const { return file.is_open(); }
+
+  void recordTelemetry(const TelemetrySample& sample);
+
+  /**
+   * Camera states are recorded at most every CAMERA_INTERVAL seconds, calling this every frame is fine.
+   */
+  void recordCamera(const CameraState& camera, TimePoint frameTime);
+
+private:
+  std::ofstream file;
+  TimePoint startTime = 0;
+  double lastCameraTime = -CAMERA_INTERVAL;
+  double lastFlushedTime = 0.0;
+
+  std::vector<flightlog::Record> pendingRecords;
+  std::vector<std::byte> compressedBuffer;
+
+  void append(const flightlog::Record& record);
+  void flush();
+};
+
+/**
+ * Plays a flight log back without a ROS runtime. Time only advances through advance() and seek(), so a replay driven
+ * with fixed time steps is fully deterministic.
+ *
+ * Telemetry samples are handed out with receivedAt set on the replay clock, getTime(), and should be fed through the
+ * same ingestion path as live samples.
+ */
+class FlightReplay
+{
+public:
+  bool open(const std::filesystem::path& path);
+  bool isOpen() const { return file.is_open(); }
+
+  double getStartTime() const { return chunks.empty() ? 0.0 : chunks.front().header.firstTime; }
+  double getEndTime() const { return chunks.empty() ? 0.0 : chunks.back().header.lastTime; }
+  double getTime() const { return currentTime; }
+  TimePoint getFrameTime() const { return toReplayTimePoint(currentTime); }
+
+  /**
+   * Advances the replay clock by the given amount of seconds and emits every record up to the new time, in order.
+   */
+  template <typename TelemetryFunc, typename CameraFunc>
+  void advance(double seconds, TelemetryFunc onTelemetry, CameraFunc onCamera)
+  {
+    currentTime += seconds;
+
+    while (true)
+    {
+      if (nextRecord == records.size() && !loadChunk(nextChunk))
+      {
+        return;
+      }
+
+      const flightlog::Record& record = records[nextRecord];
+      if (record.time > currentTime)
+      {
+        return;
+      }
+      ++nextRecord;
+
+      if (record.type == flightlog::RecordType::Telemetry)
+      {
+        onTelemetry(toSample(record));
+      }
+      else if (record.type == flightlog::RecordType::Camera)
+      {
+        onCamera(toCameraState(record));
+      }
+    }
+  }
+
+  /**
+   * Moves the replay clock to the given time. The next advance() continues with the first record at or after it.
+   */
+  void seek(double time);
+
+private:
+  struct ChunkIndexEntry
+  {
+    std::streamoff offset;
+    flightlog::ChunkHeader header;
+  };
+
+  std::ifstream file;
+  std::vector<ChunkIndexEntry> chunks;
+  std::vector<flightlog::Record> records;
+  std::vector<std::byte> compressedBuffer;
+  std::size_t nextChunk = 0;
+  std::size_t nextRecord = 0;
+  double currentTime = 0.0;
+
+  bool loadChunk(std::size_t index);
+
+  static TimePoint toReplayTimePoint(double time) { return fromSeconds(time > 0.0 ? time : 0.0); }
+  static TelemetrySample toSample(const flightlog::Record& record);
+  static CameraState toCameraState(const flightlog::Record& record);
+};
+
+} // namespace flb
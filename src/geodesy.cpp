@@ -0,0 +1,173 @@
+#include "geodesy.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+namespace flb
+{
+namespace
+{
+constexpr double Eccentricity2 = 1.0 - SEMI_MINOR_SQUARED / SEMI_MAJOR_SQUARED;
+constexpr double DegreesToRadians = PI / 180.0;
+// points converted together, small enough for the arrays of a block to stay in the L1 cache
+constexpr std::size_t BlockSize = 64;
+
+/**
+ * Radius of curvature in the prime vertical.
+ */
+double getPrimeVerticalRadius(double sinLat)
+{
+  return SEMI_MAJOR / std::sqrt(1.0 - Eccentricity2 * sinLat * sinLat);
+}
+
+/**
+ * Sine and cosine of atan(sinh(t)), the latitude at the Mercator coordinate t, from a single expm1 instead of atan,
+ * sinh, sin and cos. They are tanh(t) and 1 / cosh(t), expm1 keeps them accurate around the equator.
+ */
+void getMercatorLatitude(double t, double& sinLat, double& cosLat)
+{
+  const double m = std::expm1(t);
+  const double e = 1.0 + m;
+  const double denominator = e * e + 1.0;
+  sinLat = m * (2.0 + m) / denominator;
+  cosLat = 2.0 * e / denominator;
+}
+
+template <typename GetHeight>
+void convertGeoToECEF(std::span<const GeoCoords> geo, GetHeight getHeight, std::span<ECEFCoords> ecef)
+{
+  std::array<double, BlockSize> sinLat;
+  std::array<double, BlockSize> cosLat;
+  std::array<double, BlockSize> sinLon;
+  std::array<double, BlockSize> cosLon;
+  for (std::size_t first = 0; first < geo.size(); first += BlockSize)
+  {
+    const std::size_t count = std::min(BlockSize, geo.size() - first);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const double latitude = geo[first + i].latitude * DegreesToRadians;
+      sinLat[i] = std::sin(latitude);
+      cosLat[i] = std::cos(latitude);
+    }
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const double longitude = geo[first + i].longitude * DegreesToRadians;
+      sinLon[i] = std::sin(longitude);
+      cosLon[i] = std::cos(longitude);
+    }
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const double n = getPrimeVerticalRadius(sinLat[i]);
+      const double height = getHeight(first + i);
+      const double horizontal = (n + height) * cosLat[i];
+      ecef[first + i] = {
+        horizontal * cosLon[i],
+        horizontal * sinLon[i],
+        (n * (1.0 - Eccentricity2) + height) * sinLat[i],
+      };
+    }
+  }
+}
+} // namespace
+
+void geoToECEF(std::span<const GeoCoords> geo, std::span<ECEFCoords> ecef)
+{
+  convertGeoToECEF(geo, [](std::size_t) { return 0.0; }, ecef);
+}
+
+void geoToECEF(std::span<const GeoCoords> geo, double height, std::span<ECEFCoords> ecef)
+{
+  convertGeoToECEF(geo, [height](std::size_t) { return height; }, ecef);
+}
+
+void geoToECEF(std::span<const GeoCoords> geo, std::span<const double> heights, std::span<ECEFCoords> ecef)
+{
+  convertGeoToECEF(geo, [heights](std::size_t i) { return heights[i]; }, ecef);
+}
+
+void tileToECEF(std::uint32_t zoom, std::span<const glm::dvec2> tileCoords, std::span<ECEFCoords> ecef)
+{
+  const double tileAngle = 2.0 * PI / std::exp2(static_cast<double>(zoom));
+
+  std::array<double, BlockSize> horizontal;
+  std::array<double, BlockSize> vertical;
+  std::array<double, BlockSize> longitude;
+  for (std::size_t first = 0; first < tileCoords.size(); first += BlockSize)
+  {
+    const std::size_t count = std::min(BlockSize, tileCoords.size() - first);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      double sinLat = 0.0;
+      double cosLat = 0.0;
+      getMercatorLatitude(PI - tileCoords[first + i].y * tileAngle, sinLat, cosLat);
+      const double n = getPrimeVerticalRadius(sinLat);
+      horizontal[i] = n * cosLat;
+      vertical[i] = n * (1.0 - Eccentricity2) * sinLat;
+    }
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      longitude[i] = tileCoords[first + i].x * tileAngle - PI;
+    }
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      ecef[first + i] = {
+        horizontal[i] * std::cos(longitude[i]),
+        horizontal[i] * std::sin(longitude[i]),
+        vertical[i],
+      };
+    }
+  }
+}
+
+void tileGridToECEF(
+  std::uint32_t zoom, std::span<const double> tileX, std::span<const double> tileY, std::span<ECEFCoords> ecef)
+{
+  const double tileAngle = 2.0 * PI / std::exp2(static_cast<double>(zoom));
+  const std::size_t columnCount = tileX.size();
+
+  std::array<double, BlockSize> sinLon;
+  std::array<double, BlockSize> cosLon;
+  for (std::size_t firstColumn = 0; firstColumn < columnCount; firstColumn += BlockSize)
+  {
+    const std::size_t count = std::min(BlockSize, columnCount - firstColumn);
+    for (std::size_t j = 0; j < count; ++j)
+    {
+      const double longitude = tileX[firstColumn + j] * tileAngle - PI;
+      sinLon[j] = std::sin(longitude);
+      cosLon[j] = std::cos(longitude);
+    }
+
+    for (std::size_t i = 0; i < tileY.size(); ++i)
+    {
+      double sinLat = 0.0;
+      double cosLat = 0.0;
+      getMercatorLatitude(PI - tileY[i] * tileAngle, sinLat, cosLat);
+      const double n = getPrimeVerticalRadius(sinLat);
+      const double horizontal = n * cosLat;
+      const double vertical = n * (1.0 - Eccentricity2) * sinLat;
+
+      ECEFCoords* row = ecef.data() + i * columnCount + firstColumn;
+      for (std::size_t j = 0; j < count; ++j)
+      {
+        row[j] = {horizontal * cosLon[j], horizontal * sinLon[j], vertical};
+      }
+    }
+  }
+}
+
+void ecefToGeo(std::span<const ECEFCoords> ecef, std::span<GeoCoords> geo, std::span<double> heights)
+{
+  double height = 0.0;
+  for (std::size_t i = 0; i < ecef.size(); ++i)
+  {
+    geo[i] = ecefToGeo(ecef[i], height);
+    if (!heights.empty())
+    {
+      heights[i] = height;
+    }
+  }
+}
+
+} // namespace flb
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "math.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+
+namespace flb
+{
+
+/**
+ * Batched versions of the conversions in math.hpp for many points at once. Each output has to be at least as large as
+ * the input, the results match the scalar versions to within a few nanometers.
+ *
+ * Points are converted in small blocks whose angles, sines and cosines are kept in plain arrays and computed in
+ * branch-free loops the compiler can vectorize. Grids of tile coordinates are converted separably, the latitude terms
+ * once per row and the longitude terms once per column.
+ */
+void geoToECEF(std::span<const GeoCoords> geo, std::span<ECEFCoords> ecef);
+void geoToECEF(std::span<const GeoCoords> geo, double height, std::span<ECEFCoords> ecef);
+void geoToECEF(std::span<const GeoCoords> geo, std::span<const double> heights, std::span<ECEFCoords> ecef);
+
+/**
+ * Converts fractional tile coordinates at the zoom level to points on the ellipsoid.
+ */
+void tileToECEF(std::uint32_t zoom, std::span<const glm::dvec2> tileCoords, std::span<ECEFCoords> ecef);
+
+/**
+ * Converts the grid of fractional tile coordinates tileX by tileY at the zoom level to points on the ellipsoid, row by
+ * row, so ecef[i * tileX.size() + j] is the point at (tileX[j], tileY[i]).
+ */
+void tileGridToECEF(
+  std::uint32_t zoom, std::span<const double> tileX, std::span<const double> tileY, std::span<ECEFCoords> ecef);
+
+/**
+ * Converts ECEF positions to geographic coordinates in degrees and, when heights isn't empty, heights above the
+ * ellipsoid, see the scalar ecefToGeo() for the method and its range.
+ */
+void ecefToGeo(std::span<const ECEFCoords> ecef, std::span<GeoCoords> geo, std::span<double> heights = {});
+
+} // namespace flb
@@ -41,12 +41,24 @@ public:
 
   std::span<std::byte> allocateBuffer(BufferHandle destinationBuffer)
   {
+    return allocateBufferRegion(destinationBuffer, 0, destinationBuffer.size);
+  }
+
+  /**
+   * Allocates upload memory for only [offset, offset + size) of the destination buffer, the rest of the buffer keeps
+   * its contents. Used for buffers that are updated incrementally.
+   */
+  std::span<std::byte> allocateBufferRegion(BufferHandle destinationBuffer, Uint32 offset, Uint32 size)
+  {
+    if (size == 0 || offset + size > destinationBuffer.size)
+      return {};
+
     Uint32 allocOffset = 0;
-    auto span = allocateRaw(destinationBuffer.size, allocOffset);
+    auto span = allocateRaw(size, allocOffset);
     if (span.empty())
       return {};
 
-    pendingBufferCopies.emplace_back(destinationBuffer, activeChunkIndex, allocOffset);
+    pendingBufferCopies.emplace_back(destinationBuffer, offset, size, activeChunkIndex, allocOffset);
 
     return span;
   }
@@ -84,8 +96,8 @@ public:
       };
       SDL_GPUBufferRegion destination{
         .buffer = copy.destinationBuffer.buffer,
-        .offset = 0,
-        .size = copy.destinationBuffer.size,
+        .offset = copy.destinationOffset,
+        .size = copy.size,
       };
 
       SDL_UploadToGPUBuffer(copyPass, &source, &destination, false);
@@ -227,6 +239,8 @@ private:
   struct PendingBufferCopy
   {
     BufferHandle destinationBuffer;
+    Uint32 destinationOffset;
+    Uint32 size;
     std::size_t transferChunkIndex;
     Uint32 offsetInTransferBuffer;
   };
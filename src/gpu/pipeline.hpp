@@ -6,6 +6,7 @@
 #include <SDL3/SDL_gpu.h>
 #include <SDL3_shadercross/SDL_shadercross.h>
 #include <glm/glm.hpp>
+#include <limits>
 #include <string>
 
 // Helpers
@@ -68,11 +69,40 @@ struct Vertex
   glm::vec2 uv;
 };
 using Index = Uint16;
+// indices of meshes with more vertices than Index can address
+using WideIndex = Uint32;
+constexpr std::size_t MAX_INDEXED_VERTICES = std::numeric_limits<Index>::max() + std::size_t{1};
+
+/**
+ * Position-only vertex used for line geometry such as vehicle trails.
+ */
+struct LineVertex
+{
+  glm::vec3 position;
+};
+
+/**
+ * Per-instance data of an instanced mesh, the position of the instance relative to the origin of the draw and the
+ * rotation of the mesh.
+ */
+struct Instance
+{
+  glm::vec3 position;
+  glm::mat3 transform;
+};
+
+enum class VertexLayout
+{
+  Mesh,          // Vertex
+  Line,          // LineVertex
+  InstancedMesh, // Vertex in slot 0, Instance in slot 1
+};
 
 struct PipelineConfig
 {
   std::string vertexShaderPath;
   std::string fragmentShaderPath;
+  VertexLayout vertexLayout = VertexLayout::Mesh;
   SDL_GPUPrimitiveType primitiveType = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
   SDL_GPUFillMode fillMode = SDL_GPU_FILLMODE_FILL;
   SDL_GPUCullMode cullMode = SDL_GPU_CULLMODE_BACK;
@@ -100,14 +130,23 @@ public:
     }
 
     // create the pipeline
-    SDL_GPUVertexBufferDescription vertexBufferDescriptions[1]{{
-      .slot = 0,
-      .pitch = sizeof(Vertex),
-      .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
-      .instance_step_rate = 0,
-    }};
+    const bool lineLayout = config.vertexLayout == VertexLayout::Line;
+    const bool instancedLayout = config.vertexLayout == VertexLayout::InstancedMesh;
+    SDL_GPUVertexBufferDescription vertexBufferDescriptions[2]{
+      {
+        .slot = 0,
+        .pitch = lineLayout ? sizeof(LineVertex) : sizeof(Vertex),
+        .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
+        .instance_step_rate = 0,
+      },
+      {
+        .slot = 1,
+        .pitch = sizeof(Instance),
+        .input_rate = SDL_GPU_VERTEXINPUTRATE_INSTANCE,
+        .instance_step_rate = 0,
+      }};
 
-    SDL_GPUVertexAttribute vertexAttributes[4]{
+    SDL_GPUVertexAttribute vertexAttributes[8]{
       {
         .location = 0,
         .buffer_slot = 0,
@@ -132,6 +171,31 @@ public:
         .buffer_slot = 0,
         .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
         .offset = offsetof(Vertex, uv),
+      },
+      {
+        .location = 4,
+        .buffer_slot = 1,
+        .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+        .offset = offsetof(Instance, position),
+      },
+      // the columns of the transform
+      {
+        .location = 5,
+        .buffer_slot = 1,
+        .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+        .offset = offsetof(Instance, transform),
+      },
+      {
+        .location = 6,
+        .buffer_slot = 1,
+        .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+        .offset = offsetof(Instance, transform) + sizeof(glm::vec3),
+      },
+      {
+        .location = 7,
+        .buffer_slot = 1,
+        .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+        .offset = offsetof(Instance, transform) + 2 * sizeof(glm::vec3),
       }};
 
     SDL_GPUColorTargetDescription colorTargetDescriptions[1]{{
@@ -152,9 +216,9 @@ public:
       .fragment_shader = fragmentShader,
       .vertex_input_state{
         .vertex_buffer_descriptions = vertexBufferDescriptions,
-        .num_vertex_buffers = 1,
+        .num_vertex_buffers = instancedLayout ? 2u : 1u,
         .vertex_attributes = vertexAttributes,
-        .num_vertex_attributes = 4,
+        .num_vertex_attributes = lineLayout ? 1u : (instancedLayout ? 8u : 4u),
       },
       .primitive_type = config.primitiveType,
       .rasterizer_state{
@@ -64,13 +64,34 @@ static void bindVertexBuffer(const RenderContext& context, SDL_GPUBuffer* buffer
   SDL_BindGPUVertexBuffers(context.renderPass, 0, &vertexBufferBinding, 1);
 };
 
-static void bindIndexBuffer(const RenderContext& context, SDL_GPUBuffer* buffer)
+/**
+ * Binds the per-vertex and the per-instance buffer of an instanced draw.
+ */
+static void bindInstancedVertexBuffers(
+  const RenderContext& context, SDL_GPUBuffer* buffer, SDL_GPUBuffer* instanceBuffer)
+{
+  SDL_GPUBufferBinding vertexBufferBindings[2]{
+    {
+      .buffer = buffer,
+      .offset = 0,
+    },
+    {
+      .buffer = instanceBuffer,
+      .offset = 0,
+    }};
+  SDL_BindGPUVertexBuffers(context.renderPass, 0, vertexBufferBindings, 2);
+}
+
+static void bindIndexBuffer(
+  const RenderContext& context,
+  SDL_GPUBuffer* buffer,
+  SDL_GPUIndexElementSize elementSize = SDL_GPU_INDEXELEMENTSIZE_16BIT)
 {
   SDL_GPUBufferBinding indexBufferBinding{
     .buffer = buffer,
     .offset = 0,
   };
-  SDL_BindGPUIndexBuffer(context.renderPass, &indexBufferBinding, SDL_GPU_INDEXELEMENTSIZE_16BIT);
+  SDL_BindGPUIndexBuffer(context.renderPass, &indexBufferBinding, elementSize);
 };
 
 static void bindSampler(const RenderContext& context, SDL_GPUTexture* texture)
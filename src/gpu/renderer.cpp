@@ -3,6 +3,9 @@
 #include "components.hpp"
 #include "gpu/allocator.hpp"
 #include "imgui_layer.hpp"
+#include "mesh_indices.hpp"
+#include "mesh_optimizer.hpp"
+#include "model_culling.hpp"
 #include "obj_loader.hpp"
 #include "tile_generator.hpp"
 
@@ -14,7 +17,21 @@ using namespace flb;
 
 namespace
 {
-void renderMain(const gpu::RenderContext& context, entt::registry& registry, const Camera& camera)
+// simplification error allowed on screen before a finer level of detail is drawn
+constexpr double MaxLodPixelError = 1.0;
+
+/**
+ * Coarsest level of detail of a mesh whose error projects to at most MaxLodPixelError pixels.
+ */
+const MeshLod& selectLod(const Mesh& mesh, const BoundingSphere& sphere, const Camera& camera, float viewportHeight)
+{
+  const double distance = glm::length(sphere.position - camera.position) - sphere.radius;
+  const double worldScale = mesh.boundsRadius > 0.0f ? sphere.radius / mesh.boundsRadius : 1.0;
+  const double pixelsPerMeter = camera.getScreenScale(distance) * 0.5 * viewportHeight * worldScale;
+  return mesh.getLod(static_cast<float>(MaxLodPixelError / pixelsPerMeter));
+}
+
+void renderMain(const gpu::RenderContext& context, entt::registry& registry, const Camera& camera, float viewportHeight)
 {
   gpu::bindPipeline(context);
 
@@ -26,8 +43,8 @@ void renderMain(const gpu::RenderContext& context, entt::registry& registry, con
   const auto view = registry.view<component::Position, component::Model>();
   for (const auto entity : view)
   {
-    // if (!registry.all_of<component::Visible>(entity))
-    //   continue;
+    if (!registry.all_of<component::Visible>(entity))
+      continue;
 
     const auto& position = view.get<component::Position>(entity);
     const auto& model = view.get<component::Model>(entity);
@@ -42,7 +59,7 @@ void renderMain(const gpu::RenderContext& context, entt::registry& registry, con
     }
 
     if (boundIndexBuffer != mesh.indexBuffer.buffer)
-      gpu::bindIndexBuffer(context, mesh.indexBuffer.buffer);
+      gpu::bindIndexBuffer(context, mesh.indexBuffer.buffer, mesh.indexElementSize);
     if (boundVertexBuffer != mesh.vertexBuffer.buffer)
       gpu::bindVertexBuffer(context, mesh.vertexBuffer.buffer);
     if (boundTexture != texture.texture)
@@ -52,11 +69,8 @@ void renderMain(const gpu::RenderContext& context, entt::registry& registry, con
     boundIndexBuffer = mesh.indexBuffer.buffer;
     boundTexture = texture.texture;
 
-    glm::mat4 modelTransform{1.0f};
-    if (const auto* transform = registry.try_get<component::Transform>(entity))
-    {
-      modelTransform = glm::mat4{transform->value};
-    }
+    const auto* transform = registry.try_get<component::Transform>(entity);
+    const glm::mat4 modelTransform = transform != nullptr ? glm::mat4{transform->value} : glm::mat4{1.0f};
 
     const gpu::Uniforms uniforms{
       .viewProjection = viewProjMat,
@@ -64,7 +78,20 @@ void renderMain(const gpu::RenderContext& context, entt::registry& registry, con
       .modelTransform = modelTransform,
     };
     SDL_PushGPUVertexUniformData(context.commandBuffer, 0, &uniforms, sizeof(uniforms));
-    SDL_DrawGPUIndexedPrimitives(context.renderPass, mesh.indexCount, 1, 0, 0, 0);
+    if (mesh.meshlets.empty())
+    {
+      const MeshLod& lod =
+        selectLod(mesh, getWorldBoundingSphere(mesh, position.value, transform), camera, viewportHeight);
+      SDL_DrawGPUIndexedPrimitives(context.renderPass, lod.indexCount, 1, lod.firstIndex, 0, 0);
+    }
+    else
+    {
+      for (const Meshlet& meshlet : mesh.meshlets)
+      {
+        SDL_DrawGPUIndexedPrimitives(
+          context.renderPass, meshlet.indexCount, 1, meshlet.firstIndex, meshlet.vertexOffset, 0);
+      }
+    }
   }
 }
 
@@ -94,6 +121,34 @@ void renderTiles(
   }
 }
 
+void renderTrails(const gpu::RenderContext& context, entt::registry& registry, const Camera& camera)
+{
+  constexpr glm::vec4 trailColor{1.0f, 0.85f, 0.2f, 1.0f};
+
+  gpu::bindPipeline(context);
+  SDL_PushGPUFragmentUniformData(context.commandBuffer, 0, &trailColor, sizeof(trailColor));
+
+  const glm::mat4 viewProjMat = camera.getViewProjMat();
+  const auto view = registry.view<component::Trail>();
+  for (const auto [entity, trail] : view.each())
+  {
+    if (trail.value.vertexBuffer.buffer == nullptr)
+      continue;
+
+    gpu::bindVertexBuffer(context, trail.value.vertexBuffer.buffer);
+
+    const gpu::Uniforms uniforms{
+      .viewProjection = viewProjMat,
+      .modelPosition = glm::vec4{trail.value.origin - camera.position, 1.0f},
+      .modelTransform = glm::mat4{1.0f},
+    };
+    SDL_PushGPUVertexUniformData(context.commandBuffer, 0, &uniforms, sizeof(uniforms));
+    trail.value.forEachDrawRange(
+      [&context](Uint32 firstVertex, Uint32 vertexCount)
+      { SDL_DrawGPUPrimitives(context.renderPass, vertexCount, 1, firstVertex, 0); });
+  }
+}
+
 void renderDebug(
   const gpu::RenderContext& context,
   entt::registry& registry,
@@ -140,6 +195,9 @@ void renderIndicators(
   const auto view = registry.view<component::Position, component::IndicatorModel>();
   for (const auto entity : view)
   {
+    if (!registry.all_of<component::Visible>(entity))
+      continue;
+
     const auto& position = view.get<component::Position>(entity);
     const auto& indicator = view.get<component::IndicatorModel>(entity);
     const Mesh mesh = indicator.value.getMesh();
@@ -150,7 +208,7 @@ void renderIndicators(
     }
 
     if (boundIndexBuffer != mesh.indexBuffer.buffer)
-      gpu::bindIndexBuffer(context, mesh.indexBuffer.buffer);
+      gpu::bindIndexBuffer(context, mesh.indexBuffer.buffer, mesh.indexElementSize);
     if (boundVertexBuffer != mesh.vertexBuffer.buffer)
       gpu::bindVertexBuffer(context, mesh.vertexBuffer.buffer);
 
@@ -177,6 +235,40 @@ void renderIndicators(
   }
 }
 
+void renderIndicatorInstances(
+  const gpu::RenderContext& context, entt::registry& registry, const Camera& camera, float alphaScale)
+{
+  gpu::bindPipeline(context);
+
+  const glm::mat4 viewProjMat = camera.getViewProjMat();
+  const auto view = registry.view<component::IndicatorInstances>();
+  for (const auto [entity, instances] : view.each())
+  {
+    const Mesh mesh = instances.indicator.getMesh();
+    if (
+      mesh.vertexBuffer.buffer == nullptr || mesh.indexBuffer.buffer == nullptr || mesh.indexCount == 0 ||
+      instances.instanceBuffer.buffer == nullptr || instances.count == 0)
+    {
+      continue;
+    }
+
+    gpu::bindIndexBuffer(context, mesh.indexBuffer.buffer, mesh.indexElementSize);
+    gpu::bindInstancedVertexBuffers(context, mesh.vertexBuffer.buffer, instances.instanceBuffer.buffer);
+
+    const gpu::Uniforms uniforms{
+      .viewProjection = viewProjMat,
+      .modelPosition = glm::vec4{instances.origin - camera.position, 1.0f},
+      .modelTransform = glm::mat4{1.0f},
+    };
+    glm::vec4 color = instances.indicator.getColor();
+    color.a = std::clamp(color.a * alphaScale, 0.0f, 1.0f);
+
+    SDL_PushGPUVertexUniformData(context.commandBuffer, 0, &uniforms, sizeof(uniforms));
+    SDL_PushGPUFragmentUniformData(context.commandBuffer, 0, &color, sizeof(color));
+    SDL_DrawGPUIndexedPrimitives(context.renderPass, mesh.indexCount, instances.count, 0, 0, 0);
+  }
+}
+
 void applyViewport(const gpu::RenderContext& context, const ViewportRect& rect)
 {
   if (!rect.valid)
@@ -276,6 +368,39 @@ SDL_AppResult Renderer::init(SDL_Window* window)
     return SDL_APP_FAILURE;
   }
 
+  gpu::PipelineConfig instancedIndicatorDepthConfig = indicatorDepthConfig;
+  instancedIndicatorDepthConfig.vertexShaderPath = "content/shaders/indicator_instanced.vert.hlsl";
+  instancedIndicatorDepthConfig.vertexLayout = gpu::VertexLayout::InstancedMesh;
+
+  if (
+    instancedIndicatorDepthPipeline.init(device.getPtr(), window, instancedIndicatorDepthConfig) != SDL_APP_CONTINUE)
+  {
+    return SDL_APP_FAILURE;
+  }
+
+  gpu::PipelineConfig instancedIndicatorConfig = indicatorConfig;
+  instancedIndicatorConfig.vertexShaderPath = "content/shaders/indicator_instanced.vert.hlsl";
+  instancedIndicatorConfig.vertexLayout = gpu::VertexLayout::InstancedMesh;
+
+  if (instancedIndicatorPipeline.init(device.getPtr(), window, instancedIndicatorConfig) != SDL_APP_CONTINUE)
+  {
+    return SDL_APP_FAILURE;
+  }
+
+  gpu::PipelineConfig trailConfig{
+    .vertexShaderPath = "content/shaders/trail.vert.hlsl",
+    .fragmentShaderPath = "content/shaders/trail.frag.hlsl",
+    .vertexLayout = gpu::VertexLayout::Line,
+    .primitiveType = SDL_GPU_PRIMITIVETYPE_LINESTRIP,
+    .cullMode = SDL_GPU_CULLMODE_NONE,
+    .enableDepthWrite = false,
+  };
+
+  if (trailPipeline.init(device.getPtr(), window, trailConfig) != SDL_APP_CONTINUE)
+  {
+    return SDL_APP_FAILURE;
+  }
+
   if (sampler.init(device.getPtr()) != SDL_APP_CONTINUE)
   {
     return SDL_APP_FAILURE;
@@ -300,7 +425,8 @@ SDL_AppResult Renderer::init(SDL_Window* window)
 
 SDL_AppResult Renderer::initDebugSphere(gpu::Allocator& allocator)
 {
-  auto [vertices, indices] = loadOBJ("content/models/debug/sphere.obj");
+  const auto [vertices, wideIndices] = loadOBJ("content/models/debug/sphere.obj");
+  const std::vector<gpu::Index> indices = narrowIndices(wideIndices);
   if (vertices.empty() || indices.empty())
   {
     SDL_Log("Failed to load debug sphere OBJ");
@@ -331,6 +457,16 @@ void Renderer::initTileIndexBuffer(gpu::Allocator& allocator)
   const auto bufMemory = allocator.allocateBuffer(bufHandle);
   std::span<gpu::Index> indices(reinterpret_cast<gpu::Index*>(bufMemory.data()), TILE_NUM_INDICES);
   generateTileIndices(indices);
+
+  const VertexCacheStats statsBefore = analyzeVertexCache(indices, NUM_VERTICES_PER_TILE);
+  optimizeVertexCache(indices, NUM_VERTICES_PER_TILE);
+  const VertexCacheStats statsAfter = analyzeVertexCache(indices, NUM_VERTICES_PER_TILE);
+  SDL_Log(
+    "Optimized the tile grid for the vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+    statsBefore.acmr,
+    statsAfter.acmr,
+    statsBefore.atvr,
+    statsAfter.atvr);
 }
 
 void Renderer::cleanup(SDL_Window* window)
@@ -346,6 +482,9 @@ void Renderer::cleanup(SDL_Window* window)
   debugPipeline.cleanup(device.getPtr());
   indicatorDepthPipeline.cleanup(device.getPtr());
   indicatorPipeline.cleanup(device.getPtr());
+  instancedIndicatorDepthPipeline.cleanup(device.getPtr());
+  instancedIndicatorPipeline.cleanup(device.getPtr());
+  trailPipeline.cleanup(device.getPtr());
   SDL_ReleaseWindowFromGPUDevice(device.getPtr(), window);
   device.cleanup();
 }
@@ -455,14 +594,21 @@ SDL_AppResult Renderer::draw(
     applyViewport(context, sceneRect);
 
     context.pipeline = mainPipeline.get();
-    renderMain(context, registry, camera);
+    renderMain(context, registry, camera, sceneRect.height);
     renderTiles(context, registry, camera, tileIndexBuffer);
 
+    context.pipeline = trailPipeline.get();
+    renderTrails(context, registry, camera);
+
     context.pipeline = indicatorDepthPipeline.get();
     renderIndicators(context, registry, camera, 0.0f);
+    context.pipeline = instancedIndicatorDepthPipeline.get();
+    renderIndicatorInstances(context, registry, camera, 0.0f);
 
     context.pipeline = indicatorPipeline.get();
     renderIndicators(context, registry, camera, 1.0f);
+    context.pipeline = instancedIndicatorPipeline.get();
+    renderIndicatorInstances(context, registry, camera, 1.0f);
 
     // context.pipeline = debugPipeline.get();
     // renderDebug(
@@ -44,6 +44,9 @@ private:
   gpu::Pipeline debugPipeline;
   gpu::Pipeline indicatorDepthPipeline;
   gpu::Pipeline indicatorPipeline;
+  gpu::Pipeline instancedIndicatorDepthPipeline;
+  gpu::Pipeline instancedIndicatorPipeline;
+  gpu::Pipeline trailPipeline;
   gpu::Sampler sampler;
   SDL_GPUTextureFormat sceneColorFormat = SDL_GPU_TEXTUREFORMAT_INVALID;
 
@@ -1252,7 +1252,12 @@ void ImGuiLayer::endMainView(SDL_GPUTexture* sceneTexture)
   ImGui::PopStyleVar();
 }
 
-bool ImGuiLayer::drawSidePanel(CameraMode cameraMode, double& cameraSpeed)
+bool ImGuiLayer::drawSidePanel(
+  CameraMode cameraMode,
+  double& cameraSpeed,
+  float& maxTileError,
+  const GeoCoords& cameraCoords,
+  double cameraHeight)
 {
   ImGui::Begin(SIDE_PANEL_WINDOW_NAME, nullptr, ImGuiWindowFlags_NoCollapse);
 
@@ -1275,6 +1280,10 @@ bool ImGuiLayer::drawSidePanel(CameraMode cameraMode, double& cameraSpeed)
   {
     cameraSpeed = static_cast<double>(cameraSpeedValue);
   }
+  ImGui::SliderFloat("Tile error", &maxTileError, 0.5f, 8.0f, "%.1f px", ImGuiSliderFlags_Logarithmic);
+  ImGui::PushFont(defaultFont, UI_FONT_SIZE_SMALL);
+  ImGui::Text("%.6f, %.6f  %.0f m", cameraCoords.latitude, cameraCoords.longitude, cameraHeight);
+  ImGui::PopFont();
 
   ImGui::Spacing();
   ImGui::PushFont(boldFont, UI_FONT_SIZE_MEDIUM);
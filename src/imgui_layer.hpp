@@ -9,6 +9,7 @@ struct ImFont;
 namespace flb
 {
 enum class CameraMode;
+struct GeoCoords;
 
 struct ViewportRect
 {
@@ -31,7 +32,12 @@ public:
   void beginFrame();
   ViewportRect beginMainView();
   void endMainView(SDL_GPUTexture* sceneTexture);
-  bool drawSidePanel(CameraMode cameraMode, double& cameraSpeed);
+  bool drawSidePanel(
+    CameraMode cameraMode,
+    double& cameraSpeed,
+    float& maxTileError,
+    const GeoCoords& cameraCoords,
+    double cameraHeight);
   void drawActionsWindow();
   void drawTelemetryWindow();
   void endFrame();
@@ -7,11 +7,96 @@
 
 #include <SDL3_shadercross/SDL_shadercross.h>
 
+#include <algorithm>
+#include <iterator>
+#include <string_view>
+
+namespace
+{
+/**
+ * Usage: flightboard [--record <log>] [--replay <log>] [--replay-speed <factor>] [--adsb <host:port>]
+ *                    [--shm-telemetry <name>] [--large-meshes <wide|meshlets>]
+ */
+bool parseOptions(int argc, char** argv, flb::AppOptions& outOptions)
+{
+  constexpr std::string_view Options[] = {
+    "--record", "--replay", "--replay-speed", "--adsb", "--shm-telemetry", "--large-meshes"};
+
+  bool hasReplaySpeed = false;
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string_view arg = argv[i];
+    if (std::find(std::begin(Options), std::end(Options), arg) == std::end(Options))
+    {
+      SDL_Log("Unknown argument %s", argv[i]);
+      return false;
+    }
+    if (i + 1 >= argc)
+    {
+      SDL_Log("Missing value for %s", argv[i]);
+      return false;
+    }
+
+    const char* value = argv[++i];
+    if (arg == "--record")
+    {
+      outOptions.recordPath = value;
+    }
+    else if (arg == "--replay")
+    {
+      outOptions.replayPath = value;
+    }
+    else if (arg == "--replay-speed")
+    {
+      outOptions.replaySpeed = SDL_atof(value);
+      hasReplaySpeed = true;
+      if (outOptions.replaySpeed <= 0.0)
+      {
+        SDL_Log("Invalid replay speed %s", value);
+        return false;
+      }
+    }
+    else if (arg == "--adsb")
+    {
+      outOptions.adsbAddress = value;
+    }
+    else if (arg == "--shm-telemetry")
+    {
+      outOptions.sharedTelemetryName = value;
+    }
+    else if (arg == "--large-meshes")
+    {
+      const std::string_view mode = value;
+      if (mode != "wide" && mode != "meshlets")
+      {
+        SDL_Log("Invalid large mesh mode %s, expected wide or meshlets", value);
+        return false;
+      }
+      outOptions.useMeshlets = mode == "meshlets";
+    }
+  }
+
+  if (hasReplaySpeed && outOptions.replayPath.empty())
+  {
+    SDL_Log("--replay-speed requires --replay");
+    return false;
+  }
+
+  return true;
+}
+} // namespace
+
 SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv)
 {
+  flb::AppOptions options;
+  if (!parseOptions(argc, argv, options))
+  {
+    return SDL_APP_FAILURE;
+  }
+
   // must be deleted in SDL_AppQuit
   auto app = new flb::App();
-  SDL_AppResult result = app->init();
+  SDL_AppResult result = app->init(options);
   if (result != SDL_APP_CONTINUE)
   {
     delete app;
@@ -4,7 +4,12 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
+
+#include <cmath>
+#include <filesystem>
+#include <limits>
 #include <numbers>
+#include <span>
 
 namespace flb
 {
@@ -33,7 +38,7 @@ struct BBOX
 
 /**
  * The loading algorithm will load all tiles that intersect with the zoom region for each zoom level in the range
- * [zoomMin, zoomMax].
+ * [zoomMin, zoomMax]. Their images are at root/zoom/x/y.
  */
 struct TilesetDescription
 {
@@ -41,6 +46,7 @@ struct TilesetDescription
   std::uint32_t zoomMin;
   std::uint32_t zoomMax;
   BBOX zoomRegion;
+  std::filesystem::path root;
 };
 
 using ECEFCoords = glm::dvec3;
@@ -92,31 +98,37 @@ static ECEFCoords projectToEllipsoidSurface(const ECEFCoords& ecef)
 }
 
 /**
- * Builds a local tangent frame for the given geographic coordinates.
- *
- * The returned matrix maps model-local +X to east, +Y to north, and +Z to the
+ * Returns the east, north and up axes at the given geographic coordinates as the columns of a matrix, up being the
  * WGS84 ellipsoid surface normal.
  */
-static glm::mat3 getSurfaceAlignedTransform(const GeoCoords& geo)
+static glm::dmat3 getSurfaceBasis(const GeoCoords& geo)
 {
-  const glm::vec3 up = getSurfaceNormal(geo);
+  const double latRad = glm::radians(geo.latitude);
+  const double lonRad = glm::radians(geo.longitude);
 
-  constexpr glm::vec3 earthAxis{0.0f, 0.0f, 1.0f};
-  glm::vec3 east = glm::cross(earthAxis, up);
-  if (glm::dot(east, east) < 1e-8f)
-  {
-    east = {0.0f, 1.0f, 0.0f};
-  }
-  else
-  {
-    east = glm::normalize(east);
-  }
+  const double sinLat = glm::sin(latRad);
+  const double cosLat = glm::cos(latRad);
+  const double sinLon = glm::sin(lonRad);
+  const double cosLon = glm::cos(lonRad);
 
-  const glm::vec3 north = glm::normalize(glm::cross(up, east));
+  const glm::dvec3 east{-sinLon, cosLon, 0.0};
+  const glm::dvec3 north{-sinLat * cosLon, -sinLat * sinLon, cosLat};
+  const glm::dvec3 up{cosLat * cosLon, cosLat * sinLon, sinLat};
 
   return {east, north, up};
 }
 
+/**
+ * Builds a local tangent frame for the given geographic coordinates.
+ *
+ * The returned matrix maps model-local +X to east, +Y to north, and +Z to the
+ * WGS84 ellipsoid surface normal.
+ */
+static glm::mat3 getSurfaceAlignedTransform(const GeoCoords& geo)
+{
+  return glm::mat3(getSurfaceBasis(geo));
+}
+
 static NodeCoords geoToTileCoords(const GeoCoords& from, const std::uint32_t& zoom)
 {
   const double latitude = glm::clamp(from.latitude, MIN_LATITUDE, MAX_LATITUDE);
@@ -126,9 +138,10 @@ static NodeCoords geoToTileCoords(const GeoCoords& from, const std::uint32_t& zo
   const double sinLat = glm::sin(latitude * PI / 180.0);
   const double y = 0.5 - glm::log((1.0 + sinLat) / (1.0 - sinLat)) / (4.0 * PI);
 
+  // the edges of the map, where rounding can also push y past them, belong to the outermost tiles
   const double numTiles = glm::pow(2.0, zoom);
-  const std::uint32_t tileX = static_cast<std::uint32_t>(glm::floor(x * numTiles));
-  const std::uint32_t tileY = static_cast<std::uint32_t>(glm::floor(y * numTiles));
+  const std::uint32_t tileX = static_cast<std::uint32_t>(glm::clamp(glm::floor(x * numTiles), 0.0, numTiles - 1.0));
+  const std::uint32_t tileY = static_cast<std::uint32_t>(glm::clamp(glm::floor(y * numTiles), 0.0, numTiles - 1.0));
   return {zoom, tileX, tileY};
 }
 
@@ -202,4 +215,138 @@ static ECEFCoords tileToECEF(std::uint32_t tile_zoom, double tile_x, double tile
 
   return {x, y, z};
 }
+
+/**
+ * Converts ECEF coordinates to geographic coordinates and height above the WGS84 ellipsoid with Vermeille's closed
+ * form solution, which takes no iterations and a single cube root. It is accurate to a fraction of a millimeter for
+ * any position farther than about 50 km from the center of the earth.
+ */
+static GeoCoords ecefToGeo(const ECEFCoords& ecef, double& height)
+{
+  constexpr double a = SEMI_MAJOR;
+  constexpr double b = SEMI_MINOR;
+  constexpr double e2 = 1.0 - (b * b) / (a * a);
+  constexpr double e4 = e2 * e2;
+
+  const double horizontal = glm::sqrt(ecef.x * ecef.x + ecef.y * ecef.y);
+  const double p = (horizontal * horizontal) / (a * a);
+  const double q = (1.0 - e2) * (ecef.z * ecef.z) / (a * a);
+  const double r = (p + q - e4) / 6.0;
+  const double s = e4 * p * q / (4.0 * r * r * r);
+  const double t = std::cbrt(1.0 + s + glm::sqrt(s * (2.0 + s)));
+  const double u = r * (1.0 + t + 1.0 / t);
+  const double v = glm::sqrt(u * u + e4 * q);
+  const double w = e2 * (u + v - q) / (2.0 * v);
+  const double k = glm::sqrt(u + v + w * w) - w;
+  const double d = k * horizontal / (k + e2);
+  const double distance = glm::sqrt(d * d + ecef.z * ecef.z);
+
+  height = (k + e2 - 1.0) / k * distance;
+  return {
+    glm::degrees(2.0 * glm::atan(ecef.z, d + distance)),
+    glm::degrees(glm::atan(ecef.y, ecef.x)),
+  };
+}
+
+static GeoCoords ecefToGeo(const ECEFCoords& ecef)
+{
+  double height = 0.0;
+  return ecefToGeo(ecef, height);
+}
+
+/**
+ * Time interval [begin, end], empty when begin > end.
+ */
+struct Interval
+{
+  double begin;
+  double end;
+};
+
+/**
+ * Times at which x + v * t lies within [min, max].
+ */
+static Interval getSlabInterval(double x, double v, double min, double max)
+{
+  constexpr double infinity = std::numeric_limits<double>::infinity();
+  if (glm::abs(v) < 1e-9)
+  {
+    return (x >= min && x <= max) ? Interval{-infinity, infinity} : Interval{infinity, -infinity};
+  }
+
+  const double t0 = (min - x) / v;
+  const double t1 = (max - x) / v;
+  return {glm::min(t0, t1), glm::max(t0, t1)};
+}
+
+/**
+ * East-north-up frame tangent to the WGS84 ellipsoid at origin. Flat-earth math in this frame is accurate within a few
+ * tens of kilometers of the origin, the ellipsoid drops below the tangent plane by about 8 meters at 10 km.
+ */
+struct ENUFrame
+{
+  ECEFCoords origin{0.0};
+  // rows are the east, north and up axes in ECEF
+  glm::dmat3 ecefToENU{1.0};
+
+  glm::dvec3 toENU(const ECEFCoords& ecef) const { return ecefToENU * (ecef - origin); }
+  glm::dvec3 directionToENU(const glm::dvec3& direction) const { return ecefToENU * direction; }
+  ECEFCoords toECEF(const glm::dvec3& enu) const { return origin + glm::transpose(ecefToENU) * enu; }
+};
+
+static ENUFrame makeENUFrame(const GeoCoords& geo)
+{
+  return {
+    .origin = geoToECEF(geo),
+    .ecefToENU = glm::transpose(getSurfaceBasis(geo)),
+  };
+}
+
+/**
+ * ENU frame on the ellipsoid under the centroid of the positions, which holds up across the antimeridian and around
+ * the poles where averaging latitudes and longitudes doesn't.
+ */
+static ENUFrame makeENUFrame(std::span<const ECEFCoords> positions)
+{
+  ECEFCoords centroid{0.0};
+  for (const ECEFCoords& position : positions)
+  {
+    centroid += position / static_cast<double>(positions.size());
+  }
+  return makeENUFrame(ecefToGeo(projectToEllipsoidSurface(centroid)));
+}
+
+/**
+ * Hands out an ENU frame for positions anywhere, reusing the last one while positions stay within maxDistance of its
+ * origin horizontally, so converting many positions around the same place costs a matrix multiply each. Otherwise the
+ * frame is rebuilt on the ellipsoid under the position.
+ */
+class ENUFrameCache
+{
+public:
+  static constexpr double DEFAULT_MAX_DISTANCE = 10'000.0;
+
+  explicit ENUFrameCache(double maxDistance = DEFAULT_MAX_DISTANCE)
+    : maxDistanceSquared(maxDistance * maxDistance)
+  {
+  }
+
+  const ENUFrame& get(const ECEFCoords& position)
+  {
+    const glm::dvec3 enu = frame.toENU(position);
+    if (!valid || enu.x * enu.x + enu.y * enu.y > maxDistanceSquared)
+    {
+      frame = makeENUFrame(ecefToGeo(position));
+      valid = true;
+    }
+    return frame;
+  }
+
+  glm::dvec3 toENU(const ECEFCoords& position) { return get(position).toENU(position); }
+
+private:
+  ENUFrame frame;
+  double maxDistanceSquared;
+  bool valid = false;
+};
 } // namespace flb
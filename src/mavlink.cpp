@@ -0,0 +1,251 @@
+#include "mavlink.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+
+namespace flb
+{
+namespace
+{
+static_assert(std::endian::native == std::endian::little, "MAVLink fields are read in place as little endian");
+
+constexpr std::uint8_t MagicV1 = 0xfe;
+constexpr std::uint8_t MagicV2 = 0xfd;
+constexpr std::size_t HeaderSizeV1 = 6;
+constexpr std::size_t HeaderSizeV2 = 10;
+constexpr std::size_t ChecksumSize = 2;
+constexpr std::size_t SignatureSize = 13;
+constexpr std::uint8_t IncompatFlagSigned = 0x01;
+
+constexpr std::uint32_t GlobalPositionIntID = 33;
+constexpr std::uint8_t GlobalPositionIntCRCExtra = 104;
+constexpr std::size_t GlobalPositionIntSize = 28;
+
+// longest the receive thread blocks on the socket before checking whether it was stopped
+constexpr int PollTimeoutMs = 100;
+// room for the datagrams of a burst while the receive thread isn't scheduled
+constexpr int SocketBufferSize = 1 << 20;
+
+template <typename T>
+T read(const std::byte* data)
+{
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+/**
+ * CRC-16/MCRF4XX of a frame from its length byte to the end of its payload, followed by the CRC extra byte of the
+ * message, which guards against both ends disagreeing on the message layout.
+ */
+std::uint16_t getChecksum(std::span<const std::byte> bytes, std::uint8_t crcExtra)
+{
+  std::uint16_t crc = 0xffff;
+  const auto accumulate = [&crc](std::uint8_t byte)
+  {
+    std::uint8_t tmp = byte ^ static_cast<std::uint8_t>(crc & 0xff);
+    tmp ^= static_cast<std::uint8_t>(tmp << 4);
+    crc = static_cast<std::uint16_t>((crc >> 8) ^ (tmp << 8) ^ (tmp << 3) ^ (tmp >> 4));
+  };
+  for (const std::byte byte : bytes)
+  {
+    accumulate(static_cast<std::uint8_t>(byte));
+  }
+  accumulate(crcExtra);
+  return crc;
+}
+} // namespace
+
+void MAVLink::init(std::span<const std::string> vehicleNamespaces)
+{
+  vehicleIds.fill(NO_VEHICLE);
+  for (VehicleID vehicleId = 0; vehicleId < vehicleNamespaces.size(); ++vehicleId)
+  {
+    std::uint8_t systemID = 0;
+    if (!parseSystemID(vehicleNamespaces[vehicleId], systemID))
+    {
+      SDL_Log("No MAVLink system ID for vehicle namespace %s", vehicleNamespaces[vehicleId].c_str());
+      continue;
+    }
+    vehicleIds[systemID] = vehicleId;
+  }
+
+  socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (socket < 0)
+  {
+    SDL_Log("Failed to create the MAVLink socket: %s", std::strerror(errno));
+    return;
+  }
+
+  ::setsockopt(socket, SOL_SOCKET, SO_RCVBUF, &SocketBufferSize, sizeof(SocketBufferSize));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(PORT);
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (::bind(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+  {
+    SDL_Log("Failed to listen for MAVLink on UDP port %u: %s", PORT, std::strerror(errno));
+    ::close(socket);
+    socket = -1;
+    return;
+  }
+
+  buffers.assign(BATCH_SIZE * DATAGRAM_SIZE, std::byte{0});
+  running.store(true, std::memory_order_relaxed);
+  receiveThread = std::thread([this]() { run(); });
+}
+
+void MAVLink::cleanup()
+{
+  if (socket < 0)
+  {
+    return;
+  }
+
+  running.store(false, std::memory_order_relaxed);
+  if (receiveThread.joinable())
+  {
+    receiveThread.join();
+  }
+  ::close(socket);
+  socket = -1;
+}
+
+bool MAVLink::parseSystemID(std::string_view vehicleNamespace, std::uint8_t& outSystemID)
+{
+  if (vehicleNamespace.empty() || vehicleNamespace == "/")
+  {
+    outSystemID = 1;
+    return true;
+  }
+
+  // the instance is the number the namespace ends with
+  const std::size_t digits = vehicleNamespace.find_last_not_of("0123456789") + 1;
+  unsigned int instance = 0;
+  const char* end = vehicleNamespace.data() + vehicleNamespace.size();
+  const auto [next, error] = std::from_chars(vehicleNamespace.data() + digits, end, instance);
+  if (error != std::errc{} || next != end || instance > 254)
+  {
+    return false;
+  }
+
+  outSystemID = static_cast<std::uint8_t>(instance + 1);
+  return true;
+}
+
+void MAVLink::run()
+{
+  // the headers point into the ring of buffers, each batch overwrites the datagrams of the previous one
+  std::array<iovec, BATCH_SIZE> vectors;
+  std::array<mmsghdr, BATCH_SIZE> messages{};
+  for (std::size_t i = 0; i < BATCH_SIZE; ++i)
+  {
+    vectors[i] = {.iov_base = buffers.data() + i * DATAGRAM_SIZE, .iov_len = DATAGRAM_SIZE};
+    messages[i].msg_hdr.msg_iov = &vectors[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  pollfd descriptor{.fd = socket, .events = POLLIN, .revents = 0};
+  while (running.load(std::memory_order_relaxed))
+  {
+    if (::poll(&descriptor, 1, PollTimeoutMs) <= 0)
+    {
+      continue;
+    }
+
+    // everything that is queued is read in as few calls as possible, a short batch means the queue is empty
+    int count = BATCH_SIZE;
+    while (count == static_cast<int>(BATCH_SIZE))
+    {
+      count = ::recvmmsg(socket, messages.data(), BATCH_SIZE, MSG_DONTWAIT, nullptr);
+      if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+      {
+        SDL_Log("Failed to receive MAVLink datagrams: %s", std::strerror(errno));
+      }
+
+      const TimePoint receivedAt = now();
+      for (int i = 0; i < count; ++i)
+      {
+        parseDatagram(std::span{buffers}.subspan(i * DATAGRAM_SIZE, messages[i].msg_len), receivedAt);
+      }
+    }
+  }
+}
+
+void MAVLink::parseDatagram(std::span<const std::byte> datagram, TimePoint receivedAt)
+{
+  std::size_t offset = 0;
+  while (offset < datagram.size())
+  {
+    const std::uint8_t magic = static_cast<std::uint8_t>(datagram[offset]);
+    const bool v2 = magic == MagicV2;
+    const std::size_t headerSize = v2 ? HeaderSizeV2 : HeaderSizeV1;
+    if ((!v2 && magic != MagicV1) || offset + headerSize > datagram.size())
+    {
+      // not at the start of a frame, look for the next one
+      ++offset;
+      continue;
+    }
+
+    const std::byte* header = datagram.data() + offset;
+    const std::size_t payloadSize = static_cast<std::uint8_t>(header[1]);
+    const std::uint8_t incompatFlags = v2 ? static_cast<std::uint8_t>(header[2]) : 0;
+    const std::size_t signatureSize = (incompatFlags & IncompatFlagSigned) ? SignatureSize : 0;
+    const std::size_t frameSize = headerSize + payloadSize + ChecksumSize + signatureSize;
+    if (offset + frameSize > datagram.size())
+    {
+      // a magic byte that doesn't start a frame, or a frame cut off by the end of a truncated datagram
+      ++offset;
+      continue;
+    }
+
+    const std::uint8_t systemID = static_cast<std::uint8_t>(header[v2 ? 5 : 3]);
+    const std::uint32_t messageID = v2 ? static_cast<std::uint32_t>(header[7]) |
+                                           (static_cast<std::uint32_t>(header[8]) << 8) |
+                                           (static_cast<std::uint32_t>(header[9]) << 16)
+                                       : static_cast<std::uint32_t>(header[5]);
+    if (messageID != GlobalPositionIntID || (incompatFlags & ~IncompatFlagSigned) != 0)
+    {
+      offset += frameSize;
+      continue;
+    }
+
+    const std::span<const std::byte> checked = datagram.subspan(offset + 1, headerSize - 1 + payloadSize);
+    if (getChecksum(checked, GlobalPositionIntCRCExtra) != read<std::uint16_t>(header + headerSize + payloadSize))
+    {
+      // a magic byte inside another frame or a corrupted frame, resynchronize from the next byte
+      ++offset;
+      continue;
+    }
+    offset += frameSize;
+
+    const VehicleID vehicleId = vehicleIds[systemID];
+    if (vehicleId == NO_VEHICLE)
+    {
+      continue;
+    }
+
+    // MAVLink 2 drops trailing zero bytes of the payload
+    std::array<std::byte, GlobalPositionIntSize> payload{};
+    std::memcpy(payload.data(), header + headerSize, std::min(payloadSize, payload.size()));
+    channel.publish({
+      .vehicleId = vehicleId,
+      .sourceTimestampUs = std::uint64_t{read<std::uint32_t>(payload.data())} * 1000,
+      .receivedAt = receivedAt,
+      .latitude = read<std::int32_t>(payload.data() + 4) * 1e-7,
+      .longitude = read<std::int32_t>(payload.data() + 8) * 1e-7,
+      .altitude = read<std::int32_t>(payload.data() + 12) * 1e-3,
+    });
+  }
+}
+} // namespace flb
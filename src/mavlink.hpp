@@ -0,0 +1,59 @@
+#pragma once
+
+#include "telemetry.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace flb
+{
+/**
+ * Receives MAVLink telemetry over UDP on a dedicated thread, a drop-in for ROS in builds without a ROS 2 stack.
+ *
+ * Datagrams are read in batches with recvmmsg() into a ring of buffers allocated once in init(), and the v1 and v2
+ * frames in them are parsed where they lie. GLOBAL_POSITION_INT messages with a valid checksum are published to the
+ * same channel the ROS listener feeds. Other messages are skipped by their length without being checked.
+ *
+ * Vehicles are told apart by their MAVLink system ID, which PX4 sets to its instance plus one: the namespace "px4_N"
+ * maps to system N + 1 and "/" to system 1, matching the namespaces the DDS bridge gives the same instances.
+ */
+class MAVLink
+{
+public:
+  // PX4 streams to ground stations on this port
+  static constexpr std::uint16_t PORT = 14550;
+  static constexpr std::size_t BATCH_SIZE = 64;
+  // an Ethernet MTU, a datagram holds one or several whole frames
+  static constexpr std::size_t DATAGRAM_SIZE = 1500;
+
+  void init(std::span<const std::string> vehicleNamespaces);
+  void cleanup();
+
+  TelemetryChannel& getChannel() { return channel; }
+
+private:
+  static constexpr VehicleID NO_VEHICLE = std::numeric_limits<VehicleID>::max();
+
+  static bool parseSystemID(std::string_view vehicleNamespace, std::uint8_t& outSystemID);
+
+  void run();
+  void parseDatagram(std::span<const std::byte> datagram, TimePoint receivedAt);
+
+  TelemetryChannel channel;
+  // vehicle of every MAVLink system ID
+  std::array<VehicleID, 256> vehicleIds{};
+
+  int socket = -1;
+  std::vector<std::byte> buffers;
+  std::atomic<bool> running{false};
+  std::thread receiveThread;
+};
+} // namespace flb
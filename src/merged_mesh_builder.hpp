@@ -0,0 +1,125 @@
+#pragma once
+
+#include "gpu/pipeline.hpp"
+#include "mesh_indices.hpp"
+#include "mesh_manager.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace flb
+{
+
+/**
+ * Bakes many small pieces of geometry into one large mesh, so that drawing them takes a single draw call no matter how
+ * many pieces there are. Positions are relative to an origin shared by all pieces, which becomes the position of the
+ * merged mesh.
+ *
+ * Indices are collected as 32-bit and the index width is picked per mesh in finish(): meshes that 16-bit indices can
+ * address are uploaded with them, larger ones keep 32-bit indices.
+ */
+class MergedMeshBuilder
+{
+public:
+  static constexpr std::size_t MAX_VERTICES = std::numeric_limits<gpu::WideIndex>::max();
+
+  explicit MergedMeshBuilder(MeshManager& meshManager) : meshManager(meshManager) { }
+
+  /**
+   * Makes room for a piece of vertexCount vertices. Returns false if the mesh would have more vertices than 32-bit
+   * indices can address.
+   */
+  bool reserve(std::size_t vertexCount)
+  {
+    if (vertexCount > MAX_VERTICES - vertices.size())
+    {
+      return false;
+    }
+
+    vertices.reserve(vertices.size() + vertexCount);
+    return true;
+  }
+
+  /**
+   * Index of the next vertex added to the mesh.
+   */
+  std::uint32_t getVertexCount() const { return static_cast<std::uint32_t>(vertices.size()); }
+
+  void addVertex(const gpu::Vertex& vertex) { vertices.push_back(vertex); }
+
+  void addTriangle(std::uint32_t a, std::uint32_t b, std::uint32_t c) { indices.insert(indices.end(), {a, b, c}); }
+
+  /**
+   * Adds a copy of a mesh, transformed and then moved by offset from the shared origin. Returns false if the mesh
+   * doesn't fit.
+   */
+  bool addMesh(
+    std::span<const gpu::Vertex> meshVertices,
+    std::span<const gpu::WideIndex> meshIndices,
+    const glm::mat3& transform,
+    const glm::vec3& offset)
+  {
+    if (!reserve(meshVertices.size()))
+    {
+      return false;
+    }
+
+    const std::uint32_t baseVertex = getVertexCount();
+    const glm::mat3 normalTransform = glm::transpose(glm::inverse(transform));
+    for (gpu::Vertex vertex : meshVertices)
+    {
+      vertex.position = transform * vertex.position + offset;
+      vertex.normal = glm::normalize(normalTransform * vertex.normal);
+      vertices.push_back(vertex);
+    }
+
+    for (const gpu::WideIndex index : meshIndices)
+    {
+      indices.push_back(baseVertex + index);
+    }
+    return true;
+  }
+
+  /**
+   * Uploads the merged mesh and returns its handle, which holds one reference. The handle is invalid if nothing was
+   * added or the upload failed.
+   */
+  MeshHandle finish()
+  {
+    MeshHandle mesh{};
+    if (vertices.empty() || indices.empty())
+    {
+      return mesh;
+    }
+
+    if (vertices.size() <= gpu::MAX_INDEXED_VERTICES)
+    {
+      mesh = meshManager.allocate(vertices, narrowIndices(indices));
+    }
+    else
+    {
+      mesh = meshManager.allocate(vertices, indices);
+    }
+
+    if (!mesh.isValid())
+    {
+      SDL_Log("Failed to create merged mesh with %zu vertices", vertices.size());
+    }
+
+    vertices.clear();
+    indices.clear();
+    return mesh;
+  }
+
+private:
+  MeshManager& meshManager;
+  std::vector<gpu::Vertex> vertices;
+  std::vector<gpu::WideIndex> indices;
+};
+
+} // namespace flb
@@ -0,0 +1,354 @@
+#include "mesh_cache.hpp"
+
+#include "mesh_indices.hpp"
+#include "mesh_optimizer.hpp"
+#include "mesh_simplifier.hpp"
+#include "obj_loader.hpp"
+
+#include <SDL3/SDL_log.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <vector>
+
+namespace flb
+{
+namespace
+{
+constexpr std::array<char, 4> CacheMagic{'F', 'L', 'B', 'M'};
+// bump when the layout of the file or the way levels of detail are built changes
+constexpr std::uint32_t CacheVersion = 3;
+
+struct MeshCacheHeader
+{
+  std::array<char, 4> magic;
+  std::uint32_t version;
+  std::uint64_t sourceSize;
+  std::int64_t sourceTime;
+  std::uint32_t vertexSize;
+  std::uint32_t indexSize;
+  std::uint32_t vertexCount;
+  std::uint32_t indexCount;
+  std::uint32_t lodCount;
+  // meshlets follow the indices, when there are any the indices are 16-bit and relative to each meshlet
+  std::uint32_t meshletCount;
+  std::array<MeshLod, MAX_MESH_LODS> lods;
+};
+static_assert(std::is_trivially_copyable_v<MeshCacheHeader>);
+static_assert(std::is_trivially_copyable_v<Meshlet>);
+static_assert(sizeof(MeshCacheHeader) % alignof(gpu::Vertex) == 0);
+static_assert(sizeof(gpu::Vertex) % alignof(gpu::WideIndex) == 0);
+
+/**
+ * Size and modification time of the OBJ a cache was built from.
+ */
+struct SourceStamp
+{
+  std::uint64_t size = 0;
+  std::int64_t time = 0;
+  bool valid = false;
+};
+
+/**
+ * Read only mapping of a whole file, empty if the file can't be opened or mapped.
+ */
+class MappedFile
+{
+public:
+  explicit MappedFile(const std::filesystem::path& path)
+  {
+    const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+    {
+      return;
+    }
+
+    struct stat status{};
+    if (fstat(file, &status) == 0 && status.st_size > 0)
+    {
+      void* mapping = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+      if (mapping != MAP_FAILED)
+      {
+        data = static_cast<const std::byte*>(mapping);
+        size = static_cast<std::size_t>(status.st_size);
+      }
+    }
+    close(file);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile()
+  {
+    if (data != nullptr)
+    {
+      munmap(const_cast<std::byte*>(data), size);
+    }
+  }
+
+  std::span<const std::byte> getBytes() const { return {data, size}; }
+
+private:
+  const std::byte* data = nullptr;
+  std::size_t size = 0;
+};
+
+/**
+ * Header of a valid cache, and its vertex and index arrays pointing into the mapped file. Only the index array of the
+ * width given by the header is set. Meshlets are copied out, they aren't aligned in the file.
+ */
+struct CachedMesh
+{
+  MeshCacheHeader header;
+  std::span<const gpu::Vertex> vertices;
+  std::span<const gpu::Index> indices;
+  std::span<const gpu::WideIndex> wideIndices;
+  std::vector<Meshlet> meshlets;
+};
+
+/**
+ * Mesh as it is written to the cache and uploaded, with the index array of its width set.
+ */
+struct MeshData
+{
+  std::span<const gpu::Vertex> vertices{};
+  std::span<const gpu::Index> indices{};
+  std::span<const gpu::WideIndex> wideIndices{};
+  std::span<const MeshLod> lods{};
+  std::span<const Meshlet> meshlets{};
+};
+
+SourceStamp getSourceStamp(const std::filesystem::path& path)
+{
+  std::error_code error;
+  const std::uintmax_t size = std::filesystem::file_size(path, error);
+  if (error)
+  {
+    return {};
+  }
+
+  const auto time = std::filesystem::last_write_time(path, error);
+  if (error)
+  {
+    return {};
+  }
+
+  return {
+    .size = size,
+    .time = static_cast<std::int64_t>(time.time_since_epoch().count()),
+    .valid = true,
+  };
+}
+
+bool readCache(std::span<const std::byte> bytes, const SourceStamp& stamp, bool useMeshlets, CachedMesh& outMesh)
+{
+  if (bytes.size() < sizeof(MeshCacheHeader))
+  {
+    return false;
+  }
+
+  MeshCacheHeader& header = outMesh.header;
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (
+    header.magic != CacheMagic || header.version != CacheVersion || header.sourceSize != stamp.size ||
+    header.sourceTime != stamp.time || header.vertexSize != sizeof(gpu::Vertex) || header.lodCount == 0 ||
+    header.lodCount > MAX_MESH_LODS)
+  {
+    return false;
+  }
+
+  // a large mesh cached in the other layout than asked for is rebuilt
+  const bool wide = header.indexSize == sizeof(gpu::WideIndex);
+  if (
+    (header.indexSize != sizeof(gpu::Index) && !wide) || (wide && (useMeshlets || header.meshletCount != 0)) ||
+    (header.meshletCount != 0 && !useMeshlets))
+  {
+    return false;
+  }
+
+  const std::size_t vertexBytes = std::size_t{header.vertexCount} * sizeof(gpu::Vertex);
+  const std::size_t indexBytes = std::size_t{header.indexCount} * header.indexSize;
+  const std::size_t meshletBytes = std::size_t{header.meshletCount} * sizeof(Meshlet);
+  if (bytes.size() != sizeof(MeshCacheHeader) + vertexBytes + indexBytes + meshletBytes)
+  {
+    return false;
+  }
+
+  const std::byte* vertexData = bytes.data() + sizeof(MeshCacheHeader);
+  const std::byte* indexData = vertexData + vertexBytes;
+  outMesh.vertices = {reinterpret_cast<const gpu::Vertex*>(vertexData), header.vertexCount};
+  if (wide)
+  {
+    outMesh.wideIndices = {reinterpret_cast<const gpu::WideIndex*>(indexData), header.indexCount};
+  }
+  else
+  {
+    outMesh.indices = {reinterpret_cast<const gpu::Index*>(indexData), header.indexCount};
+  }
+
+  if (header.meshletCount != 0)
+  {
+    outMesh.meshlets.resize(header.meshletCount);
+    std::memcpy(outMesh.meshlets.data(), indexData + indexBytes, meshletBytes);
+  }
+  return true;
+}
+
+bool writeCache(const std::filesystem::path& path, const SourceStamp& stamp, const MeshData& mesh)
+{
+  const bool wide = !mesh.wideIndices.empty();
+  const std::span<const std::byte> indexBytes = wide ? std::as_bytes(mesh.wideIndices) : std::as_bytes(mesh.indices);
+  const std::size_t indexSize = wide ? sizeof(gpu::WideIndex) : sizeof(gpu::Index);
+  MeshCacheHeader header{
+    .magic = CacheMagic,
+    .version = CacheVersion,
+    .sourceSize = stamp.size,
+    .sourceTime = stamp.time,
+    .vertexSize = sizeof(gpu::Vertex),
+    .indexSize = static_cast<std::uint32_t>(indexSize),
+    .vertexCount = static_cast<std::uint32_t>(mesh.vertices.size()),
+    .indexCount = static_cast<std::uint32_t>(indexBytes.size() / indexSize),
+    .lodCount = static_cast<std::uint32_t>(mesh.lods.size()),
+    .meshletCount = static_cast<std::uint32_t>(mesh.meshlets.size()),
+    .lods = {},
+  };
+  std::copy(mesh.lods.begin(), mesh.lods.end(), header.lods.begin());
+
+  // written next to the cache and renamed over it, so that a cache is never seen half written
+  std::filesystem::path temporaryPath = path;
+  temporaryPath += ".tmp";
+  {
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(
+      reinterpret_cast<const char*>(mesh.vertices.data()), static_cast<std::streamsize>(mesh.vertices.size_bytes()));
+    file.write(reinterpret_cast<const char*>(indexBytes.data()), static_cast<std::streamsize>(indexBytes.size()));
+    file.write(
+      reinterpret_cast<const char*>(mesh.meshlets.data()), static_cast<std::streamsize>(mesh.meshlets.size_bytes()));
+    if (!file.good())
+    {
+      file.close();
+      std::error_code error;
+      std::filesystem::remove(temporaryPath, error);
+      return false;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporaryPath, path, error);
+  return !error;
+}
+
+MeshHandle uploadMesh(MeshManager& meshManager, const MeshData& mesh)
+{
+  if (!mesh.meshlets.empty())
+  {
+    return meshManager.allocateMeshlets(mesh.vertices, mesh.indices, mesh.meshlets);
+  }
+  if (!mesh.wideIndices.empty())
+  {
+    return meshManager.allocate(mesh.vertices, mesh.wideIndices, mesh.lods);
+  }
+  return meshManager.allocate(mesh.vertices, mesh.indices, mesh.lods);
+}
+} // namespace
+
+MeshHandle loadCachedMesh(MeshManager& meshManager, const std::filesystem::path& objPath, bool useMeshlets)
+{
+  const std::filesystem::path cachePath = std::filesystem::path{objPath}.replace_extension(".mesh");
+  const SourceStamp stamp = getSourceStamp(objPath);
+  if (stamp.valid)
+  {
+    const MappedFile cache(cachePath);
+    CachedMesh mesh;
+    if (readCache(cache.getBytes(), stamp, useMeshlets, mesh))
+    {
+      return uploadMesh(
+        meshManager,
+        {
+          .vertices = mesh.vertices,
+          .indices = mesh.indices,
+          .wideIndices = mesh.wideIndices,
+          .lods = std::span{mesh.header.lods}.first(mesh.header.lodCount),
+          .meshlets = mesh.meshlets,
+        });
+    }
+  }
+
+  auto [vertices, wideIndices] = loadOBJ(objPath);
+  if (vertices.empty() || wideIndices.empty())
+  {
+    return {};
+  }
+
+  // 16-bit indices with levels of detail when they can address the mesh, otherwise meshlets or 32-bit indices. Each
+  // index range is reordered for the vertex cache and the vertices for fetching in that order, meshlets take both
+  // from the order of the triangles they are split from.
+  const VertexCacheStats statsBefore = analyzeVertexCache(wideIndices, vertices.size());
+  VertexCacheStats statsAfter;
+  std::vector<gpu::Index> indices;
+  std::vector<MeshLod> lods;
+  MeshletMesh meshletMesh;
+  MeshData mesh{.vertices = vertices};
+  if (vertices.size() <= gpu::MAX_INDEXED_VERTICES)
+  {
+    indices = narrowIndices(wideIndices);
+    lods = buildMeshLods(vertices, indices);
+    for (const MeshLod& lod : lods)
+    {
+      optimizeVertexCache(std::span{indices}.subspan(lod.firstIndex, lod.indexCount), vertices.size());
+    }
+    optimizeVertexFetch(vertices, indices);
+    statsAfter = analyzeVertexCache(std::span{indices}.first(lods[0].indexCount), vertices.size());
+    mesh.indices = indices;
+    mesh.lods = lods;
+  }
+  else if (useMeshlets)
+  {
+    optimizeVertexCache(wideIndices, vertices.size());
+    statsAfter = analyzeVertexCache(wideIndices, vertices.size());
+    meshletMesh = splitMeshlets(vertices, wideIndices);
+    lods = {{.firstIndex = 0, .indexCount = static_cast<Uint32>(meshletMesh.indices.size())}};
+    mesh = {
+      .vertices = meshletMesh.vertices,
+      .indices = meshletMesh.indices,
+      .lods = lods,
+      .meshlets = meshletMesh.meshlets,
+    };
+  }
+  else
+  {
+    optimizeVertexCache(wideIndices, vertices.size());
+    optimizeVertexFetch(vertices, wideIndices);
+    statsAfter = analyzeVertexCache(wideIndices, vertices.size());
+    lods = {{.firstIndex = 0, .indexCount = static_cast<Uint32>(wideIndices.size())}};
+    mesh.wideIndices = wideIndices;
+    mesh.lods = lods;
+  }
+
+  SDL_Log(
+    "Optimized %s for the vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+    objPath.c_str(),
+    statsBefore.acmr,
+    statsAfter.acmr,
+    statsBefore.atvr,
+    statsAfter.atvr);
+
+  if (stamp.valid && !writeCache(cachePath, stamp, mesh))
+  {
+    SDL_Log("Failed to write mesh cache %s", cachePath.c_str());
+  }
+
+  return uploadMesh(meshManager, mesh);
+}
+
+} // namespace flb
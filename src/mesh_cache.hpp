@@ -0,0 +1,24 @@
+#pragma once
+
+#include "mesh_manager.hpp"
+
+#include <filesystem>
+
+namespace flb
+{
+
+/**
+ * Loads the mesh of an OBJ file together with its levels of detail through a binary cache next to it, the OBJ path
+ * with the extension replaced by ".mesh".
+ *
+ * The cache is a header followed by the vertex and index arrays exactly as they are uploaded, so a valid cache is
+ * memory mapped and copied into the upload buffers without any parsing. It is rebuilt from the OBJ when it is missing,
+ * was written by a different version or vertex layout, or the size or modification time of the OBJ changed. Failing
+ * to write the cache only costs the next startup another parse.
+ *
+ * Meshes that 16-bit indices can address get levels of detail. Larger ones are drawn at full detail, either with 32-bit
+ * indices or, with useMeshlets, split into meshlets that keep 16-bit indices at the cost of copying shared vertices.
+ */
+MeshHandle loadCachedMesh(MeshManager& meshManager, const std::filesystem::path& objPath, bool useMeshlets = false);
+
+} // namespace flb
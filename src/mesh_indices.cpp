@@ -0,0 +1,91 @@
+#include "mesh_indices.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace flb
+{
+
+std::vector<gpu::Index> narrowIndices(std::span<const gpu::WideIndex> indices)
+{
+  std::vector<gpu::Index> result;
+  result.reserve(indices.size());
+  for (const gpu::WideIndex index : indices)
+  {
+    if (index > std::numeric_limits<gpu::Index>::max())
+    {
+      return {};
+    }
+    result.push_back(static_cast<gpu::Index>(index));
+  }
+  return result;
+}
+
+MeshletMesh splitMeshlets(
+  std::span<const gpu::Vertex> vertices, std::span<const gpu::WideIndex> indices, std::size_t maxMeshletVertices)
+{
+  constexpr std::uint32_t NoMeshlet = std::numeric_limits<std::uint32_t>::max();
+
+  MeshletMesh result;
+  maxMeshletVertices = std::clamp<std::size_t>(maxMeshletVertices, 3, gpu::MAX_INDEXED_VERTICES);
+  result.vertices.reserve(vertices.size());
+  result.indices.reserve(indices.size());
+
+  // meshlet a source vertex was last copied into and its index there, so that no array is cleared between meshlets
+  std::vector<std::uint32_t> vertexMeshlet(vertices.size(), NoMeshlet);
+  std::vector<gpu::Index> localIndex(vertices.size());
+
+  Meshlet meshlet{};
+  std::uint32_t meshletId = 0;
+  std::size_t meshletVertices = 0;
+  for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+  {
+    const std::array<gpu::WideIndex, 3> triangle{indices[i], indices[i + 1], indices[i + 2]};
+    if (triangle[0] >= vertices.size() || triangle[1] >= vertices.size() || triangle[2] >= vertices.size())
+    {
+      continue;
+    }
+
+    std::size_t newVertices = 0;
+    for (std::size_t corner = 0; corner < 3; ++corner)
+    {
+      const bool repeated = (corner > 0 && triangle[corner] == triangle[0]) ||
+                            (corner > 1 && triangle[corner] == triangle[1]);
+      newVertices += !repeated && vertexMeshlet[triangle[corner]] != meshletId;
+    }
+
+    if (meshletVertices + newVertices > maxMeshletVertices)
+    {
+      result.meshlets.push_back(meshlet);
+      ++meshletId;
+      meshlet = {
+        .firstIndex = static_cast<Uint32>(result.indices.size()),
+        .indexCount = 0,
+        .vertexOffset = static_cast<Sint32>(result.vertices.size()),
+      };
+      meshletVertices = 0;
+    }
+
+    for (const gpu::WideIndex vertex : triangle)
+    {
+      if (vertexMeshlet[vertex] != meshletId)
+      {
+        vertexMeshlet[vertex] = meshletId;
+        localIndex[vertex] = static_cast<gpu::Index>(meshletVertices++);
+        result.vertices.push_back(vertices[vertex]);
+      }
+      result.indices.push_back(localIndex[vertex]);
+    }
+    meshlet.indexCount += 3;
+  }
+
+  if (meshlet.indexCount > 0)
+  {
+    result.meshlets.push_back(meshlet);
+  }
+  return result;
+}
+
+} // namespace flb
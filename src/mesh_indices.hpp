@@ -0,0 +1,38 @@
+#pragma once
+
+#include "gpu/pipeline.hpp"
+#include "mesh_manager.hpp"
+
+#include <span>
+#include <vector>
+
+namespace flb
+{
+
+/**
+ * Vertices and 16-bit indices of a mesh split into meshlets.
+ */
+struct MeshletMesh
+{
+  std::vector<gpu::Vertex> vertices;
+  std::vector<gpu::Index> indices;
+  std::vector<Meshlet> meshlets;
+};
+
+/**
+ * Copies 32-bit indices into 16-bit ones. Returns an empty array if any index doesn't fit.
+ */
+std::vector<gpu::Index> narrowIndices(std::span<const gpu::WideIndex> indices);
+
+/**
+ * Splits a triangle list into meshlets of at most maxMeshletVertices vertices, so that a mesh of any size can be drawn
+ * with 16-bit indices. Triangles keep their order and are added to the current meshlet until the next one would take
+ * it over the limit. Vertices used by several meshlets are copied into each of them, which keeps the vertices of a
+ * meshlet contiguous at its vertex offset.
+ */
+MeshletMesh splitMeshlets(
+  std::span<const gpu::Vertex> vertices,
+  std::span<const gpu::WideIndex> indices,
+  std::size_t maxMeshletVertices = gpu::MAX_INDEXED_VERTICES);
+
+} // namespace flb
@@ -3,7 +3,12 @@
 #include "gpu/allocator.hpp"
 #include "gpu/pipeline.hpp"
 
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <limits>
@@ -25,11 +30,58 @@ struct MeshHandle
   bool operator==(const MeshHandle& other) const = default;
 };
 
+/**
+ * Range of the index buffer that draws one level of detail. error is the largest distance, in model space, by which the
+ * simplified surface deviates from the full detail one.
+ */
+struct MeshLod
+{
+  Uint32 firstIndex = 0;
+  Uint32 indexCount = 0;
+  float error = 0.0f;
+};
+
+static constexpr std::size_t MAX_MESH_LODS = 4;
+
+/**
+ * Part of a mesh with more vertices than 16-bit indices can address. Its indices are relative to vertexOffset, so each
+ * part addresses its own window of the shared vertex buffer.
+ */
+struct Meshlet
+{
+  Uint32 firstIndex = 0;
+  Uint32 indexCount = 0;
+  Sint32 vertexOffset = 0;
+};
+
 struct Mesh
 {
   gpu::BufferHandle vertexBuffer{};
   gpu::BufferHandle indexBuffer{};
+  SDL_GPUIndexElementSize indexElementSize = SDL_GPU_INDEXELEMENTSIZE_16BIT;
+  // index count of the full detail level
   Uint32 indexCount = 0;
+  // bounding sphere of the vertices in model space
+  glm::vec3 boundsCenter{0.0f};
+  float boundsRadius = 0.0f;
+  // levels of detail sharing the vertex buffer, from full detail to coarsest
+  std::array<MeshLod, MAX_MESH_LODS> lods{};
+  Uint32 lodCount = 0;
+  // when not empty the mesh is drawn as these parts, owned by the MeshManager, instead of by levels of detail
+  std::span<const Meshlet> meshlets{};
+
+  /**
+   * Coarsest level of detail whose error doesn't exceed maxError.
+   */
+  const MeshLod& getLod(float maxError) const
+  {
+    Uint32 lod = 0;
+    while (lod + 1 < lodCount && lods[lod + 1].error <= maxError)
+    {
+      ++lod;
+    }
+    return lods[lod];
+  }
 };
 
 class MeshManager
@@ -37,48 +89,57 @@ class MeshManager
 public:
   void init(gpu::Allocator* allocator_) { allocator = allocator_; }
 
-  MeshHandle allocate(std::span<const gpu::Vertex> vertices, std::span<const gpu::Index> indices)
+  /**
+   * Uploads a mesh with 16-bit indices. lods are ranges of indices ordered from full detail to coarsest, when empty all
+   * indices form a single level.
+   */
+  MeshHandle allocate(
+    std::span<const gpu::Vertex> vertices, std::span<const gpu::Index> indices, std::span<const MeshLod> lods = {})
   {
-    if (vertices.empty() || indices.empty())
+    if (!isValidLods(indices.size(), lods) || !isValidIndices(indices, vertices.size()))
       return {};
 
-    if (
-      vertices.size_bytes() > std::numeric_limits<Uint32>::max() ||
-      indices.size_bytes() > std::numeric_limits<Uint32>::max())
-    {
+    return upload(vertices, std::as_bytes(indices), SDL_GPU_INDEXELEMENTSIZE_16BIT, lods, {});
+  }
+
+  /**
+   * Uploads a mesh with 32-bit indices, for meshes with more vertices than 16-bit indices can address.
+   */
+  MeshHandle allocate(
+    std::span<const gpu::Vertex> vertices, std::span<const gpu::WideIndex> indices, std::span<const MeshLod> lods = {})
+  {
+    if (!isValidLods(indices.size(), lods) || !isValidIndices(indices, vertices.size()))
       return {};
-    }
 
-    Mesh mesh{
-      .vertexBuffer = allocator->createVertexBuffer(static_cast<Uint32>(vertices.size_bytes())),
-      .indexBuffer = allocator->createIndexBuffer(static_cast<Uint32>(indices.size_bytes())),
-      .indexCount = static_cast<Uint32>(indices.size()),
-    };
+    return upload(vertices, std::as_bytes(indices), SDL_GPU_INDEXELEMENTSIZE_32BIT, lods, {});
+  }
 
-    if (mesh.vertexBuffer.buffer == nullptr || mesh.indexBuffer.buffer == nullptr)
-    {
-      releaseMesh(mesh);
+  /**
+   * Uploads a mesh split into meshlets, each a range of 16-bit indices relative to its vertex offset. The mesh has a
+   * single level of detail.
+   */
+  MeshHandle allocateMeshlets(
+    std::span<const gpu::Vertex> vertices, std::span<const gpu::Index> indices, std::span<const Meshlet> meshlets)
+  {
+    if (meshlets.empty() || vertices.size() > std::size_t{std::numeric_limits<Sint32>::max()})
       return {};
-    }
 
-    const std::span<std::byte> vertexMemory = allocator->allocateBuffer(mesh.vertexBuffer);
-    const std::span<std::byte> indexMemory = allocator->allocateBuffer(mesh.indexBuffer);
-    if (vertexMemory.empty() || indexMemory.empty())
+    for (const Meshlet& meshlet : meshlets)
     {
-      releaseMesh(mesh);
-      return {};
+      if (
+        meshlet.indexCount == 0 || meshlet.firstIndex > indices.size() ||
+        meshlet.indexCount > indices.size() - meshlet.firstIndex || meshlet.vertexOffset < 0 ||
+        static_cast<std::size_t>(meshlet.vertexOffset) >= vertices.size())
+      {
+        return {};
+      }
+
+      const std::size_t meshletVertices = vertices.size() - static_cast<std::size_t>(meshlet.vertexOffset);
+      if (!isValidIndices(indices.subspan(meshlet.firstIndex, meshlet.indexCount), meshletVertices))
+        return {};
     }
 
-    std::memcpy(vertexMemory.data(), vertices.data(), mesh.vertexBuffer.size);
-    std::memcpy(indexMemory.data(), indices.data(), mesh.indexBuffer.size);
-
-    const std::uint32_t index = getFreeSlot();
-
-    Slot& slot = pool[index];
-    slot.mesh = mesh;
-    slot.refCount = 1;
-
-    return {index, slot.generation};
+    return upload(vertices, std::as_bytes(indices), SDL_GPU_INDEXELEMENTSIZE_16BIT, {}, meshlets);
   }
 
   void addRef(MeshHandle handle)
@@ -114,6 +175,7 @@ public:
     releaseMesh(slot->mesh);
 
     slot->mesh = {};
+    slot->meshlets.clear();
     bumpGeneration(*slot);
 
     freeSlots.push_back(handle.index);
@@ -123,6 +185,7 @@ private:
   struct Slot
   {
     Mesh mesh{};
+    std::vector<Meshlet> meshlets;
     std::uint32_t generation = 1;
     std::uint32_t refCount = 0;
   };
@@ -132,6 +195,115 @@ private:
   std::vector<Slot> pool;
   std::vector<std::uint32_t> freeSlots;
 
+  template <typename IndexT>
+  static bool isValidIndices(std::span<const IndexT> indices, std::size_t vertexCount)
+  {
+    IndexT maxIndex = 0;
+    for (const IndexT index : indices)
+    {
+      maxIndex = std::max(maxIndex, index);
+    }
+    return !indices.empty() && maxIndex < vertexCount;
+  }
+
+  static bool isValidLods(std::size_t indexCount, std::span<const MeshLod> lods)
+  {
+    if (lods.size() > MAX_MESH_LODS)
+      return false;
+
+    for (const MeshLod& lod : lods)
+    {
+      if (lod.indexCount == 0 || lod.firstIndex > indexCount || lod.indexCount > indexCount - lod.firstIndex)
+        return false;
+    }
+    return true;
+  }
+
+  MeshHandle upload(
+    std::span<const gpu::Vertex> vertices,
+    std::span<const std::byte> indexBytes,
+    SDL_GPUIndexElementSize indexElementSize,
+    std::span<const MeshLod> lods,
+    std::span<const Meshlet> meshlets)
+  {
+    if (
+      vertices.empty() || indexBytes.empty() || vertices.size_bytes() > std::numeric_limits<Uint32>::max() ||
+      indexBytes.size() > std::numeric_limits<Uint32>::max())
+    {
+      return {};
+    }
+
+    const std::size_t indexSize = indexElementSize == SDL_GPU_INDEXELEMENTSIZE_32BIT ? 4 : 2;
+    Mesh mesh{
+      .vertexBuffer = allocator->createVertexBuffer(static_cast<Uint32>(vertices.size_bytes())),
+      .indexBuffer = allocator->createIndexBuffer(static_cast<Uint32>(indexBytes.size())),
+      .indexElementSize = indexElementSize,
+      .indexCount = lods.empty() ? static_cast<Uint32>(indexBytes.size() / indexSize) : lods[0].indexCount,
+    };
+    computeBounds(vertices, mesh);
+    if (lods.empty())
+    {
+      mesh.lods[0] = {.firstIndex = 0, .indexCount = mesh.indexCount};
+      mesh.lodCount = 1;
+    }
+    else
+    {
+      std::copy(lods.begin(), lods.end(), mesh.lods.begin());
+      mesh.lodCount = static_cast<Uint32>(lods.size());
+    }
+
+    if (mesh.vertexBuffer.buffer == nullptr || mesh.indexBuffer.buffer == nullptr)
+    {
+      releaseMesh(mesh);
+      return {};
+    }
+
+    const std::span<std::byte> vertexMemory = allocator->allocateBuffer(mesh.vertexBuffer);
+    const std::span<std::byte> indexMemory = allocator->allocateBuffer(mesh.indexBuffer);
+    if (vertexMemory.empty() || indexMemory.empty())
+    {
+      releaseMesh(mesh);
+      return {};
+    }
+
+    std::memcpy(vertexMemory.data(), vertices.data(), mesh.vertexBuffer.size);
+    std::memcpy(indexMemory.data(), indexBytes.data(), mesh.indexBuffer.size);
+
+    const std::uint32_t index = getFreeSlot();
+
+    Slot& slot = pool[index];
+    // the span stays valid when the pool grows, moving the vector keeps its storage
+    slot.meshlets.assign(meshlets.begin(), meshlets.end());
+    mesh.meshlets = slot.meshlets;
+    slot.mesh = mesh;
+    slot.refCount = 1;
+
+    return {index, slot.generation};
+  }
+
+  /**
+   * Sphere around the center of the bounding box, not minimal but tight enough for culling.
+   */
+  static void computeBounds(std::span<const gpu::Vertex> vertices, Mesh& mesh)
+  {
+    glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+    glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+    for (const gpu::Vertex& vertex : vertices)
+    {
+      boundsMin = glm::min(boundsMin, vertex.position);
+      boundsMax = glm::max(boundsMax, vertex.position);
+    }
+
+    mesh.boundsCenter = 0.5f * (boundsMin + boundsMax);
+    float radius2 = 0.0f;
+    for (const gpu::Vertex& vertex : vertices)
+    {
+      const glm::vec3 offset = vertex.position - mesh.boundsCenter;
+      radius2 = std::max(radius2, glm::dot(offset, offset));
+    }
+    mesh.boundsRadius = std::sqrt(radius2);
+  }
+
   void releaseMesh(const Mesh& mesh)
   {
     allocator->releaseBuffer(mesh.vertexBuffer.buffer);
@@ -0,0 +1,279 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace flb
+{
+namespace
+{
+constexpr std::uint32_t NoTriangle = std::numeric_limits<std::uint32_t>::max();
+constexpr std::uint32_t NoVertex = std::numeric_limits<std::uint32_t>::max();
+
+// scores model an LRU cache larger than real FIFO caches, which Forsyth found to work well across hardware
+constexpr std::size_t ScoreCacheSize = 32;
+constexpr float CacheDecayPower = 1.5f;
+// the vertices of the last triangle score a bit lower than the next entries, which discourages strip-like orders
+constexpr float LastTriangleScore = 0.75f;
+constexpr float ValenceBoostScale = 2.0f;
+constexpr float ValenceBoostPower = 0.5f;
+// valences up to this use a precomputed score
+constexpr std::size_t MaxTableValence = 32;
+
+/**
+ * Vertex scores by cache position and by the number of triangles still using the vertex.
+ */
+struct ScoreTables
+{
+  std::array<float, ScoreCacheSize> cache{};
+  std::array<float, MaxTableValence + 1> valence{};
+
+  ScoreTables()
+  {
+    std::fill_n(cache.begin(), 3, LastTriangleScore);
+    for (std::size_t i = 3; i < ScoreCacheSize; ++i)
+    {
+      const float decay = 1.0f - static_cast<float>(i - 3) / static_cast<float>(ScoreCacheSize - 3);
+      cache[i] = std::pow(decay, CacheDecayPower);
+    }
+    for (std::size_t i = 1; i <= MaxTableValence; ++i)
+    {
+      valence[i] = getValenceScore(static_cast<std::uint32_t>(i));
+    }
+  }
+
+  static float getValenceScore(std::uint32_t remaining)
+  {
+    return ValenceBoostScale * std::pow(static_cast<float>(remaining), -ValenceBoostPower);
+  }
+
+  float getScore(std::int32_t cachePosition, std::uint32_t remaining) const
+  {
+    if (remaining == 0)
+    {
+      return -1.0f;
+    }
+
+    const float valenceScore = remaining <= MaxTableValence ? valence[remaining] : getValenceScore(remaining);
+    return (cachePosition >= 0 ? cache[static_cast<std::size_t>(cachePosition)] : 0.0f) + valenceScore;
+  }
+};
+
+template <typename IndexT>
+VertexCacheStats analyze(std::span<const IndexT> indices, std::size_t vertexCount)
+{
+  // a vertex is in the FIFO while fewer than its size misses happened since it was added
+  constexpr std::uint32_t CacheSize = VertexCacheStats::VERTEX_CACHE_SIZE;
+  std::vector<std::uint32_t> addedAt(vertexCount, 0);
+  std::uint32_t time = CacheSize + 1;
+  std::size_t misses = 0;
+  std::size_t referenced = 0;
+  for (const IndexT index : indices)
+  {
+    if (index >= vertexCount)
+    {
+      continue;
+    }
+
+    referenced += addedAt[index] == 0;
+    if (time - addedAt[index] > CacheSize)
+    {
+      addedAt[index] = time++;
+      ++misses;
+    }
+  }
+
+  const std::size_t triangleCount = indices.size() / 3;
+  return {
+    .acmr = triangleCount > 0 ? static_cast<float>(misses) / static_cast<float>(triangleCount) : 0.0f,
+    .atvr = referenced > 0 ? static_cast<float>(misses) / static_cast<float>(referenced) : 0.0f,
+  };
+}
+
+template <typename IndexT>
+void optimizeCache(std::span<IndexT> indices, std::size_t vertexCount)
+{
+  static const ScoreTables scores;
+
+  const std::size_t triangleCount = indices.size() / 3;
+  if (triangleCount < 2)
+  {
+    return;
+  }
+
+  // triangles of each vertex, the first remaining[v] of them not emitted yet
+  std::vector<std::uint32_t> triangleStart(vertexCount + 1, 0);
+  for (std::size_t i = 0; i < triangleCount * 3; ++i)
+  {
+    ++triangleStart[indices[i] + 1];
+  }
+  for (std::size_t v = 0; v < vertexCount; ++v)
+  {
+    triangleStart[v + 1] += triangleStart[v];
+  }
+
+  std::vector<std::uint32_t> remaining(vertexCount, 0);
+  std::vector<std::uint32_t> vertexTriangles(triangleCount * 3);
+  for (std::size_t i = 0; i < triangleCount * 3; ++i)
+  {
+    const IndexT v = indices[i];
+    vertexTriangles[triangleStart[v] + remaining[v]++] = static_cast<std::uint32_t>(i / 3);
+  }
+
+  std::vector<std::int32_t> cachePosition(vertexCount, -1);
+  std::vector<float> vertexScore(vertexCount);
+  for (std::size_t v = 0; v < vertexCount; ++v)
+  {
+    vertexScore[v] = scores.getScore(-1, remaining[v]);
+  }
+
+  const auto getTriangleScore = [&](std::uint32_t t)
+  {
+    return vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+  };
+
+  std::vector<bool> emitted(triangleCount, false);
+  std::uint32_t best = 0;
+  for (std::uint32_t t = 1; t < triangleCount; ++t)
+  {
+    if (getTriangleScore(t) > getTriangleScore(best))
+    {
+      best = t;
+    }
+  }
+
+  std::vector<IndexT> result;
+  result.reserve(triangleCount * 3);
+  std::array<std::uint32_t, ScoreCacheSize + 3> cache{};
+  std::array<std::uint32_t, ScoreCacheSize + 3> nextCache{};
+  std::size_t cacheCount = 0;
+  std::size_t cursor = 0;
+  for (std::size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+  {
+    // no triangle touches the cache any more, continue with the next one in input order
+    if (best == NoTriangle)
+    {
+      while (emitted[cursor])
+      {
+        ++cursor;
+      }
+      best = static_cast<std::uint32_t>(cursor);
+    }
+
+    const std::array<std::uint32_t, 3> corners{indices[3 * best], indices[3 * best + 1], indices[3 * best + 2]};
+    result.insert(result.end(), corners.begin(), corners.end());
+    emitted[best] = true;
+
+    std::size_t nextCount = 0;
+    for (const std::uint32_t v : corners)
+    {
+      std::uint32_t* triangles = vertexTriangles.data() + triangleStart[v];
+      std::swap(*std::find(triangles, triangles + remaining[v], best), triangles[remaining[v] - 1]);
+      --remaining[v];
+
+      if (std::find(nextCache.begin(), nextCache.begin() + nextCount, v) == nextCache.begin() + nextCount)
+      {
+        nextCache[nextCount++] = v;
+      }
+    }
+    for (std::size_t i = 0; i < cacheCount; ++i)
+    {
+      if (cache[i] != corners[0] && cache[i] != corners[1] && cache[i] != corners[2])
+      {
+        nextCache[nextCount++] = cache[i];
+      }
+    }
+
+    // rescore the vertices in the cache and those that just fell out, then the triangles using them
+    for (std::size_t i = 0; i < nextCount; ++i)
+    {
+      const std::uint32_t v = nextCache[i];
+      cachePosition[v] = i < ScoreCacheSize ? static_cast<std::int32_t>(i) : -1;
+      vertexScore[v] = scores.getScore(cachePosition[v], remaining[v]);
+    }
+
+    best = NoTriangle;
+    float bestScore = 0.0f;
+    for (std::size_t i = 0; i < nextCount; ++i)
+    {
+      const std::uint32_t v = nextCache[i];
+      const std::uint32_t* triangles = vertexTriangles.data() + triangleStart[v];
+      for (std::uint32_t j = 0; j < remaining[v]; ++j)
+      {
+        const float score = getTriangleScore(triangles[j]);
+        if (score > bestScore)
+        {
+          best = triangles[j];
+          bestScore = score;
+        }
+      }
+    }
+
+    cacheCount = std::min(nextCount, ScoreCacheSize);
+    std::copy(nextCache.begin(), nextCache.begin() + cacheCount, cache.begin());
+  }
+
+  std::copy(result.begin(), result.end(), indices.begin());
+}
+
+template <typename IndexT>
+void optimizeFetch(std::span<gpu::Vertex> vertices, std::span<IndexT> indices)
+{
+  std::vector<std::uint32_t> remap(vertices.size(), NoVertex);
+  std::uint32_t nextVertex = 0;
+  for (IndexT& index : indices)
+  {
+    if (remap[index] == NoVertex)
+    {
+      remap[index] = nextVertex++;
+    }
+    index = static_cast<IndexT>(remap[index]);
+  }
+
+  const std::vector<gpu::Vertex> original(vertices.begin(), vertices.end());
+  for (std::size_t v = 0; v < original.size(); ++v)
+  {
+    if (remap[v] == NoVertex)
+    {
+      remap[v] = nextVertex++;
+    }
+    vertices[remap[v]] = original[v];
+  }
+}
+} // namespace
+
+VertexCacheStats analyzeVertexCache(std::span<const gpu::Index> indices, std::size_t vertexCount)
+{
+  return analyze(indices, vertexCount);
+}
+
+VertexCacheStats analyzeVertexCache(std::span<const gpu::WideIndex> indices, std::size_t vertexCount)
+{
+  return analyze(indices, vertexCount);
+}
+
+void optimizeVertexCache(std::span<gpu::Index> indices, std::size_t vertexCount)
+{
+  optimizeCache(indices, vertexCount);
+}
+
+void optimizeVertexCache(std::span<gpu::WideIndex> indices, std::size_t vertexCount)
+{
+  optimizeCache(indices, vertexCount);
+}
+
+void optimizeVertexFetch(std::span<gpu::Vertex> vertices, std::span<gpu::Index> indices)
+{
+  optimizeFetch(vertices, indices);
+}
+
+void optimizeVertexFetch(std::span<gpu::Vertex> vertices, std::span<gpu::WideIndex> indices)
+{
+  optimizeFetch(vertices, indices);
+}
+
+} // namespace flb
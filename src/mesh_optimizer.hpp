@@ -0,0 +1,42 @@
+#pragma once
+
+#include "gpu/pipeline.hpp"
+
+#include <cstddef>
+#include <span>
+
+namespace flb
+{
+
+/**
+ * How well an index order uses the post-transform vertex cache, simulated as a FIFO of VERTEX_CACHE_SIZE entries.
+ * acmr is the number of vertex shader invocations per triangle, 0.5 at best for large regular meshes and 3 at worst.
+ * atvr is the number of invocations per referenced vertex, 1 at best.
+ */
+struct VertexCacheStats
+{
+  static constexpr std::size_t VERTEX_CACHE_SIZE = 16;
+
+  float acmr = 0.0f;
+  float atvr = 0.0f;
+};
+
+VertexCacheStats analyzeVertexCache(std::span<const gpu::Index> indices, std::size_t vertexCount);
+VertexCacheStats analyzeVertexCache(std::span<const gpu::WideIndex> indices, std::size_t vertexCount);
+
+/**
+ * Reorders the triangles of a triangle list for the post-transform vertex cache with Forsyth's linear speed algorithm,
+ * which greedily emits the triangle whose vertices score highest by their position in a simulated LRU cache and by how
+ * few triangles still use them. Triangles keep their winding. Indices must be below vertexCount.
+ */
+void optimizeVertexCache(std::span<gpu::Index> indices, std::size_t vertexCount);
+void optimizeVertexCache(std::span<gpu::WideIndex> indices, std::size_t vertexCount);
+
+/**
+ * Reorders vertices into the order indices first use them, so that vertex fetches walk through memory, and rewrites
+ * indices to match. Vertices no index uses are moved to the end.
+ */
+void optimizeVertexFetch(std::span<gpu::Vertex> vertices, std::span<gpu::Index> indices);
+void optimizeVertexFetch(std::span<gpu::Vertex> vertices, std::span<gpu::WideIndex> indices);
+
+} // namespace flb
@@ -0,0 +1,625 @@
+#include "mesh_simplifier.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace flb
+{
+namespace
+{
+constexpr std::uint32_t NoVertex = std::numeric_limits<std::uint32_t>::max();
+// planes along open borders outweigh surface planes, so that the outline of an open mesh survives
+constexpr double BorderWeight = 10.0;
+// a collapse may not tilt a triangle further than this, cosine of the angle between old and new normal
+constexpr double MinNormalDot = 0.25;
+// a pass ends at the cost limit only after collapses for 1 / MinPassShare of its triangle goal
+constexpr std::size_t MinPassShare = 16;
+// a level of detail has to drop at least this share of the triangles of the previous one to be kept
+constexpr double MinLodReduction = 0.2;
+
+/**
+ * Sum of squared distances to a set of weighted planes, as a symmetric 4x4 matrix.
+ */
+struct Quadric
+{
+  double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+  double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+  double a22 = 0.0, a23 = 0.0;
+  double a33 = 0.0;
+  double weight = 0.0;
+
+  static Quadric fromPlane(const glm::dvec3& normal, double distance, double weight)
+  {
+    const glm::dvec3 n = normal * weight;
+    return {
+      .a00 = n.x * normal.x,
+      .a01 = n.x * normal.y,
+      .a02 = n.x * normal.z,
+      .a03 = n.x * distance,
+      .a11 = n.y * normal.y,
+      .a12 = n.y * normal.z,
+      .a13 = n.y * distance,
+      .a22 = n.z * normal.z,
+      .a23 = n.z * distance,
+      .a33 = weight * distance * distance,
+      .weight = weight,
+    };
+  }
+
+  Quadric& operator+=(const Quadric& other)
+  {
+    a00 += other.a00;
+    a01 += other.a01;
+    a02 += other.a02;
+    a03 += other.a03;
+    a11 += other.a11;
+    a12 += other.a12;
+    a13 += other.a13;
+    a22 += other.a22;
+    a23 += other.a23;
+    a33 += other.a33;
+    weight += other.weight;
+    return *this;
+  }
+
+  /**
+   * Weighted mean squared distance of point to the planes.
+   */
+  double evaluate(const glm::dvec3& p) const
+  {
+    const double sum = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z +
+                       2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z) +
+                       2.0 * (a03 * p.x + a13 * p.y + a23 * p.z) + a33;
+    return weight > 0.0 ? glm::abs(sum) / weight : 0.0;
+  }
+};
+
+enum class VertexKind : std::uint8_t
+{
+  Manifold,
+  Border,
+  Locked,
+};
+
+/**
+ * Edge collapse in passes. Each pass sorts the collapses of all edges by cost and performs the cheapest ones, locking
+ * the neighbourhood of every collapse so that the validity checks of later collapses in the pass stay exact.
+ *
+ * Vertices with equal positions form a position class, and quadrics, borders and collapses work on those classes.
+ * Collapsing class A onto class B moves every vertex of A onto a vertex of B it shares an edge with, or else one with
+ * the same uv, which keeps the texture on either side of a seam apart.
+ */
+class Simplifier
+{
+public:
+  Simplifier(std::span<const gpu::Vertex> vertices, std::span<const gpu::Index> indices)
+      : vertices(vertices), result(indices.begin(), indices.end() - indices.size() % 3)
+  {
+    buildPositionClasses();
+    buildQuadrics();
+
+    remap.resize(vertices.size());
+    for (std::uint32_t v = 0; v < remap.size(); ++v)
+    {
+      remap[v] = v;
+    }
+  }
+
+  double run(std::size_t targetIndexCount)
+  {
+    double maxCost = 0.0;
+    while (result.size() > targetIndexCount)
+    {
+      buildAdjacency();
+      buildCollapses();
+
+      const std::size_t triangleGoal = (result.size() - targetIndexCount) / 3;
+      if (collapseEdges(triangleGoal, maxCost) == 0)
+      {
+        break;
+      }
+      compact();
+    }
+    return glm::sqrt(maxCost);
+  }
+
+  std::vector<gpu::Index> takeResult() { return std::move(result); }
+
+private:
+  struct Edge
+  {
+    std::uint32_t a;
+    std::uint32_t b;
+  };
+
+  struct Collapse
+  {
+    std::uint32_t from;
+    std::uint32_t to;
+    double cost;
+  };
+
+  std::uint32_t getClass(std::uint32_t corner) const { return vertexClass[result[corner]]; }
+
+  void buildPositionClasses()
+  {
+    classVertices.resize(vertices.size());
+    for (std::uint32_t v = 0; v < classVertices.size(); ++v)
+    {
+      classVertices[v] = v;
+    }
+
+    const auto lessPosition = [this](std::uint32_t left, std::uint32_t right)
+    {
+      const glm::vec3& a = vertices[left].position;
+      const glm::vec3& b = vertices[right].position;
+      return a.x != b.x ? a.x < b.x : (a.y != b.y ? a.y < b.y : a.z < b.z);
+    };
+    std::sort(classVertices.begin(), classVertices.end(), lessPosition);
+
+    vertexClass.resize(vertices.size());
+    for (std::uint32_t i = 0; i < classVertices.size(); ++i)
+    {
+      const std::uint32_t v = classVertices[i];
+      if (i == 0 || vertices[classVertices[i - 1]].position != vertices[v].position)
+      {
+        classStart.push_back(i);
+        classPosition.emplace_back(vertices[v].position);
+      }
+      vertexClass[v] = static_cast<std::uint32_t>(classStart.size() - 1);
+    }
+    classStart.push_back(static_cast<std::uint32_t>(classVertices.size()));
+  }
+
+  void buildQuadrics()
+  {
+    classQuadric.assign(classPosition.size(), {});
+
+    std::vector<std::pair<Edge, std::uint32_t>> edges;
+    edges.reserve(result.size());
+    for (std::uint32_t t = 0; t < result.size() / 3; ++t)
+    {
+      const glm::dvec3 normal = getTriangleNormal(t);
+      const double area = 0.5 * glm::length(normal);
+      if (area == 0.0)
+      {
+        continue;
+      }
+
+      const glm::dvec3 unitNormal = normal / (2.0 * area);
+      const glm::dvec3& origin = classPosition[getClass(t * 3)];
+      const Quadric quadric = Quadric::fromPlane(unitNormal, -glm::dot(unitNormal, origin), area);
+      for (std::uint32_t k = 0; k < 3; ++k)
+      {
+        classQuadric[getClass(t * 3 + k)] += quadric;
+
+        const std::uint32_t a = getClass(t * 3 + k);
+        const std::uint32_t b = getClass(t * 3 + (k + 1) % 3);
+        edges.push_back({{std::min(a, b), std::max(a, b)}, t});
+      }
+    }
+
+    // edges of a single triangle are open borders, add a plane through them perpendicular to the surface
+    std::sort(
+      edges.begin(),
+      edges.end(),
+      [](const auto& left, const auto& right)
+      { return left.first.a != right.first.a ? left.first.a < right.first.a : left.first.b < right.first.b; });
+    for (std::size_t i = 0; i < edges.size();)
+    {
+      std::size_t end = i + 1;
+      while (end < edges.size() && edges[end].first.a == edges[i].first.a && edges[end].first.b == edges[i].first.b)
+      {
+        ++end;
+      }
+
+      const Edge edge = edges[i].first;
+      if (end - i == 1 && edge.a != edge.b)
+      {
+        const glm::dvec3 direction = classPosition[edge.b] - classPosition[edge.a];
+        const glm::dvec3 surfaceNormal = glm::normalize(getTriangleNormal(edges[i].second));
+        const glm::dvec3 planeNormal = glm::cross(direction, surfaceNormal);
+        const double length = glm::length(planeNormal);
+        if (length > 0.0)
+        {
+          const glm::dvec3 unitNormal = planeNormal / length;
+          const Quadric quadric = Quadric::fromPlane(
+            unitNormal, -glm::dot(unitNormal, classPosition[edge.a]), BorderWeight * glm::dot(direction, direction));
+          classQuadric[edge.a] += quadric;
+          classQuadric[edge.b] += quadric;
+        }
+      }
+      i = end;
+    }
+  }
+
+  glm::dvec3 getTriangleNormal(std::uint32_t triangle) const
+  {
+    const glm::dvec3& p0 = classPosition[getClass(triangle * 3)];
+    const glm::dvec3& p1 = classPosition[getClass(triangle * 3 + 1)];
+    const glm::dvec3& p2 = classPosition[getClass(triangle * 3 + 2)];
+    return glm::cross(p1 - p0, p2 - p0);
+  }
+
+  void buildAdjacency()
+  {
+    vertexTriangleStart.assign(vertices.size() + 1, 0);
+    for (const gpu::Index v : result)
+    {
+      ++vertexTriangleStart[v + 1];
+    }
+    for (std::size_t v = 0; v < vertices.size(); ++v)
+    {
+      vertexTriangleStart[v + 1] += vertexTriangleStart[v];
+    }
+
+    vertexTriangles.resize(result.size());
+    std::vector<std::uint32_t> cursor(vertexTriangleStart.begin(), vertexTriangleStart.end() - 1);
+    for (std::uint32_t corner = 0; corner < result.size(); ++corner)
+    {
+      vertexTriangles[cursor[result[corner]]++] = corner / 3;
+    }
+  }
+
+  /**
+   * Classifies the vertices by the borders of the current triangles and collects the cheapest allowed collapse of
+   * every edge, sorted by cost.
+   */
+  void buildCollapses()
+  {
+    edges.clear();
+    for (std::uint32_t corner = 0; corner < result.size(); ++corner)
+    {
+      const std::uint32_t a = getClass(corner);
+      const std::uint32_t b = getClass(corner - corner % 3 + (corner + 1) % 3);
+      edges.push_back({std::min(a, b), std::max(a, b)});
+    }
+    std::sort(
+      edges.begin(), edges.end(), [](Edge left, Edge right)
+      { return left.a != right.a ? left.a < right.a : left.b < right.b; });
+
+    std::vector<std::uint32_t> borderCount(classPosition.size(), 0);
+    classKind.assign(classPosition.size(), VertexKind::Manifold);
+    for (std::size_t i = 0; i < edges.size();)
+    {
+      const std::size_t end = findEdgeRunEnd(i);
+      if (end - i == 1)
+      {
+        ++borderCount[edges[i].a];
+        ++borderCount[edges[i].b];
+      }
+      else if (end - i > 2)
+      {
+        classKind[edges[i].a] = VertexKind::Locked;
+        classKind[edges[i].b] = VertexKind::Locked;
+      }
+      i = end;
+    }
+
+    classSeam.assign(classPosition.size(), false);
+    for (std::uint32_t c = 0; c < classKind.size(); ++c)
+    {
+      if (classKind[c] == VertexKind::Manifold && borderCount[c] != 0)
+      {
+        // a border vertex slides along its two border edges, anything else is a corner of the outline
+        classKind[c] = borderCount[c] == 2 ? VertexKind::Border : VertexKind::Locked;
+      }
+      classSeam[c] = isOnSeam(c);
+    }
+
+    collapses.clear();
+    for (std::size_t i = 0; i < edges.size();)
+    {
+      const std::size_t end = findEdgeRunEnd(i);
+      const Edge edge = edges[i];
+      const bool border = end - i == 1;
+      i = end;
+
+      if (edge.a == edge.b)
+      {
+        continue;
+      }
+
+      Collapse best{NoVertex, NoVertex, std::numeric_limits<double>::infinity()};
+      for (const auto& [from, to] : {std::pair{edge.a, edge.b}, std::pair{edge.b, edge.a}})
+      {
+        // a vertex on a seam can only follow the seam, which leads to another vertex on it
+        const VertexKind kind = classKind[from];
+        const bool followsSeam = !classSeam[from] || classSeam[to] || classKind[to] == VertexKind::Locked;
+        if (followsSeam && (kind == VertexKind::Manifold || (kind == VertexKind::Border && border)))
+        {
+          Quadric quadric = classQuadric[from];
+          quadric += classQuadric[to];
+          const double cost = quadric.evaluate(classPosition[to]);
+          if (cost < best.cost)
+          {
+            best = {from, to, cost};
+          }
+        }
+      }
+
+      if (best.from != NoVertex)
+      {
+        collapses.push_back(best);
+      }
+    }
+    std::sort(
+      collapses.begin(), collapses.end(), [](const Collapse& left, const Collapse& right)
+      { return left.cost < right.cost; });
+  }
+
+  /**
+   * Whether the vertices of a position class still in use have more than one uv.
+   */
+  bool isOnSeam(std::uint32_t positionClass) const
+  {
+    const glm::vec2* uv = nullptr;
+    for (std::uint32_t i = classStart[positionClass]; i < classStart[positionClass + 1]; ++i)
+    {
+      const std::uint32_t v = classVertices[i];
+      if (vertexTriangleStart[v] == vertexTriangleStart[v + 1])
+      {
+        continue;
+      }
+
+      if (uv != nullptr && *uv != vertices[v].uv)
+      {
+        return true;
+      }
+      uv = &vertices[v].uv;
+    }
+    return false;
+  }
+
+  std::size_t findEdgeRunEnd(std::size_t begin) const
+  {
+    std::size_t end = begin + 1;
+    while (end < edges.size() && edges[end].a == edges[begin].a && edges[end].b == edges[begin].b)
+    {
+      ++end;
+    }
+    return end;
+  }
+
+  /**
+   * Performs collapses in order of cost until about triangleGoal triangles are gone. Each collapse removes about two
+   * triangles. Collapses more expensive than the goal calls for are left to later passes, unless rejected collapses
+   * kept this pass from making enough progress.
+   */
+  std::size_t collapseEdges(std::size_t triangleGoal, double& maxCost)
+  {
+    if (collapses.empty())
+    {
+      return 0;
+    }
+
+    const double costLimit = collapses[std::min(collapses.size() - 1, triangleGoal / 2)].cost;
+    const std::size_t minCount = std::max<std::size_t>(triangleGoal / MinPassShare, 1);
+    touched.assign(classPosition.size(), false);
+
+    std::size_t removed = 0;
+    std::size_t count = 0;
+    for (const Collapse& collapse : collapses)
+    {
+      if (removed >= triangleGoal || (collapse.cost > costLimit && count >= minCount))
+      {
+        break;
+      }
+
+      if (touched[collapse.from] || touched[collapse.to] || !tryCollapse(collapse, removed))
+      {
+        continue;
+      }
+
+      maxCost = std::max(maxCost, collapse.cost);
+      ++count;
+    }
+    return count;
+  }
+
+  bool tryCollapse(const Collapse& collapse, std::size_t& removed)
+  {
+    pending.clear();
+    std::size_t collapsed = 0;
+
+    for (std::uint32_t i = classStart[collapse.from]; i < classStart[collapse.from + 1]; ++i)
+    {
+      const std::uint32_t v = classVertices[i];
+      std::uint32_t target = NoVertex;
+      for (std::uint32_t j = vertexTriangleStart[v]; j < vertexTriangleStart[v + 1]; ++j)
+      {
+        const std::uint32_t triangle = vertexTriangles[j];
+        const std::uint32_t sharedCorner = findCornerOfClass(triangle, collapse.to);
+        if (sharedCorner != NoVertex)
+        {
+          // the triangle degenerates, and v joins the vertex of the target class it shares an edge with
+          target = result[sharedCorner];
+          ++collapsed;
+          continue;
+        }
+
+        if (flips(triangle, collapse.from, classPosition[collapse.to]))
+        {
+          return false;
+        }
+      }
+
+      if (vertexTriangleStart[v] == vertexTriangleStart[v + 1])
+      {
+        continue;
+      }
+
+      // a vertex split from its neighbours only by its normal joins the target vertex with the same uv, one across a
+      // uv seam from the target has no vertex to join
+      if (target == NoVertex)
+      {
+        target = findVertexWithUV(collapse.to, vertices[v].uv);
+        if (target == NoVertex)
+        {
+          return false;
+        }
+      }
+      pending.emplace_back(v, target);
+    }
+
+    for (const auto& [v, target] : pending)
+    {
+      remap[v] = target;
+      for (std::uint32_t j = vertexTriangleStart[v]; j < vertexTriangleStart[v + 1]; ++j)
+      {
+        for (std::uint32_t k = 0; k < 3; ++k)
+        {
+          touched[getClass(vertexTriangles[j] * 3 + k)] = true;
+        }
+      }
+    }
+
+    classQuadric[collapse.to] += classQuadric[collapse.from];
+    touched[collapse.to] = true;
+    removed += collapsed;
+    return true;
+  }
+
+  std::uint32_t findVertexWithUV(std::uint32_t positionClass, const glm::vec2& uv) const
+  {
+    for (std::uint32_t i = classStart[positionClass]; i < classStart[positionClass + 1]; ++i)
+    {
+      const std::uint32_t v = classVertices[i];
+      if (vertices[v].uv == uv && vertexTriangleStart[v] != vertexTriangleStart[v + 1])
+      {
+        return v;
+      }
+    }
+    return NoVertex;
+  }
+
+  std::uint32_t findCornerOfClass(std::uint32_t triangle, std::uint32_t positionClass) const
+  {
+    for (std::uint32_t k = 0; k < 3; ++k)
+    {
+      if (getClass(triangle * 3 + k) == positionClass)
+      {
+        return triangle * 3 + k;
+      }
+    }
+    return NoVertex;
+  }
+
+  bool flips(std::uint32_t triangle, std::uint32_t movedClass, const glm::dvec3& newPosition) const
+  {
+    glm::dvec3 p[3];
+    glm::dvec3 q[3];
+    for (std::uint32_t k = 0; k < 3; ++k)
+    {
+      const std::uint32_t positionClass = getClass(triangle * 3 + k);
+      p[k] = classPosition[positionClass];
+      q[k] = positionClass == movedClass ? newPosition : p[k];
+    }
+
+    const glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+    const glm::dvec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+    const double lengths = glm::length(before) * glm::length(after);
+    return lengths > 0.0 && glm::dot(before, after) < MinNormalDot * lengths;
+  }
+
+  /**
+   * Applies the collapses of the pass and drops the triangles that degenerated.
+   */
+  void compact()
+  {
+    std::size_t write = 0;
+    for (std::size_t read = 0; read < result.size(); read += 3)
+    {
+      const gpu::Index a = static_cast<gpu::Index>(remap[result[read]]);
+      const gpu::Index b = static_cast<gpu::Index>(remap[result[read + 1]]);
+      const gpu::Index c = static_cast<gpu::Index>(remap[result[read + 2]]);
+      const std::uint32_t classA = vertexClass[a];
+      const std::uint32_t classB = vertexClass[b];
+      const std::uint32_t classC = vertexClass[c];
+      if (classA == classB || classB == classC || classC == classA)
+      {
+        continue;
+      }
+
+      result[write++] = a;
+      result[write++] = b;
+      result[write++] = c;
+    }
+    result.resize(write);
+  }
+
+  std::span<const gpu::Vertex> vertices;
+  std::vector<gpu::Index> result;
+  std::vector<std::uint32_t> remap;
+
+  // position classes, class c owns classVertices[classStart[c], classStart[c + 1])
+  std::vector<std::uint32_t> vertexClass;
+  std::vector<std::uint32_t> classStart;
+  std::vector<std::uint32_t> classVertices;
+  std::vector<glm::dvec3> classPosition;
+  std::vector<Quadric> classQuadric;
+  std::vector<VertexKind> classKind;
+  std::vector<bool> classSeam;
+
+  // per pass state
+  std::vector<std::uint32_t> vertexTriangleStart;
+  std::vector<std::uint32_t> vertexTriangles;
+  std::vector<Edge> edges;
+  std::vector<Collapse> collapses;
+  std::vector<bool> touched;
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> pending;
+};
+} // namespace
+
+std::vector<gpu::Index> simplifyMesh(
+  std::span<const gpu::Vertex> vertices,
+  std::span<const gpu::Index> indices,
+  std::size_t targetIndexCount,
+  float& outError)
+{
+  Simplifier simplifier(vertices, indices);
+  outError = static_cast<float>(simplifier.run(targetIndexCount));
+  return simplifier.takeResult();
+}
+
+std::vector<MeshLod> buildMeshLods(std::span<const gpu::Vertex> vertices, std::vector<gpu::Index>& indices)
+{
+  std::vector<MeshLod> lods{{.firstIndex = 0, .indexCount = static_cast<Uint32>(indices.size())}};
+
+  // every level is simplified from the full detail mesh, so that its error is measured against it
+  const std::vector<gpu::Index> fullDetail = indices;
+  std::size_t previousCount = fullDetail.size();
+  float error = 0.0f;
+  while (lods.size() < MAX_MESH_LODS)
+  {
+    const std::size_t targetCount = previousCount / 6 * 3;
+    if (targetCount == 0)
+    {
+      break;
+    }
+
+    float levelError = 0.0f;
+    const std::vector<gpu::Index> level = simplifyMesh(vertices, fullDetail, targetCount, levelError);
+    if (level.empty() || static_cast<double>(level.size()) > (1.0 - MinLodReduction) * previousCount)
+    {
+      break;
+    }
+
+    error = std::max(error, levelError);
+    lods.push_back({
+      .firstIndex = static_cast<Uint32>(indices.size()),
+      .indexCount = static_cast<Uint32>(level.size()),
+      .error = error,
+    });
+    indices.insert(indices.end(), level.begin(), level.end());
+    previousCount = level.size();
+  }
+
+  return lods;
+}
+
+} // namespace flb
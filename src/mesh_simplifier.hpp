@@ -0,0 +1,35 @@
+#pragma once
+
+#include "gpu/pipeline.hpp"
+#include "mesh_manager.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace flb
+{
+
+/**
+ * Reduces a triangle list towards targetIndexCount indices by quadric edge collapse. The result indexes the same
+ * vertices, a collapse moves a vertex onto one of its neighbours, so levels of detail can share one vertex buffer.
+ * outError receives the largest approximate distance, in model space, between the simplified and the input surface.
+ *
+ * Vertices sharing a position but not a uv, uv seams, only collapse along the seam, while hard edges between vertices
+ * that differ only in their normals may be collapsed away. Open borders only collapse along the border, and collapses
+ * that would flip a triangle are rejected. The result may stay above the target when no more collapses are valid.
+ */
+std::vector<gpu::Index> simplifyMesh(
+  std::span<const gpu::Vertex> vertices,
+  std::span<const gpu::Index> indices,
+  std::size_t targetIndexCount,
+  float& outError);
+
+/**
+ * Simplifies the full detail triangle list in indices to up to MAX_MESH_LODS - 1 coarser levels, each with about half
+ * the triangles of the one before, and appends them to indices. Returns the ranges of all levels, the full detail one
+ * first. Stops early once a level no longer gets meaningfully smaller.
+ */
+std::vector<MeshLod> buildMeshLods(std::span<const gpu::Vertex> vertices, std::vector<gpu::Index>& indices);
+
+} // namespace flb
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "camera.hpp"
+#include "components.hpp"
+#include "culling.hpp"
+#include "tile_generator.hpp"
+
+#include <entt/entt.hpp>
+
+#include <algorithm>
+
+namespace flb
+{
+
+/**
+ * Bounding sphere of a mesh placed at position, scaled by the largest axis of the transform if there is one.
+ */
+inline BoundingSphere getWorldBoundingSphere(
+  const Mesh& mesh, const glm::dvec3& position, const component::Transform* transform)
+{
+  if (transform == nullptr)
+  {
+    return {position + glm::dvec3{mesh.boundsCenter}, mesh.boundsRadius};
+  }
+
+  const glm::mat3& matrix = transform->value;
+  const float scale = std::max({glm::length(matrix[0]), glm::length(matrix[1]), glm::length(matrix[2])});
+  return {position + glm::dvec3{matrix * mesh.boundsCenter}, static_cast<double>(mesh.boundsRadius * scale)};
+}
+
+/**
+ * Tags every model and indicator entity whose bounding sphere is inside the frustum and above the horizon with
+ * component::Visible, the renderer skips the others. TileManager::update() clears the tags of the previous frame along
+ * with its own, so this has to run after it.
+ */
+inline void markVisibleModels(entt::registry& registry, const Camera& camera)
+{
+  const auto cameraPosition = camera.position;
+  const auto frustum = camera.createFrustum();
+
+  const auto markIfVisible = [&](entt::entity entity, const glm::dvec3& position, const Mesh& mesh)
+  {
+    if (mesh.indexCount == 0)
+      return;
+
+    const auto boundingSphere = getWorldBoundingSphere(mesh, position, registry.try_get<component::Transform>(entity));
+    const auto horizonCullingPoint = generateHorizonCullingPointLoose(boundingSphere);
+    if (isOccluded(cameraPosition, frustum, boundingSphere, horizonCullingPoint))
+      return;
+
+    registry.emplace_or_replace<component::Visible>(entity);
+  };
+
+  const auto models = registry.view<component::Position, component::Model>();
+  for (const auto [entity, position, model] : models.each())
+  {
+    markIfVisible(entity, position.value, model.value.getMesh());
+  }
+
+  const auto indicators = registry.view<component::Position, component::IndicatorModel>();
+  for (const auto [entity, position, indicator] : indicators.each())
+  {
+    markIfVisible(entity, position.value, indicator.value.getMesh());
+  }
+}
+
+} // namespace flb
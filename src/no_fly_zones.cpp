@@ -1,13 +1,18 @@
 #include "no_fly_zones.hpp"
 
 #include "components.hpp"
-#include "indicator_model_loader.hpp"
+#include "geodesy.hpp"
+#include "obj_loader.hpp"
+#include "polygon_tessellation.hpp"
+#include "utils.hpp"
 
 #include <SDL3/SDL.h>
 
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
 #include <string>
+#include <tuple>
 
 namespace flb
 {
@@ -16,12 +21,83 @@ namespace
 constexpr float ZoneHeightMeters = 800.0f;
 const glm::vec4 ZoneColor{1.0f, 0.0f, 0.0f, 0.25f};
 
+// smallest radius of curvature of the ellipsoid, the meridian one at the equator
+constexpr double MinCurvatureRadius = SEMI_MINOR_SQUARED / SEMI_MAJOR;
+
+/**
+ * Key of a cell given by its integer coordinates in a grid of cubes of REGION_SIZE or a multiple of it. The Earth spans
+ * less than 2^9 regions along each axis, offsetting the cell coordinates by 2^9 keeps them positive.
+ */
+std::uint64_t getCellKey(const glm::dvec3& cell)
+{
+  const glm::dvec3 offsetCell = cell + 512.0;
+  return (static_cast<std::uint64_t>(offsetCell.x) << 42) | (static_cast<std::uint64_t>(offsetCell.y) << 21) |
+         static_cast<std::uint64_t>(offsetCell.z);
+}
+
+/**
+ * Cell of an ECEF position in a grid of cubes of the given size.
+ */
+std::uint64_t getCellKey(const ECEFCoords& position, double cellSize)
+{
+  return getCellKey(glm::floor(position / cellSize));
+}
+
+/**
+ * Calls visit with the key of every cell of the given size that overlaps the cube of half size extent around position.
+ */
+template <typename Visit>
+void forEachCell(const ECEFCoords& position, double extent, double cellSize, const Visit& visit)
+{
+  const glm::dvec3 low = glm::floor((position - extent) / cellSize);
+  const glm::dvec3 high = glm::floor((position + extent) / cellSize);
+  for (double x = low.x; x <= high.x; ++x)
+  {
+    for (double y = low.y; y <= high.y; ++y)
+    {
+      for (double z = low.z; z <= high.z; ++z)
+      {
+        visit(getCellKey(glm::dvec3{x, y, z}));
+      }
+    }
+  }
+}
+
+/**
+ * Half size of the cube around a position that holds every point within the given horizontal distance of it in a
+ * nearby ENU frame. Such points can be above or below the position by its height over the ellipsoid plus the drop of
+ * the Earth's curvature over the distance, which is counted twice here: the drop over a region's radius plus a
+ * vehicle's travel is at most twice the sum of the drops over each, so the cubes of a region and of a vehicle that can
+ * reach it always share a cell.
+ */
+double getReachExtent(double distance, double height)
+{
+  return distance + distance * distance / MinCurvatureRadius + std::abs(height);
+}
+
+/**
+ * Merges the hit of one grid into the hit of a vehicle over all grids, mapping grid indices to zone indices.
+ */
+void mergeHit(const CylinderGrid::Hit& gridHit, std::span<const std::uint32_t> zoneIds, CylinderGrid::Hit& hit)
+{
+  if (hit.containing == CylinderGrid::NONE && gridHit.containing != CylinderGrid::NONE)
+  {
+    hit.containing = zoneIds[gridHit.containing];
+  }
+  if (gridHit.timeToEntry < hit.timeToEntry)
+  {
+    hit.next = zoneIds[gridHit.next];
+    hit.timeToEntry = gridHit.timeToEntry;
+  }
+}
+
 } // namespace
 
 SDL_AppResult NoFlyZones::init(
   entt::registry& registry,
   MeshManager& meshManager,
   const std::filesystem::path& zonesPath,
+  const std::filesystem::path& polygonZonesPath,
   const std::filesystem::path& cylinderPath)
 {
   clear(registry);
@@ -32,28 +108,102 @@ SDL_AppResult NoFlyZones::init(
     return SDL_APP_FAILURE;
   }
 
-  if (zones.empty())
+  PolygonZoneCollection polygonZones;
+  if (std::filesystem::exists(polygonZonesPath) && !loadGeoJSONZones(polygonZonesPath, ZoneHeightMeters, polygonZones))
+  {
+    return SDL_APP_FAILURE;
+  }
+
+  if (zones.empty() && polygonZones.zones.empty())
   {
     SDL_Log("No no-fly zones loaded from %s", zonesPath.string().c_str());
     return SDL_APP_CONTINUE;
   }
 
-  const IndicatorModel zoneModel = loadIndicatorModel(meshManager, cylinderPath, ZoneColor, "no-fly zone");
-  if (!zoneModel.isValid())
+  std::vector<gpu::Vertex> cylinderVertices;
+  std::vector<gpu::WideIndex> cylinderIndices;
+  if (!zones.empty())
   {
-    return SDL_APP_FAILURE;
+    std::tie(cylinderVertices, cylinderIndices) = loadOBJ(cylinderPath);
+    if (cylinderVertices.empty() || cylinderIndices.empty())
+    {
+      SDL_Log("Failed to load no-fly zone mesh %s", cylinderPath.string().c_str());
+      return SDL_APP_FAILURE;
+    }
   }
 
-  zoneEntities.reserve(zones.size());
-  for (const ZoneDefinition& zone : zones)
+  std::vector<ECEFCoords> groundPositions(polygonZones.vertices.size());
+  geoToECEF(polygonZones.vertices, groundPositions);
+
+  // Zones sorted by the mesh cell and then the region their anchor falls into, circles are anchored at their center
+  // and polygons at their first vertex. Regions nest in mesh cells, so the regions of a mesh cell are consecutive.
+  circleZoneCount = static_cast<std::uint32_t>(zones.size());
+  const std::uint32_t zoneCount = circleZoneCount + static_cast<std::uint32_t>(polygonZones.zones.size());
+  std::vector<ECEFCoords> anchors(zoneCount);
+  std::vector<std::tuple<std::uint64_t, std::uint64_t, std::uint32_t>> zoneOrder(zoneCount);
+  for (std::uint32_t zone = 0; zone < zoneCount; ++zone)
   {
-    const entt::entity zoneEntity = registry.create();
-    registry.emplace<component::Position>(zoneEntity, geoToECEF(zone.center));
-    registry.emplace<component::Transform>(zoneEntity, NoFlyZones::makeZoneTransform(zone));
-    registry.emplace<component::IndicatorModel>(zoneEntity, zoneModel);
-    zoneEntities.push_back(zoneEntity);
+    anchors[zone] = zone < circleZoneCount
+                      ? geoToECEF(zones[zone].center)
+                      : groundPositions[polygonZones.ringStarts[polygonZones.zones[zone - circleZoneCount].firstRing]];
+    zoneOrder[zone] = {getCellKey(anchors[zone], MESH_CELL_SIZE), getCellKey(anchors[zone], REGION_SIZE), zone};
+  }
+  std::sort(zoneOrder.begin(), zoneOrder.end());
+
+  std::vector<ECEFCoords> regionAnchors;
+  for (std::size_t cellFirst = 0, cellLast = 0; cellFirst < zoneOrder.size(); cellFirst = cellLast)
+  {
+    // the meshes of a cell are placed relative to its first region
+    MergedMeshBuilder meshBuilder(meshManager);
+    ECEFCoords meshOrigin{0.0};
+    const std::uint64_t meshCell = std::get<0>(zoneOrder[cellFirst]);
+    for (cellLast = cellFirst; cellLast < zoneOrder.size() && std::get<0>(zoneOrder[cellLast]) == meshCell;)
+    {
+      Region& region = regions.emplace_back();
+      regionAnchors.clear();
+      const std::size_t first = cellLast;
+      const std::uint64_t regionCell = std::get<1>(zoneOrder[first]);
+      for (; cellLast < zoneOrder.size() && std::get<1>(zoneOrder[cellLast]) == regionCell; ++cellLast)
+      {
+        const std::uint32_t zone = std::get<2>(zoneOrder[cellLast]);
+        regionAnchors.push_back(anchors[zone]);
+        (zone < circleZoneCount ? region.zoneIds : region.polygonZoneIds).push_back(zone);
+      }
+      region.frame = makeENUFrame(regionAnchors);
+      if (first == cellFirst)
+      {
+        meshOrigin = region.frame.origin;
+      }
+
+      buildCircleZones(zones, cylinderVertices, cylinderIndices, meshOrigin, region, meshBuilder);
+      buildPolygonZones(polygonZones, groundPositions, meshOrigin, region, meshBuilder);
+
+      // the centroid of the anchors lies below the ellipsoid, by up to a few hundred meters
+      double originHeight = 0.0;
+      ecefToGeo(region.frame.origin, originHeight);
+      const std::uint32_t regionIndex = static_cast<std::uint32_t>(regions.size() - 1);
+      forEachCell(
+        region.frame.origin,
+        getReachExtent(region.radius, originHeight),
+        REGION_SIZE,
+        [&](std::uint64_t key) { regionCells[key].push_back(regionIndex); });
+    }
+
+    const MeshHandle meshHandle = meshBuilder.finish();
+    if (meshHandle.isValid())
+    {
+      const entt::entity zoneEntity = registry.create();
+      registry.emplace<component::Position>(zoneEntity, meshOrigin);
+      registry.emplace<component::IndicatorModel>(zoneEntity, IndicatorModel{&meshManager, meshHandle, ZoneColor});
+      zoneEntities.push_back(zoneEntity);
+    }
   }
 
+  SDL_Log(
+    "Loaded %zu circular and %zu polygonal no-fly zones in %zu regions",
+    zones.size(),
+    polygonZones.zones.size(),
+    regions.size());
   return SDL_APP_CONTINUE;
 }
 
@@ -67,6 +217,250 @@ void NoFlyZones::clear(entt::registry& registry)
     }
   }
   zoneEntities.clear();
+  regions.clear();
+  regionCells.clear();
+  circleZoneCount = 0;
+  registry.clear<component::NoFlyZoneStatus>();
+}
+
+void NoFlyZones::update(entt::registry& registry)
+{
+  if (regions.empty())
+  {
+    return;
+  }
+
+  vehicleEntities.clear();
+  vehiclePositions.clear();
+  vehicleVelocities.clear();
+
+  const auto view = registry.view<component::Vehicle, component::Position>();
+  for (const auto [entity, vehicle, position] : view.each())
+  {
+    const auto* velocity = registry.try_get<component::Velocity>(entity);
+    vehicleEntities.push_back(entity);
+    vehiclePositions.push_back(position.value);
+    vehicleVelocities.push_back(velocity != nullptr ? velocity->value : glm::dvec3{0.0});
+  }
+  vehicleHits.assign(vehicleEntities.size(), CylinderGrid::Hit{});
+
+  // candidate regions of every vehicle, from the cells around it that it can reach within the lookahead
+  regionVehicles.clear();
+  for (std::uint32_t i = 0; i < vehicleEntities.size(); ++i)
+  {
+    double height = 0.0;
+    ecefToGeo(vehiclePositions[i], height);
+    const double travel = glm::length(vehicleVelocities[i]) * LOOKAHEAD;
+    forEachCell(
+      vehiclePositions[i],
+      getReachExtent(travel, height),
+      REGION_SIZE,
+      [&](std::uint64_t key)
+      {
+        const auto cell = regionCells.find(key);
+        if (cell != regionCells.end())
+        {
+          for (const std::uint32_t region : cell->second)
+          {
+            regionVehicles.emplace_back(region, i);
+          }
+        }
+      });
+  }
+  std::sort(regionVehicles.begin(), regionVehicles.end());
+  regionVehicles.erase(std::unique(regionVehicles.begin(), regionVehicles.end()), regionVehicles.end());
+
+  for (std::size_t first = 0, last = 0; first < regionVehicles.size(); first = last)
+  {
+    // only vehicles that can reach a zone of the region within the lookahead are queried against it
+    const Region& region = regions[regionVehicles[first].first];
+    queryVehicles.clear();
+    queryPositions.clear();
+    queryVelocities.clear();
+    for (last = first; last < regionVehicles.size() && regionVehicles[last].first == regionVehicles[first].first;
+         ++last)
+    {
+      const std::uint32_t i = regionVehicles[last].second;
+      const glm::dvec3 position = region.frame.toENU(vehiclePositions[i]);
+      const glm::dvec3 velocity = region.frame.directionToENU(vehicleVelocities[i]);
+      const double reach = region.radius + glm::length(glm::dvec2{velocity}) * LOOKAHEAD;
+      if (position.x * position.x + position.y * position.y > reach * reach)
+      {
+        continue;
+      }
+
+      queryVehicles.push_back(i);
+      queryPositions.push_back(position);
+      queryVelocities.push_back(velocity);
+    }
+    if (queryVehicles.empty())
+    {
+      continue;
+    }
+
+    queryHits.resize(queryVehicles.size());
+    polygonQueryHits.resize(queryVehicles.size());
+    region.zoneGrid.query(queryPositions, queryVelocities, LOOKAHEAD, queryHits);
+    region.polygonZoneGrid.query(queryPositions, queryVelocities, LOOKAHEAD, polygonQueryHits);
+    for (std::size_t i = 0; i < queryVehicles.size(); ++i)
+    {
+      mergeHit(queryHits[i], region.zoneIds, vehicleHits[queryVehicles[i]]);
+      mergeHit(polygonQueryHits[i], region.polygonZoneIds, vehicleHits[queryVehicles[i]]);
+    }
+  }
+
+  for (std::size_t i = 0; i < vehicleEntities.size(); ++i)
+  {
+    const CylinderGrid::Hit& hit = vehicleHits[i];
+    auto& status = registry.get_or_emplace<component::NoFlyZoneStatus>(vehicleEntities[i]);
+    if (hit.containing != CylinderGrid::NONE && hit.containing != status.zone)
+    {
+      SDL_Log(
+        "Vehicle %u entered no-fly zone %u", registry.get<component::Vehicle>(vehicleEntities[i]).id, hit.containing);
+    }
+
+    status.zone = hit.containing;
+    status.nextZone = hit.next;
+    status.timeToViolation = hit.timeToEntry;
+  }
+}
+
+void NoFlyZones::buildCircleZones(
+  std::span<const ZoneDefinition> zones,
+  std::span<const gpu::Vertex> cylinderVertices,
+  std::span<const gpu::WideIndex> cylinderIndices,
+  const ECEFCoords& meshOrigin,
+  Region& region,
+  MergedMeshBuilder& meshBuilder)
+{
+  std::vector<CylinderGrid::Cylinder> cylinders;
+  cylinders.reserve(region.zoneIds.size());
+  for (const std::uint32_t zoneId : region.zoneIds)
+  {
+    const ZoneDefinition& zone = zones[zoneId];
+    const ECEFCoords center = geoToECEF(zone.center);
+    const glm::dvec3 base = region.frame.toENU(center);
+    cylinders.push_back({
+      .center = glm::dvec2{base},
+      .radius = zone.radiusMeters,
+      .bottom = base.z,
+      .top = base.z + ZoneHeightMeters,
+    });
+    region.radius = std::max(region.radius, glm::length(glm::dvec2{base}) + zone.radiusMeters);
+
+    const glm::vec3 offset{center - meshOrigin};
+    meshBuilder.addMesh(cylinderVertices, cylinderIndices, makeZoneTransform(zone), offset);
+  }
+  region.zoneGrid.build(cylinders);
+}
+
+void NoFlyZones::buildPolygonZones(
+  const PolygonZoneCollection& zones,
+  std::span<const ECEFCoords> groundPositions,
+  const ECEFCoords& meshOrigin,
+  Region& region,
+  MergedMeshBuilder& meshBuilder)
+{
+  if (region.polygonZoneIds.empty())
+  {
+    return;
+  }
+
+  // Outlines of the region's zones are flattened into its ENU frame for the index and the tessellation, with rings
+  // renumbered from zero. Mesh vertices are placed on the ellipsoid relative to the mesh origin instead, which keeps
+  // large zones from lifting off the ground at the edges.
+  std::vector<glm::dvec2> outline;
+  std::vector<std::uint32_t> outlineRingStarts{0};
+  std::vector<PrismGrid::Prism> prisms;
+  prisms.reserve(region.polygonZoneIds.size());
+
+  const glm::vec3 up{glm::transpose(region.frame.ecefToENU)[2]};
+  std::vector<std::uint32_t> triangles;
+  std::vector<std::uint32_t> ringStarts;
+  std::vector<ECEFCoords> positions;
+  for (const std::uint32_t zoneId : region.polygonZoneIds)
+  {
+    const std::size_t zoneIndex = zoneId - circleZoneCount;
+    const PolygonZone& zone = zones.zones[zoneIndex];
+    const std::uint32_t firstVertex = zones.ringStarts[zone.firstRing];
+    const std::uint32_t vertexCount = zones.ringStarts[zone.firstRing + zone.ringCount] - firstVertex;
+
+    const std::uint32_t outlineStart = static_cast<std::uint32_t>(outline.size());
+    for (std::uint32_t vertex = firstVertex; vertex < firstVertex + vertexCount; ++vertex)
+    {
+      const glm::dvec2 point{region.frame.toENU(groundPositions[vertex])};
+      outline.push_back(point);
+      region.radius = std::max(region.radius, glm::length(point));
+    }
+
+    ringStarts.clear();
+    for (std::uint32_t ring = zone.firstRing; ring <= zone.firstRing + zone.ringCount; ++ring)
+    {
+      ringStarts.push_back(zones.ringStarts[ring] - firstVertex);
+    }
+
+    // like the circular zones, heights are measured from the ground under the zone's first vertex
+    const double groundHeight = region.frame.toENU(groundPositions[firstVertex]).z;
+    prisms.push_back({
+      .firstRing = static_cast<std::uint32_t>(outlineRingStarts.size() - 1),
+      .ringCount = zone.ringCount,
+      .bottom = groundHeight + zone.floor,
+      .top = groundHeight + zone.ceiling,
+    });
+    for (std::size_t ring = 1; ring < ringStarts.size(); ++ring)
+    {
+      outlineRingStarts.push_back(outlineStart + ringStarts[ring]);
+    }
+
+    if (!meshBuilder.reserve(2 * std::size_t{vertexCount}))
+    {
+      SDL_Log("No-fly zone %u has too many vertices to be drawn", zoneId);
+      continue;
+    }
+
+    triangles.clear();
+    tessellatePolygon(std::span{outline}.subspan(outlineStart, vertexCount), ringStarts, triangles);
+
+    // floor vertices followed by ceiling vertices
+    const std::uint32_t floorBase = meshBuilder.getVertexCount();
+    const std::uint32_t ceilingBase = floorBase + vertexCount;
+    const std::span<const GeoCoords> zoneVertices = std::span{zones.vertices}.subspan(firstVertex, vertexCount);
+    for (const double height : {zone.floor, zone.ceiling})
+    {
+      positions.resize(vertexCount);
+      geoToECEF(zoneVertices, height, positions);
+      for (const ECEFCoords& position : positions)
+      {
+        meshBuilder.addVertex({
+          .position = glm::vec3{position - meshOrigin},
+          .normal = up,
+          .color = glm::vec3{1.0f},
+          .uv = glm::vec2{0.0f},
+        });
+      }
+    }
+
+    for (std::size_t i = 0; i < triangles.size(); i += 3)
+    {
+      const std::uint32_t a = triangles[i];
+      const std::uint32_t b = triangles[i + 1];
+      const std::uint32_t c = triangles[i + 2];
+      meshBuilder.addTriangle(ceilingBase + a, ceilingBase + b, ceilingBase + c);
+      meshBuilder.addTriangle(floorBase + a, floorBase + c, floorBase + b);
+    }
+
+    for (std::size_t ring = 0; ring + 1 < ringStarts.size(); ++ring)
+    {
+      for (std::uint32_t i = ringStarts[ring], previous = ringStarts[ring + 1] - 1; i < ringStarts[ring + 1];
+           previous = i++)
+      {
+        meshBuilder.addTriangle(floorBase + previous, floorBase + i, ceilingBase + i);
+        meshBuilder.addTriangle(floorBase + previous, ceilingBase + i, ceilingBase + previous);
+      }
+    }
+  }
+
+  region.polygonZoneGrid.build(outline, outlineRingStarts, prisms);
 }
 
 glm::mat3 NoFlyZones::makeZoneTransform(const ZoneDefinition& zone)
@@ -81,26 +475,41 @@ glm::mat3 NoFlyZones::makeZoneTransform(const ZoneDefinition& zone)
 
 bool NoFlyZones::parseZonesFile(const std::filesystem::path& zonesPath, std::vector<ZoneDefinition>& outZones)
 {
-  std::ifstream file(zonesPath);
-  if (!file.is_open())
+  if (!std::filesystem::exists(zonesPath))
   {
     SDL_Log("Failed to open no-fly-zones file: %s", zonesPath.string().c_str());
     return false;
   }
 
-  std::string line;
+  const std::string content = loadFileText(zonesPath);
+  const char* ptr = content.data();
+  const char* end = content.data() + content.size();
+
   std::size_t lineNumber = 0;
-  while (std::getline(file, line))
+  while (ptr < end)
   {
     ++lineNumber;
-    if (line.find_first_not_of(" \t\r\n") == std::string::npos)
+    const char* lineEnd = std::find(ptr, end, '\n');
+    const char* followingLine = lineEnd < end ? lineEnd + 1 : end;
+    const auto parseField = [&](auto& value)
+    {
+      while (ptr < lineEnd && (*ptr == ' ' || *ptr == '\t'))
+      {
+        ++ptr;
+      }
+      const auto [next, error] = std::from_chars(ptr, lineEnd, value);
+      ptr = next;
+      return error == std::errc{};
+    };
+
+    if (std::all_of(ptr, lineEnd, [](char c) { return c == ' ' || c == '\t' || c == '\r'; }))
     {
+      ptr = followingLine;
       continue;
     }
 
     ZoneDefinition zone{};
-    std::istringstream lineStream(line);
-    if (!(lineStream >> zone.center.latitude >> zone.center.longitude >> zone.radiusMeters))
+    if (!parseField(zone.center.latitude) || !parseField(zone.center.longitude) || !parseField(zone.radiusMeters))
     {
       SDL_Log("Invalid no-fly-zone entry at line %zu", lineNumber);
       return false;
@@ -112,6 +521,7 @@ bool NoFlyZones::parseZonesFile(const std::filesystem::path& zonesPath, std::vec
     }
 
     outZones.push_back(zone);
+    ptr = followingLine;
   }
 
   return true;
@@ -1,28 +1,64 @@
 #pragma once
 
+#include "cylinder_grid.hpp"
 #include "math.hpp"
+#include "merged_mesh_builder.hpp"
 #include "mesh_manager.hpp"
+#include "prism_grid.hpp"
+#include "zone_loader.hpp"
 
 #include <SDL3/SDL_init.h>
 #include <entt/entt.hpp>
 
 #include <filesystem>
+#include <span>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace flb
 {
 
+/**
+ * Loads the no-fly zones, creates their indicator entities and checks every vehicle against them.
+ *
+ * There are two kinds of zones, circles from a text file with one "latitude longitude radius" line per zone, and
+ * polygons with holes from a GeoJSON file. The zones of every mesh cell are baked into one merged mesh with one
+ * indicator entity, so drawing them takes a draw call per cell however many zones there are.
+ *
+ * Zones are grouped into regions of about REGION_SIZE meters by where they are anchored, the center of a circle or the
+ * first vertex of a polygon. Every region is indexed in its own ENU frame under the centroid of its anchors, so zone
+ * sets spread over a continent or across the antimeridian keep the accuracy of a local frame. The meshes are merged
+ * over the coarser cells of MESH_CELL_SIZE meters.
+ *
+ * update() gives every vehicle a component::NoFlyZoneStatus with the zone it is inside and the first zone it would
+ * enter within LOOKAHEAD seconds on its current velocity. Every region is hashed under the REGION_SIZE cells its zones
+ * may be reached from, so a vehicle looks up only the few cells around it that it can reach in that time and is
+ * queried against the regions found there, at a cost that grows with vehicles and hits rather than with regions. Zone
+ * indices are in file order, circles first and then polygons.
+ */
 class NoFlyZones
 {
 public:
+  static constexpr double LOOKAHEAD = 60.0;
+  static constexpr double REGION_SIZE = 50'000.0;
+  // regions are merged into meshes by cells of this size, float offsets from a cell's origin stay within a decimeter
+  static constexpr double MESH_CELL_SIZE = 20 * REGION_SIZE;
+
+  /**
+   * The polygon file is optional, zones are only loaded from it if it exists.
+   */
   SDL_AppResult init(
     entt::registry& registry,
     MeshManager& meshManager,
     const std::filesystem::path& zonesPath = "content/no_fly_zones.txt",
+    const std::filesystem::path& polygonZonesPath = "content/no_fly_zones.geojson",
     const std::filesystem::path& cylinderPath = "content/models/cylinder/cylinder.obj");
 
   void clear(entt::registry& registry);
 
+  void update(entt::registry& registry);
+
 private:
   struct ZoneDefinition
   {
@@ -30,10 +66,53 @@ private:
     float radiusMeters = 0.0f;
   };
 
+  struct Region
+  {
+    ENUFrame frame;
+    // horizontal distance from the frame origin within which all zones of the region lie
+    double radius = 0.0;
+    CylinderGrid zoneGrid;
+    PrismGrid polygonZoneGrid;
+    // zone index of every cylinder and prism in the grids
+    std::vector<std::uint32_t> zoneIds;
+    std::vector<std::uint32_t> polygonZoneIds;
+  };
+
   static bool parseZonesFile(const std::filesystem::path& zonesPath, std::vector<ZoneDefinition>& outZones);
   static glm::mat3 makeZoneTransform(const ZoneDefinition& zone);
 
+  void buildCircleZones(
+    std::span<const ZoneDefinition> zones,
+    std::span<const gpu::Vertex> cylinderVertices,
+    std::span<const gpu::WideIndex> cylinderIndices,
+    const ECEFCoords& meshOrigin,
+    Region& region,
+    MergedMeshBuilder& meshBuilder);
+  void buildPolygonZones(
+    const PolygonZoneCollection& zones,
+    std::span<const ECEFCoords> groundPositions,
+    const ECEFCoords& meshOrigin,
+    Region& region,
+    MergedMeshBuilder& meshBuilder);
+
   std::vector<entt::entity> zoneEntities;
+  std::vector<Region> regions;
+  // indices of the regions whose reach overlaps each REGION_SIZE cell, by cell key
+  std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> regionCells;
+  std::uint32_t circleZoneCount = 0;
+
+  // per-update scratch buffers
+  std::vector<entt::entity> vehicleEntities;
+  std::vector<ECEFCoords> vehiclePositions;
+  std::vector<glm::dvec3> vehicleVelocities;
+  std::vector<CylinderGrid::Hit> vehicleHits;
+  // pairs of a region and a vehicle that may reach it, sorted by region
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> regionVehicles;
+  std::vector<std::uint32_t> queryVehicles;
+  std::vector<glm::dvec3> queryPositions;
+  std::vector<glm::dvec3> queryVelocities;
+  std::vector<CylinderGrid::Hit> queryHits;
+  std::vector<PrismGrid::Hit> polygonQueryHits;
 };
 
 } // namespace flb
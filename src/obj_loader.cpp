@@ -0,0 +1,567 @@
+#include "obj_loader.hpp"
+
+#include <SDL3/SDL_log.h>
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+namespace flb
+{
+namespace
+{
+// smallest chunk worth its own thread
+constexpr std::size_t MinChunkBytes = std::size_t{1} << 20;
+// the vertex table marks empty slots with the largest index
+constexpr std::size_t MaxVertices = std::numeric_limits<gpu::WideIndex>::max();
+
+enum class LineType
+{
+  Other,
+  Position,
+  TexCoord,
+  Normal,
+  Face,
+};
+
+/**
+ * Number of elements of each kind in a range of lines. Also used as the offsets at which a chunk writes its elements
+ * into the arrays of the whole file.
+ */
+struct ElementCounts
+{
+  std::size_t positions = 0;
+  std::size_t texCoords = 0;
+  std::size_t normals = 0;
+  std::size_t faces = 0;
+  std::size_t corners = 0;
+
+  ElementCounts& operator+=(const ElementCounts& other)
+  {
+    positions += other.positions;
+    texCoords += other.texCoords;
+    normals += other.normals;
+    faces += other.faces;
+    corners += other.corners;
+    return *this;
+  }
+};
+
+/**
+ * Zero based position, uv and normal index of a face corner, -1 if missing.
+ */
+struct Corner
+{
+  std::int32_t position;
+  std::int32_t texCoord;
+  std::int32_t normal;
+
+  bool operator==(const Corner& other) const = default;
+};
+
+/**
+ * Elements of the whole file before deduplication. Face i has faceSizes[i] corners, stored back to back in corners.
+ */
+struct ObjElements
+{
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> colors;
+  std::vector<glm::vec2> texCoords;
+  std::vector<glm::vec3> normals;
+  std::vector<std::uint32_t> faceSizes;
+  std::vector<Corner> corners;
+
+  void resize(const ElementCounts& counts)
+  {
+    positions.resize(counts.positions);
+    colors.resize(counts.positions);
+    texCoords.resize(counts.texCoords);
+    normals.resize(counts.normals);
+    faceSizes.resize(counts.faces);
+    corners.resize(counts.corners);
+  }
+};
+
+inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+inline const char* skipSpace(const char* ptr, const char* end)
+{
+  while (ptr < end && isSpace(*ptr))
+  {
+    ptr++;
+  }
+  return ptr;
+}
+
+inline const char* skipToken(const char* ptr, const char* end)
+{
+  while (ptr < end && !isSpace(*ptr))
+  {
+    ptr++;
+  }
+  return ptr;
+}
+
+inline const char* findLineEnd(const char* ptr, const char* end)
+{
+  const void* newline = std::memchr(ptr, '\n', static_cast<std::size_t>(end - ptr));
+  return newline != nullptr ? static_cast<const char*>(newline) : end;
+}
+
+inline bool isDigit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+/**
+ * Parses a float, exactly like std::from_chars. Plain decimals of up to 9 digits whose digits fit into the 24 bit
+ * mantissa, which is what exporters write, take a fast path: both the digits and the power of ten are exact floats,
+ * so a single division rounds correctly. Everything else falls back to std::from_chars.
+ */
+inline const char* parseFloat(const char* ptr, const char* end, float& value)
+{
+  ptr = skipSpace(ptr, end);
+
+  const char* cursor = ptr + (ptr < end && *ptr == '-');
+  const char* integerStart = cursor;
+  std::uint32_t digits = 0;
+  for (; cursor < end && isDigit(*cursor) && cursor - integerStart < 9; ++cursor)
+  {
+    digits = digits * 10 + static_cast<std::uint32_t>(*cursor - '0');
+  }
+  std::ptrdiff_t digitCount = cursor - integerStart;
+
+  std::ptrdiff_t fractionCount = 0;
+  if (cursor < end && *cursor == '.')
+  {
+    const char* fractionStart = ++cursor;
+    for (; cursor < end && isDigit(*cursor) && digitCount + (cursor - fractionStart) < 9; ++cursor)
+    {
+      digits = digits * 10 + static_cast<std::uint32_t>(*cursor - '0');
+    }
+    fractionCount = cursor - fractionStart;
+    digitCount += fractionCount;
+  }
+
+  constexpr std::uint32_t MaxExactDigits = std::uint32_t{1} << 24;
+  const bool complete = cursor == end || (!isDigit(*cursor) && *cursor != 'e' && *cursor != 'E' && *cursor != '.');
+  if (digitCount > 0 && complete && digits <= MaxExactDigits)
+  {
+    constexpr float PowersOfTen[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f};
+    const float magnitude = static_cast<float>(digits) / PowersOfTen[fractionCount];
+    value = *ptr == '-' ? -magnitude : magnitude;
+    return cursor;
+  }
+
+  auto res = std::from_chars(ptr, end, value);
+  return res.ptr;
+}
+
+/**
+ * Parses a one based index into a zero based one. Negative and zero indices, which aren't supported, become -1.
+ */
+inline const char* parseIndex(const char* ptr, const char* end, std::int32_t& index)
+{
+  // at most 9 digits, which can't overflow
+  const char* limit = std::min(end, ptr + 9);
+  std::int32_t value = 0;
+  for (; ptr < limit && isDigit(*ptr); ++ptr)
+  {
+    value = value * 10 + (*ptr - '0');
+  }
+  index = value - 1;
+  return ptr;
+}
+
+/**
+ * Identifies a line by its keyword and moves ptr past it.
+ */
+inline LineType classifyLine(const char*& ptr, const char* lineEnd)
+{
+  ptr = skipSpace(ptr, lineEnd);
+  if (lineEnd - ptr < 2)
+  {
+    return LineType::Other;
+  }
+
+  if (ptr[0] == 'v')
+  {
+    if (isSpace(ptr[1]))
+    {
+      ptr += 2;
+      return LineType::Position;
+    }
+    if (lineEnd - ptr >= 3 && isSpace(ptr[2]))
+    {
+      const char type = ptr[1];
+      ptr += 3;
+      return type == 't' ? LineType::TexCoord : (type == 'n' ? LineType::Normal : LineType::Other);
+    }
+  }
+  else if (ptr[0] == 'f' && isSpace(ptr[1]))
+  {
+    ptr += 2;
+    return LineType::Face;
+  }
+  return LineType::Other;
+}
+
+/**
+ * Counts the elements in [ptr, end), which starts at the beginning of a line.
+ */
+ElementCounts scanChunk(const char* ptr, const char* end)
+{
+  ElementCounts counts;
+  while (ptr < end)
+  {
+    const char* lineEnd = findLineEnd(ptr, end);
+    switch (classifyLine(ptr, lineEnd))
+    {
+    case LineType::Position:
+      ++counts.positions;
+      break;
+    case LineType::TexCoord:
+      ++counts.texCoords;
+      break;
+    case LineType::Normal:
+      ++counts.normals;
+      break;
+    case LineType::Face:
+      ++counts.faces;
+      for (ptr = skipSpace(ptr, lineEnd); ptr < lineEnd; ptr = skipSpace(skipToken(ptr, lineEnd), lineEnd))
+      {
+        ++counts.corners;
+      }
+      break;
+    case LineType::Other:
+      break;
+    }
+    ptr = lineEnd + (lineEnd < end);
+  }
+  return counts;
+}
+
+/**
+ * Parses the elements in [ptr, end) into elements, starting at the given offsets. Visits lines exactly like
+ * scanChunk(), so the elements fill the ranges the scan counted.
+ */
+void parseChunk(const char* ptr, const char* end, ElementCounts offsets, ObjElements& elements)
+{
+  while (ptr < end)
+  {
+    const char* lineEnd = findLineEnd(ptr, end);
+    switch (classifyLine(ptr, lineEnd))
+    {
+    case LineType::Position:
+    {
+      glm::vec3& position = elements.positions[offsets.positions];
+      ptr = parseFloat(ptr, lineEnd, position.x);
+      ptr = parseFloat(ptr, lineEnd, position.y);
+      ptr = parseFloat(ptr, lineEnd, position.z);
+
+      // optional vertex color after the position
+      glm::vec3& color = elements.colors[offsets.positions++];
+      color = glm::vec3{1.0f};
+      if (skipSpace(ptr, lineEnd) < lineEnd)
+      {
+        ptr = parseFloat(ptr, lineEnd, color.r);
+        ptr = parseFloat(ptr, lineEnd, color.g);
+        ptr = parseFloat(ptr, lineEnd, color.b);
+      }
+      break;
+    }
+    case LineType::TexCoord:
+    {
+      glm::vec2& texCoord = elements.texCoords[offsets.texCoords++];
+      ptr = parseFloat(ptr, lineEnd, texCoord.x);
+      ptr = parseFloat(ptr, lineEnd, texCoord.y);
+      texCoord.y = 1.0f - texCoord.y;
+      break;
+    }
+    case LineType::Normal:
+    {
+      glm::vec3& normal = elements.normals[offsets.normals++];
+      ptr = parseFloat(ptr, lineEnd, normal.x);
+      ptr = parseFloat(ptr, lineEnd, normal.y);
+      ptr = parseFloat(ptr, lineEnd, normal.z);
+      break;
+    }
+    case LineType::Face:
+    {
+      std::uint32_t& faceSize = elements.faceSizes[offsets.faces++];
+      faceSize = 0;
+      for (ptr = skipSpace(ptr, lineEnd); ptr < lineEnd; ptr = skipSpace(ptr, lineEnd))
+      {
+        // v, v/vt, v//vn or v/vt/vn
+        const char* tokenEnd = skipToken(ptr, lineEnd);
+        Corner& corner = elements.corners[offsets.corners++];
+        corner = {-1, -1, -1};
+        ptr = parseIndex(ptr, tokenEnd, corner.position);
+        if (ptr < tokenEnd && *ptr == '/')
+        {
+          ptr++;
+          if (ptr < tokenEnd && *ptr != '/')
+          {
+            ptr = parseIndex(ptr, tokenEnd, corner.texCoord);
+          }
+          if (ptr < tokenEnd && *ptr == '/')
+          {
+            ptr = parseIndex(ptr + 1, tokenEnd, corner.normal);
+          }
+        }
+        ptr = tokenEnd;
+        ++faceSize;
+      }
+      break;
+    }
+    case LineType::Other:
+      break;
+    }
+    ptr = lineEnd + (lineEnd < end);
+  }
+}
+
+/**
+ * Maps corners to vertex indices with linear probing. Grows to keep the load factor at or below one half.
+ */
+class VertexTable
+{
+public:
+  explicit VertexTable(std::size_t expectedCount)
+  {
+    slots.resize(std::bit_ceil(std::max<std::size_t>(expectedCount * 2, 64)), Slot{{}, EmptySlot});
+  }
+
+  /**
+   * Index of corner, which is added with newIndex if it isn't in the table yet. inserted tells which one happened.
+   */
+  std::uint32_t insert(const Corner& corner, std::uint32_t newIndex, bool& inserted)
+  {
+    if (2 * (count + 1) > slots.size())
+    {
+      grow();
+    }
+
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t i = hash(corner) & mask;; i = (i + 1) & mask)
+    {
+      Slot& slot = slots[i];
+      if (slot.index == EmptySlot)
+      {
+        slot = {corner, newIndex};
+        ++count;
+        inserted = true;
+        return newIndex;
+      }
+      if (slot.corner == corner)
+      {
+        inserted = false;
+        return slot.index;
+      }
+    }
+  }
+
+private:
+  static constexpr std::uint32_t EmptySlot = std::numeric_limits<std::uint32_t>::max();
+
+  struct Slot
+  {
+    Corner corner;
+    std::uint32_t index;
+  };
+
+  static std::size_t hash(const Corner& corner)
+  {
+    // indices of a corner are often equal or close, mix them before the finalizer of MurmurHash3 spreads the bits
+    std::uint64_t h = static_cast<std::uint32_t>(corner.position);
+    h = h * 0x9E3779B97F4A7C15ull + static_cast<std::uint32_t>(corner.texCoord);
+    h = h * 0x9E3779B97F4A7C15ull + static_cast<std::uint32_t>(corner.normal);
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return static_cast<std::size_t>(h);
+  }
+
+  void grow()
+  {
+    std::vector<Slot> previous(slots.size() * 2, Slot{{}, EmptySlot});
+    previous.swap(slots);
+
+    const std::size_t mask = slots.size() - 1;
+    for (const Slot& slot : previous)
+    {
+      if (slot.index == EmptySlot)
+      {
+        continue;
+      }
+
+      std::size_t i = hash(slot.corner) & mask;
+      while (slots[i].index != EmptySlot)
+      {
+        i = (i + 1) & mask;
+      }
+      slots[i] = slot;
+    }
+  }
+
+  std::vector<Slot> slots;
+  std::size_t count = 0;
+};
+
+/**
+ * Runs task(i) for every chunk i, on worker threads for all but the first.
+ */
+template <typename Task>
+void forEachChunk(std::size_t chunkCount, const Task& task)
+{
+  std::vector<std::thread> workers;
+  workers.reserve(chunkCount - 1);
+  for (std::size_t i = 1; i < chunkCount; ++i)
+  {
+    workers.emplace_back(task, i);
+  }
+
+  task(0);
+  for (std::thread& worker : workers)
+  {
+    worker.join();
+  }
+}
+
+/**
+ * Reads the diffuse texture from the MTL file associated with the OBJ.
+ * This is a very basic implementation that only looks for the first "map_Kd" entry.
+ */
+// static Texture readDiffuseTextureFromMTL(const std::filesystem::path& path)
+// {
+//   const auto content = loadFileText(path);
+//   const char* ptr = content.data();
+//   const char* end = content.data() + content.size();
+//   while (ptr < end) {
+//     ptr = skipSpace(ptr, end);
+//     if (ptr >= end) break;
+
+//     if (*ptr == '#') {
+//       ptr = nextLine(ptr, end);
+//       continue;
+//     }
+
+//     if (std::strncmp(ptr, "map_Kd", 6) == 0 && (ptr + 6 < end && std::isspace(*(ptr + 6)))) {
+//       ptr += 6; // Skip "map_Kd"
+//       ptr = skipSpace(ptr, end);
+
+//       // Extract texture path
+//       const char* lineEnd = ptr;
+//       while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r') lineEnd++;
+
+//       std::string texturePathRaw(ptr, lineEnd);
+//       std::replace(texturePathRaw.begin(), texturePathRaw.end(), '\\', '/');
+
+//       std::filesystem::path fullPath = path.parent_path() / texturePathRaw;
+
+//       return loadPNG(fullPath);
+//     }
+
+//     ptr = nextLine(ptr, end);
+//   }
+//   return { 0, 0, {} };
+// }
+} // namespace
+
+std::pair<std::vector<gpu::Vertex>, std::vector<gpu::WideIndex>> loadOBJ(
+  const std::filesystem::path& path, unsigned int threadCount)
+{
+  // Read file into memory (This is the only allocation that isn't sized up front)
+  const auto content = loadFileText(path);
+  const char* begin = content.data();
+  const char* end = content.data() + content.size();
+
+  // split into chunks at line starts, a single one unless the file is large and threads were asked for
+  const std::size_t chunkCount = std::clamp<std::size_t>(content.size() / MinChunkBytes, 1, std::max(threadCount, 1u));
+  std::vector<const char*> chunkStarts(chunkCount + 1, end);
+  chunkStarts[0] = begin;
+  for (std::size_t i = 1; i < chunkCount; ++i)
+  {
+    const char* lineEnd = findLineEnd(std::max(begin + content.size() * i / chunkCount, chunkStarts[i - 1]), end);
+    chunkStarts[i] = lineEnd + (lineEnd < end);
+  }
+
+  // count the elements of each chunk, which gives every chunk its ranges of the element arrays
+  std::vector<ElementCounts> chunkOffsets(chunkCount + 1);
+  forEachChunk(chunkCount, [&](std::size_t i) { chunkOffsets[i + 1] = scanChunk(chunkStarts[i], chunkStarts[i + 1]); });
+  for (std::size_t i = 0; i < chunkCount; ++i)
+  {
+    chunkOffsets[i + 1] += chunkOffsets[i];
+  }
+
+  ObjElements elements;
+  elements.resize(chunkOffsets[chunkCount]);
+  forEachChunk(
+    chunkCount, [&](std::size_t i) { parseChunk(chunkStarts[i], chunkStarts[i + 1], chunkOffsets[i], elements); });
+
+  // deduplicate corners and triangulate, in file order so that the result doesn't depend on the chunks
+  std::size_t triangleCount = 0;
+  for (const std::uint32_t faceSize : elements.faceSizes)
+  {
+    triangleCount += faceSize >= 3 ? faceSize - 2 : 0;
+  }
+  const std::size_t expectedVertices =
+    std::min(std::max({elements.positions.size(), elements.texCoords.size(), elements.normals.size()}), MaxVertices);
+
+  std::vector<gpu::Vertex> vertices;
+  std::vector<gpu::WideIndex> indices;
+  vertices.reserve(expectedVertices);
+  indices.reserve(3 * triangleCount);
+
+  VertexTable table(expectedVertices);
+  std::vector<gpu::WideIndex> faceVertices;
+  const Corner* corner = elements.corners.data();
+  for (const std::uint32_t faceSize : elements.faceSizes)
+  {
+    const Corner* faceEnd = corner + faceSize;
+    if (faceSize < 3)
+    {
+      corner = faceEnd;
+      continue;
+    }
+
+    faceVertices.clear();
+    for (; corner < faceEnd; ++corner)
+    {
+      bool inserted = false;
+      const std::uint32_t index = table.insert(*corner, static_cast<std::uint32_t>(vertices.size()), inserted);
+      if (inserted)
+      {
+        if (vertices.size() == MaxVertices)
+        {
+          SDL_Log("%s has more than %zu unique vertices", path.c_str(), MaxVertices);
+          return {};
+        }
+
+        const auto [v, vt, vn] = *corner;
+        gpu::Vertex& vertex = vertices.emplace_back();
+        const bool hasPosition = v >= 0 && static_cast<std::size_t>(v) < elements.positions.size();
+        vertex.position = hasPosition ? elements.positions[v] : glm::vec3{0.0f};
+        vertex.color = hasPosition ? elements.colors[v] : glm::vec3{1.0f};
+        if (vn >= 0 && static_cast<std::size_t>(vn) < elements.normals.size())
+          vertex.normal = elements.normals[vn];
+        if (vt >= 0 && static_cast<std::size_t>(vt) < elements.texCoords.size())
+          vertex.uv = elements.texCoords[vt];
+      }
+      faceVertices.push_back(index);
+    }
+
+    // Triangulate (Fan)
+    for (std::size_t i = 1; i + 1 < faceVertices.size(); ++i)
+    {
+      indices.insert(indices.end(), {faceVertices[0], faceVertices[i], faceVertices[i + 1]});
+    }
+  }
+
+  return {std::move(vertices), std::move(indices)};
+}
+
+} // namespace flb
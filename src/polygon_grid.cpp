@@ -0,0 +1,399 @@
+#include "polygon_grid.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+namespace flb
+{
+namespace
+{
+constexpr std::uint32_t NoRing = std::numeric_limits<std::uint32_t>::max();
+} // namespace
+
+void PolygonGrid::EdgeArrays::push(const EdgeArrays& from, std::uint32_t index)
+{
+  startX.push_back(from.startX[index]);
+  startY.push_back(from.startY[index]);
+  deltaX.push_back(from.deltaX[index]);
+  deltaY.push_back(from.deltaY[index]);
+  inverseLength2.push_back(from.inverseLength2[index]);
+}
+
+void PolygonGrid::EdgeArrays::push(glm::dvec2 start, glm::dvec2 end)
+{
+  const glm::dvec2 delta = end - start;
+  const double length2 = glm::dot(delta, delta);
+
+  startX.push_back(start.x);
+  startY.push_back(start.y);
+  deltaX.push_back(delta.x);
+  deltaY.push_back(delta.y);
+  inverseLength2.push_back(length2 > 0.0 ? 1.0 / length2 : 0.0);
+}
+
+void PolygonGrid::EdgeArrays::resize(std::size_t size)
+{
+  startX.resize(size);
+  startY.resize(size);
+  deltaX.resize(size);
+  deltaY.resize(size);
+  inverseLength2.resize(size);
+}
+
+void PolygonGrid::EdgeArrays::clear()
+{
+  resize(0);
+}
+
+double PolygonGrid::EdgeArrays::getMinDistance2(glm::dvec2 point, std::uint32_t begin, std::uint32_t end) const
+{
+  double best = std::numeric_limits<double>::infinity();
+  for (std::uint32_t i = begin; i < end; ++i)
+  {
+    const double offsetX = point.x - startX[i];
+    const double offsetY = point.y - startY[i];
+    const double t = std::clamp((offsetX * deltaX[i] + offsetY * deltaY[i]) * inverseLength2[i], 0.0, 1.0);
+    const double distanceX = offsetX - t * deltaX[i];
+    const double distanceY = offsetY - t * deltaY[i];
+    const double distance2 = distanceX * distanceX + distanceY * distanceY;
+    best = distance2 < best ? distance2 : best;
+  }
+  return best;
+}
+
+std::uint32_t PolygonGrid::EdgeArrays::countCrossings(glm::dvec2 point, std::uint32_t begin, std::uint32_t end) const
+{
+  // Crossings of the ray from point towards +x. Edges are half-open in y, so a ray through a vertex counts it once.
+  // Horizontal edges never span a row and are not in the row lists, deltaY is never 0 here.
+  std::uint32_t crossings = 0;
+  for (std::uint32_t i = begin; i < end; ++i)
+  {
+    const bool spans = (startY[i] > point.y) != (startY[i] + deltaY[i] > point.y);
+    const double crossingX = startX[i] + (point.y - startY[i]) * deltaX[i] / deltaY[i];
+    crossings += static_cast<std::uint32_t>(spans & (point.x < crossingX));
+  }
+  return crossings;
+}
+
+void PolygonGrid::build(std::span<const glm::dvec2> ring)
+{
+  clear();
+
+  std::vector<glm::dvec2> vertices;
+  vertices.reserve(ring.size());
+  for (const glm::dvec2 vertex : ring)
+  {
+    if (vertices.empty() || vertices.back() != vertex)
+    {
+      vertices.push_back(vertex);
+    }
+  }
+  if (vertices.size() > 1 && vertices.front() == vertices.back())
+  {
+    vertices.pop_back();
+  }
+  if (vertices.size() < 3)
+  {
+    return;
+  }
+
+  glm::dvec2 boundsMin{std::numeric_limits<double>::infinity()};
+  glm::dvec2 boundsMax{-std::numeric_limits<double>::infinity()};
+  for (std::size_t i = 0; i < vertices.size(); ++i)
+  {
+    edges.push(vertices[i], vertices[(i + 1) % vertices.size()]);
+    boundsMin = glm::min(boundsMin, vertices[i]);
+    boundsMax = glm::max(boundsMax, vertices[i]);
+  }
+
+  // About sqrt(edge count) cells along the longer axis keeps both the edges per cell and the rings per search low.
+  const glm::dvec2 extent = boundsMax - boundsMin;
+  const auto cellsPerAxis = std::clamp(
+    static_cast<std::uint32_t>(glm::ceil(glm::sqrt(static_cast<double>(edges.size())))),
+    MIN_CELLS_PER_AXIS,
+    MAX_CELLS_PER_AXIS);
+  cellSize = glm::max(glm::max(extent.x, extent.y) / cellsPerAxis, 1.0);
+  inverseCellSize = 1.0 / cellSize;
+  gridMin = boundsMin;
+  cellsX = std::clamp(static_cast<std::uint32_t>(glm::ceil(extent.x * inverseCellSize)), 1u, MAX_CELLS_PER_AXIS);
+  cellsY = std::clamp(static_cast<std::uint32_t>(glm::ceil(extent.y * inverseCellSize)), 1u, MAX_CELLS_PER_AXIS);
+
+  // counting sort of the edges into the cells their bounding boxes overlap, and into the rows they span
+  const auto edgeCount = static_cast<std::uint32_t>(edges.size());
+  const std::size_t cellCount = static_cast<std::size_t>(cellsX) * cellsY;
+  std::vector<glm::ivec2> edgeMinCells(edgeCount);
+  std::vector<glm::ivec2> edgeMaxCells(edgeCount);
+  cellStart.assign(cellCount + 1, 0);
+  rowStart.assign(cellsY + 1, 0);
+  for (std::uint32_t i = 0; i < edgeCount; ++i)
+  {
+    const glm::dvec2 start{edges.startX[i], edges.startY[i]};
+    const glm::dvec2 end = start + glm::dvec2{edges.deltaX[i], edges.deltaY[i]};
+    edgeMinCells[i] = getCell(glm::min(start, end));
+    edgeMaxCells[i] = getCell(glm::max(start, end));
+
+    for (int y = edgeMinCells[i].y; y <= edgeMaxCells[i].y; ++y)
+    {
+      for (int x = edgeMinCells[i].x; x <= edgeMaxCells[i].x; ++x)
+      {
+        ++cellStart[getCellIndex({x, y}) + 1];
+      }
+      if (edges.deltaY[i] != 0.0)
+      {
+        ++rowStart[y + 1];
+      }
+    }
+  }
+
+  for (std::size_t cell = 1; cell < cellStart.size(); ++cell)
+  {
+    cellStart[cell] += cellStart[cell - 1];
+  }
+  for (std::size_t row = 1; row < rowStart.size(); ++row)
+  {
+    rowStart[row] += rowStart[row - 1];
+  }
+
+  cellEdgeIndices.assign(cellStart.back(), 0);
+  std::vector<std::uint32_t> rowEdgeIndices(rowStart.back());
+  std::vector<std::uint32_t> cellCursors(cellStart.begin(), cellStart.end() - 1);
+  std::vector<std::uint32_t> rowCursors(rowStart.begin(), rowStart.end() - 1);
+  for (std::uint32_t i = 0; i < edgeCount; ++i)
+  {
+    for (int y = edgeMinCells[i].y; y <= edgeMaxCells[i].y; ++y)
+    {
+      for (int x = edgeMinCells[i].x; x <= edgeMaxCells[i].x; ++x)
+      {
+        cellEdgeIndices[cellCursors[getCellIndex({x, y})]++] = i;
+      }
+      if (edges.deltaY[i] != 0.0)
+      {
+        rowEdgeIndices[rowCursors[y]++] = i;
+      }
+    }
+  }
+
+  cellEdges.clear();
+  for (const std::uint32_t edge : cellEdgeIndices)
+  {
+    cellEdges.push(edges, edge);
+  }
+  rowEdges.clear();
+  for (const std::uint32_t edge : rowEdgeIndices)
+  {
+    rowEdges.push(edges, edge);
+  }
+
+  // Chebyshev distance from every cell to the nearest non-empty cell, breadth first from the non-empty cells
+  cellEmptyRings.assign(cellCount, NoRing);
+  std::queue<glm::ivec2> frontier;
+  for (std::uint32_t y = 0; y < cellsY; ++y)
+  {
+    for (std::uint32_t x = 0; x < cellsX; ++x)
+    {
+      const glm::ivec2 cell{static_cast<int>(x), static_cast<int>(y)};
+      const std::uint32_t cellIndex = getCellIndex(cell);
+      if (cellStart[cellIndex] != cellStart[cellIndex + 1])
+      {
+        cellEmptyRings[cellIndex] = 0;
+        frontier.push(cell);
+      }
+    }
+  }
+  while (!frontier.empty())
+  {
+    const glm::ivec2 cell = frontier.front();
+    frontier.pop();
+    const std::uint32_t rings = cellEmptyRings[getCellIndex(cell)] + 1;
+    for (int y = glm::max(cell.y - 1, 0); y <= glm::min(cell.y + 1, static_cast<int>(cellsY) - 1); ++y)
+    {
+      for (int x = glm::max(cell.x - 1, 0); x <= glm::min(cell.x + 1, static_cast<int>(cellsX) - 1); ++x)
+      {
+        std::uint32_t& neighbourRings = cellEmptyRings[getCellIndex({x, y})];
+        if (neighbourRings == NoRing)
+        {
+          neighbourRings = rings;
+          frontier.push({x, y});
+        }
+      }
+    }
+  }
+
+  // Nearest edge to every cell center. The previous cell's nearest edge is a good starting bound for the search.
+  cellNearestEdge.assign(cellCount, 0);
+  std::uint32_t previousNearestEdge = 0;
+  for (std::uint32_t y = 0; y < cellsY; ++y)
+  {
+    for (std::uint32_t x = 0; x < cellsX; ++x)
+    {
+      const glm::dvec2 center = gridMin + glm::dvec2{x + 0.5, y + 0.5} * cellSize;
+      std::uint32_t nearestEdge = previousNearestEdge;
+      getNearestDistance2(center, previousNearestEdge, &nearestEdge);
+
+      cellNearestEdge[getCellIndex({static_cast<int>(x), static_cast<int>(y)})] = nearestEdge;
+      previousNearestEdge = nearestEdge;
+    }
+  }
+}
+
+void PolygonGrid::clear()
+{
+  edges.clear();
+  cellEdges.clear();
+  rowEdges.clear();
+  cellStart.clear();
+  cellEdgeIndices.clear();
+  rowStart.clear();
+  cellNearestEdge.clear();
+  cellEmptyRings.clear();
+  cellsX = 0;
+  cellsY = 0;
+}
+
+bool PolygonGrid::contains(glm::dvec2 point) const
+{
+  if (empty())
+  {
+    return false;
+  }
+
+  const double row = glm::floor((point.y - gridMin.y) * inverseCellSize);
+  if (row < 0.0 || row >= cellsY)
+  {
+    return false;
+  }
+
+  const auto rowIndex = static_cast<std::uint32_t>(row);
+  return (rowEdges.countCrossings(point, rowStart[rowIndex], rowStart[rowIndex + 1]) & 1u) != 0;
+}
+
+double PolygonGrid::getSignedDistance(glm::dvec2 point) const
+{
+  if (empty())
+  {
+    return -std::numeric_limits<double>::infinity();
+  }
+
+  const glm::ivec2 cell = getCell(point);
+  const double distance = glm::sqrt(getNearestDistance2(point, cellNearestEdge[getCellIndex(cell)]));
+  return contains(point) ? distance : -distance;
+}
+
+void PolygonGrid::query(std::span<const glm::dvec2> points, std::span<double> outSignedDistances) const
+{
+  const std::size_t count = std::min(points.size(), outSignedDistances.size());
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    outSignedDistances[i] = getSignedDistance(points[i]);
+  }
+}
+
+glm::ivec2 PolygonGrid::getCell(glm::dvec2 point) const
+{
+  const glm::dvec2 cell = glm::clamp(
+    glm::floor((point - gridMin) * inverseCellSize), glm::dvec2{0.0}, glm::dvec2{cellsX - 1.0, cellsY - 1.0});
+  return {static_cast<int>(cell.x), static_cast<int>(cell.y)};
+}
+
+double PolygonGrid::getNearestDistance2(glm::dvec2 point, std::uint32_t initialEdge, std::uint32_t* outEdge) const
+{
+  // Searches square rings of cells around the cell of the point, starting with the first non-empty ring, until the
+  // next ring is further away than the nearest edge found so far.
+  const glm::ivec2 center = getCell(point);
+  const int lastX = static_cast<int>(cellsX) - 1;
+  const int lastY = static_cast<int>(cellsY) - 1;
+
+  double best = getEdgeDistance2(point, initialEdge);
+  if (outEdge != nullptr)
+  {
+    *outEdge = initialEdge;
+  }
+
+  const auto visitCell = [&](int x, int y)
+  {
+    const std::uint32_t cell = getCellIndex({x, y});
+    if (cellStart[cell] == cellStart[cell + 1])
+    {
+      return;
+    }
+
+    if (outEdge == nullptr)
+    {
+      best = glm::min(best, cellEdges.getMinDistance2(point, cellStart[cell], cellStart[cell + 1]));
+      return;
+    }
+
+    for (std::uint32_t item = cellStart[cell]; item < cellStart[cell + 1]; ++item)
+    {
+      const double distance2 = cellEdges.getMinDistance2(point, item, item + 1);
+      if (distance2 < best)
+      {
+        best = distance2;
+        *outEdge = cellEdgeIndices[item];
+      }
+    }
+  };
+
+  for (int ring = static_cast<int>(cellEmptyRings[getCellIndex(center)]);; ++ring)
+  {
+    if (ring == 0)
+    {
+      visitCell(center.x, center.y);
+      continue;
+    }
+
+    // Distance to the closest side of the ring that lies within the grid. Points outside the grid are only ever
+    // further away from the sides than this.
+    const bool hasLeft = center.x - ring >= 0;
+    const bool hasRight = center.x + ring <= lastX;
+    const bool hasTop = center.y - ring >= 0;
+    const bool hasBottom = center.y + ring <= lastY;
+    double ringDistance = std::numeric_limits<double>::infinity();
+    if (hasLeft)
+      ringDistance = glm::min(ringDistance, point.x - (gridMin.x + (center.x - ring + 1) * cellSize));
+    if (hasRight)
+      ringDistance = glm::min(ringDistance, gridMin.x + (center.x + ring) * cellSize - point.x);
+    if (hasTop)
+      ringDistance = glm::min(ringDistance, point.y - (gridMin.y + (center.y - ring + 1) * cellSize));
+    if (hasBottom)
+      ringDistance = glm::min(ringDistance, gridMin.y + (center.y + ring) * cellSize - point.y);
+
+    if (ringDistance == std::numeric_limits<double>::infinity())
+    {
+      break;
+    }
+    if (ringDistance > 0.0 && ringDistance * ringDistance >= best)
+    {
+      break;
+    }
+
+    const int minX = glm::max(center.x - ring, 0);
+    const int maxX = glm::min(center.x + ring, lastX);
+    const int minY = glm::max(center.y - ring + 1, 0);
+    const int maxY = glm::min(center.y + ring - 1, lastY);
+    for (int x = minX; x <= maxX; ++x)
+    {
+      if (hasTop)
+        visitCell(x, center.y - ring);
+      if (hasBottom)
+        visitCell(x, center.y + ring);
+    }
+    for (int y = minY; y <= maxY; ++y)
+    {
+      if (hasLeft)
+        visitCell(center.x - ring, y);
+      if (hasRight)
+        visitCell(center.x + ring, y);
+    }
+  }
+
+  return best;
+}
+
+double PolygonGrid::getEdgeDistance2(glm::dvec2 point, std::uint32_t edge) const
+{
+  return edges.getMinDistance2(point, edge, edge + 1);
+}
+
+} // namespace flb
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace flb
+{
+
+/**
+ * Spatial index over the edges of a closed polygon in a local ENU plane. Answers point-in-polygon and the signed
+ * distance to the nearest edge.
+ *
+ * Edges are bucketed by their bounding box into a uniform grid. Each row of cells also keeps a list of every edge
+ * that spans it, so a point-in-polygon test only casts its ray against the edges of one row. Each cell remembers the
+ * edge nearest to its center and how many rings of empty cells surround it, which gives nearest-edge searches a tight
+ * starting bound and lets them skip the empty rings.
+ *
+ * Edge lists are stored as structure of arrays, one copy per cell and per row, and the inner loops over them are
+ * branchless so the compiler can vectorize them.
+ */
+class PolygonGrid
+{
+public:
+  static constexpr std::uint32_t MIN_CELLS_PER_AXIS = 4;
+  static constexpr std::uint32_t MAX_CELLS_PER_AXIS = 256;
+
+  /**
+   * ring is the list of polygon vertices, the last vertex connects back to the first.
+   */
+  void build(std::span<const glm::dvec2> ring);
+  void clear();
+  bool empty() const { return edges.size() == 0; }
+
+  bool contains(glm::dvec2 point) const;
+
+  /**
+   * Distance to the nearest edge, positive inside the polygon and negative outside.
+   */
+  double getSignedDistance(glm::dvec2 point) const;
+
+  /**
+   * Signed distance of every point, written to the same index of outSignedDistances.
+   */
+  void query(std::span<const glm::dvec2> points, std::span<double> outSignedDistances) const;
+
+private:
+  struct EdgeArrays
+  {
+    std::vector<double> startX;
+    std::vector<double> startY;
+    std::vector<double> deltaX;
+    std::vector<double> deltaY;
+    // 1 / squared edge length, 0 for degenerate edges
+    std::vector<double> inverseLength2;
+
+    void push(const EdgeArrays& from, std::uint32_t index);
+    void push(glm::dvec2 start, glm::dvec2 end);
+    void resize(std::size_t size);
+    void clear();
+    std::size_t size() const { return startX.size(); }
+
+    double getMinDistance2(glm::dvec2 point, std::uint32_t begin, std::uint32_t end) const;
+    std::uint32_t countCrossings(glm::dvec2 point, std::uint32_t begin, std::uint32_t end) const;
+  };
+
+  glm::ivec2 getCell(glm::dvec2 point) const;
+  std::uint32_t getCellIndex(glm::ivec2 cell) const { return static_cast<std::uint32_t>(cell.y) * cellsX + cell.x; }
+  // outEdge, if given, receives the index of the nearest edge
+  double getNearestDistance2(glm::dvec2 point, std::uint32_t initialEdge, std::uint32_t* outEdge = nullptr) const;
+  double getEdgeDistance2(glm::dvec2 point, std::uint32_t edge) const;
+
+  EdgeArrays edges;
+
+  glm::dvec2 gridMin{0.0};
+  double cellSize = 1.0;
+  double inverseCellSize = 1.0;
+  std::uint32_t cellsX = 0;
+  std::uint32_t cellsY = 0;
+
+  // edges overlapping each cell, cell i owns cellEdges[cellStart[i], cellStart[i + 1])
+  std::vector<std::uint32_t> cellStart;
+  EdgeArrays cellEdges;
+  std::vector<std::uint32_t> cellEdgeIndices;
+  // per cell, edge nearest to the cell center and the number of empty cell rings around the cell
+  std::vector<std::uint32_t> cellNearestEdge;
+  std::vector<std::uint32_t> cellEmptyRings;
+
+  // edges spanning each row, row i owns rowEdges[rowStart[i], rowStart[i + 1])
+  std::vector<std::uint32_t> rowStart;
+  EdgeArrays rowEdges;
+};
+
+} // namespace flb
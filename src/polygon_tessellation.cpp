@@ -0,0 +1,463 @@
+#include "polygon_tessellation.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace flb
+{
+namespace
+{
+constexpr std::uint32_t NoNode = std::numeric_limits<std::uint32_t>::max();
+
+/**
+ * Ear clipper over a circular doubly linked list of polygon vertices. Nodes live in one vector and link by index, so
+ * splitting the list for hole bridges only appends nodes.
+ */
+class EarClipper
+{
+public:
+  EarClipper(std::span<const glm::dvec2> vertices, std::vector<std::uint32_t>& outIndices)
+      : vertices(vertices), triangles(outIndices)
+  {
+  }
+
+  void run(std::span<const std::uint32_t> ringStarts)
+  {
+    nodes.reserve(vertices.size() + 2 * ringStarts.size());
+
+    std::uint32_t outer = createRing(ringStarts[0], ringStarts[1], true);
+    if (outer == NoNode || nodes[outer].next == nodes[outer].prev)
+    {
+      return;
+    }
+
+    if (ringStarts.size() > 2)
+    {
+      outer = eliminateHoles(ringStarts, outer);
+    }
+
+    clip(outer, 0);
+  }
+
+private:
+  struct Node
+  {
+    std::uint32_t vertex;
+    double x;
+    double y;
+    std::uint32_t prev;
+    std::uint32_t next;
+  };
+
+  /**
+   * Negative if p, q, r turn counter-clockwise, which makes q convex in a counter-clockwise ring.
+   */
+  double area(std::uint32_t p, std::uint32_t q, std::uint32_t r) const
+  {
+    const Node& a = nodes[p];
+    const Node& b = nodes[q];
+    const Node& c = nodes[r];
+    return (b.y - a.y) * (c.x - b.x) - (b.x - a.x) * (c.y - b.y);
+  }
+
+  bool equals(std::uint32_t a, std::uint32_t b) const { return nodes[a].x == nodes[b].x && nodes[a].y == nodes[b].y; }
+
+  static bool isInTriangle(double ax, double ay, double bx, double by, double cx, double cy, double px, double py)
+  {
+    return (cx - px) * (ay - py) >= (ax - px) * (cy - py) && (ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+           (bx - px) * (cy - py) >= (cx - px) * (by - py);
+  }
+
+  std::uint32_t insertNode(std::uint32_t vertex, std::uint32_t last)
+  {
+    const std::uint32_t node = static_cast<std::uint32_t>(nodes.size());
+    nodes.push_back({vertex, vertices[vertex].x, vertices[vertex].y, node, node});
+    if (last != NoNode)
+    {
+      nodes[node].next = nodes[last].next;
+      nodes[node].prev = last;
+      nodes[nodes[last].next].prev = node;
+      nodes[last].next = node;
+    }
+    return node;
+  }
+
+  void removeNode(std::uint32_t node)
+  {
+    nodes[nodes[node].next].prev = nodes[node].prev;
+    nodes[nodes[node].prev].next = nodes[node].next;
+  }
+
+  /**
+   * Links the vertices [begin, end) into a ring, counter-clockwise for the outer ring and clockwise for holes.
+   */
+  std::uint32_t createRing(std::uint32_t begin, std::uint32_t end, bool outer)
+  {
+    if (end - begin < 3)
+    {
+      return NoNode;
+    }
+
+    double signedArea = 0.0;
+    for (std::uint32_t i = begin, j = end - 1; i < end; j = i++)
+    {
+      signedArea += (vertices[j].x - vertices[i].x) * (vertices[i].y + vertices[j].y);
+    }
+
+    std::uint32_t last = NoNode;
+    if (outer == (signedArea > 0.0))
+    {
+      for (std::uint32_t i = begin; i < end; ++i)
+      {
+        last = insertNode(i, last);
+      }
+    }
+    else
+    {
+      for (std::uint32_t i = end; i-- > begin;)
+      {
+        last = insertNode(i, last);
+      }
+    }
+
+    if (equals(last, nodes[last].next))
+    {
+      const std::uint32_t next = nodes[last].next;
+      removeNode(last);
+      last = next;
+    }
+    return last;
+  }
+
+  /**
+   * Removes duplicate and collinear vertices between start and end, returns a node that is still in the ring.
+   */
+  std::uint32_t filterPoints(std::uint32_t start, std::uint32_t end = NoNode)
+  {
+    end = end == NoNode ? start : end;
+
+    std::uint32_t node = start;
+    bool again = false;
+    do
+    {
+      again = false;
+      if (equals(node, nodes[node].next) || area(nodes[node].prev, node, nodes[node].next) == 0.0)
+      {
+        removeNode(node);
+        node = end = nodes[node].prev;
+        if (node == nodes[node].next)
+        {
+          break;
+        }
+        again = true;
+      }
+      else
+      {
+        node = nodes[node].next;
+      }
+    } while (again || node != end);
+
+    return end;
+  }
+
+  std::uint32_t eliminateHoles(std::span<const std::uint32_t> ringStarts, std::uint32_t outer)
+  {
+    std::vector<std::uint32_t> leftmostNodes;
+    for (std::size_t ring = 1; ring + 1 < ringStarts.size(); ++ring)
+    {
+      const std::uint32_t hole = createRing(ringStarts[ring], ringStarts[ring + 1], false);
+      if (hole != NoNode && nodes[hole].next != hole)
+      {
+        leftmostNodes.push_back(getLeftmost(hole));
+      }
+    }
+
+    // bridging from left to right keeps earlier bridges from crossing the later ones
+    std::sort(
+      leftmostNodes.begin(),
+      leftmostNodes.end(),
+      [&](std::uint32_t a, std::uint32_t b)
+      { return nodes[a].x < nodes[b].x || (nodes[a].x == nodes[b].x && nodes[a].y < nodes[b].y); });
+
+    for (const std::uint32_t hole : leftmostNodes)
+    {
+      const std::uint32_t bridge = findHoleBridge(hole, outer);
+      if (bridge == NoNode)
+      {
+        continue;
+      }
+
+      const std::uint32_t bridgeReverse = splitPolygon(bridge, hole);
+      filterPoints(bridgeReverse, nodes[bridgeReverse].next);
+      outer = filterPoints(bridge, nodes[bridge].next);
+    }
+
+    return outer;
+  }
+
+  std::uint32_t getLeftmost(std::uint32_t start) const
+  {
+    std::uint32_t node = start;
+    std::uint32_t leftmost = start;
+    do
+    {
+      const Node& p = nodes[node];
+      if (p.x < nodes[leftmost].x || (p.x == nodes[leftmost].x && p.y < nodes[leftmost].y))
+      {
+        leftmost = node;
+      }
+      node = nodes[node].next;
+    } while (node != start);
+    return leftmost;
+  }
+
+  /**
+   * Finds a vertex of the outer ring that the leftmost hole vertex can connect to without crossing an edge. Casts a
+   * ray to the left, then among the vertices inside the triangle it spans picks the one at the smallest angle.
+   */
+  std::uint32_t findHoleBridge(std::uint32_t hole, std::uint32_t outer) const
+  {
+    const double hx = nodes[hole].x;
+    const double hy = nodes[hole].y;
+    double qx = -std::numeric_limits<double>::infinity();
+    std::uint32_t bridge = NoNode;
+
+    std::uint32_t node = outer;
+    do
+    {
+      const Node& p = nodes[node];
+      const Node& next = nodes[p.next];
+      if (hy <= p.y && hy >= next.y && next.y != p.y)
+      {
+        const double x = p.x + (hy - p.y) * (next.x - p.x) / (next.y - p.y);
+        if (x <= hx && x > qx)
+        {
+          qx = x;
+          bridge = p.x < next.x ? node : p.next;
+          if (x == hx)
+          {
+            return bridge;
+          }
+        }
+      }
+      node = p.next;
+    } while (node != outer);
+
+    if (bridge == NoNode)
+    {
+      return NoNode;
+    }
+
+    const std::uint32_t stop = bridge;
+    const double mx = nodes[bridge].x;
+    const double my = nodes[bridge].y;
+    double minTangent = std::numeric_limits<double>::infinity();
+
+    node = bridge;
+    do
+    {
+      const Node& p = nodes[node];
+      if (
+        hx >= p.x && p.x >= mx && hx != p.x &&
+        isInTriangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p.x, p.y))
+      {
+        const double tangent = glm::abs(hy - p.y) / (hx - p.x);
+        if (
+          isLocallyInside(node, hole) &&
+          (tangent < minTangent ||
+           (tangent == minTangent &&
+            (p.x > nodes[bridge].x || (p.x == nodes[bridge].x && sectorContainsSector(bridge, node))))))
+        {
+          bridge = node;
+          minTangent = tangent;
+        }
+      }
+      node = p.next;
+    } while (node != stop);
+
+    return bridge;
+  }
+
+  bool sectorContainsSector(std::uint32_t m, std::uint32_t p) const
+  {
+    return area(nodes[m].prev, m, nodes[p].prev) < 0.0 && area(nodes[p].next, m, nodes[m].next) < 0.0;
+  }
+
+  /**
+   * Whether the diagonal from a to b starts inside the polygon at a.
+   */
+  bool isLocallyInside(std::uint32_t a, std::uint32_t b) const
+  {
+    const std::uint32_t prev = nodes[a].prev;
+    const std::uint32_t next = nodes[a].next;
+    return area(prev, a, next) < 0.0 ? area(a, b, next) >= 0.0 && area(a, prev, b) >= 0.0
+                                     : area(a, b, prev) < 0.0 || area(a, next, b) < 0.0;
+  }
+
+  /**
+   * Connects a and b with a pair of edges, which splits one ring into two or joins two rings into one. Returns the copy
+   * of b that belongs to the new pair.
+   */
+  std::uint32_t splitPolygon(std::uint32_t a, std::uint32_t b)
+  {
+    const std::uint32_t a2 = static_cast<std::uint32_t>(nodes.size());
+    const std::uint32_t b2 = a2 + 1;
+    const Node copyA = nodes[a];
+    const Node copyB = nodes[b];
+    nodes.push_back(copyA);
+    nodes.push_back(copyB);
+
+    const std::uint32_t an = nodes[a].next;
+    const std::uint32_t bp = nodes[b].prev;
+
+    nodes[a].next = b;
+    nodes[b].prev = a;
+    nodes[a2].next = an;
+    nodes[an].prev = a2;
+    nodes[b2].next = a2;
+    nodes[a2].prev = b2;
+    nodes[bp].next = b2;
+    nodes[b2].prev = bp;
+
+    return b2;
+  }
+
+  bool isEar(std::uint32_t ear) const
+  {
+    const std::uint32_t a = nodes[ear].prev;
+    const std::uint32_t c = nodes[ear].next;
+    if (area(a, ear, c) >= 0.0)
+    {
+      return false;
+    }
+
+    const Node& na = nodes[a];
+    const Node& nb = nodes[ear];
+    const Node& nc = nodes[c];
+    const double minX = glm::min(na.x, glm::min(nb.x, nc.x));
+    const double minY = glm::min(na.y, glm::min(nb.y, nc.y));
+    const double maxX = glm::max(na.x, glm::max(nb.x, nc.x));
+    const double maxY = glm::max(na.y, glm::max(nb.y, nc.y));
+
+    // only a reflex vertex inside the triangle can make it a non-ear
+    for (std::uint32_t node = nc.next; node != a; node = nodes[node].next)
+    {
+      const Node& p = nodes[node];
+      if (
+        p.x >= minX && p.x <= maxX && p.y >= minY && p.y <= maxY && !(p.x == na.x && p.y == na.y) &&
+        isInTriangle(na.x, na.y, nb.x, nb.y, nc.x, nc.y, p.x, p.y) && area(p.prev, node, p.next) >= 0.0)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static int getSign(double value) { return (value > 0.0) - (value < 0.0); }
+
+  static bool isOnSegment(const Node& p, const Node& q, const Node& r)
+  {
+    return q.x <= glm::max(p.x, r.x) && q.x >= glm::min(p.x, r.x) && q.y <= glm::max(p.y, r.y) &&
+           q.y >= glm::min(p.y, r.y);
+  }
+
+  bool intersects(std::uint32_t p1, std::uint32_t q1, std::uint32_t p2, std::uint32_t q2) const
+  {
+    const int o1 = getSign(area(p1, q1, p2));
+    const int o2 = getSign(area(p1, q1, q2));
+    const int o3 = getSign(area(p2, q2, p1));
+    const int o4 = getSign(area(p2, q2, q1));
+
+    return (o1 != o2 && o3 != o4) || (o1 == 0 && isOnSegment(nodes[p1], nodes[p2], nodes[q1])) ||
+           (o2 == 0 && isOnSegment(nodes[p1], nodes[q2], nodes[q1])) ||
+           (o3 == 0 && isOnSegment(nodes[p2], nodes[p1], nodes[q2])) ||
+           (o4 == 0 && isOnSegment(nodes[p2], nodes[q1], nodes[q2]));
+  }
+
+  /**
+   * Clips away small self-intersections where the edges before and after a vertex cross.
+   */
+  std::uint32_t cureLocalIntersections(std::uint32_t start)
+  {
+    std::uint32_t node = start;
+    do
+    {
+      const std::uint32_t a = nodes[node].prev;
+      const std::uint32_t next = nodes[node].next;
+      const std::uint32_t b = nodes[next].next;
+      if (!equals(a, b) && intersects(a, node, next, b) && isLocallyInside(a, b) && isLocallyInside(b, a))
+      {
+        emitTriangle(a, node, b);
+        removeNode(node);
+        removeNode(next);
+        node = start = b;
+      }
+      node = nodes[node].next;
+    } while (node != start);
+
+    return filterPoints(node);
+  }
+
+  void emitTriangle(std::uint32_t a, std::uint32_t b, std::uint32_t c)
+  {
+    triangles.push_back(nodes[a].vertex);
+    triangles.push_back(nodes[b].vertex);
+    triangles.push_back(nodes[c].vertex);
+  }
+
+  /**
+   * Clips ears until the ring is used up. When a full round finds no ear the ring is cleaned up, first by removing
+   * degenerate vertices and then by curing local self-intersections, before giving up on the rest.
+   */
+  void clip(std::uint32_t ear, int pass)
+  {
+    std::uint32_t stop = ear;
+    while (nodes[ear].prev != nodes[ear].next)
+    {
+      const std::uint32_t prev = nodes[ear].prev;
+      const std::uint32_t next = nodes[ear].next;
+      if (isEar(ear))
+      {
+        emitTriangle(prev, ear, next);
+        removeNode(ear);
+        ear = stop = nodes[next].next;
+        continue;
+      }
+
+      ear = next;
+      if (ear == stop)
+      {
+        if (pass == 0)
+        {
+          clip(filterPoints(ear), 1);
+        }
+        else if (pass == 1)
+        {
+          clip(cureLocalIntersections(filterPoints(ear)), 2);
+        }
+        return;
+      }
+    }
+  }
+
+  std::span<const glm::dvec2> vertices;
+  std::vector<std::uint32_t>& triangles;
+  std::vector<Node> nodes;
+};
+} // namespace
+
+void tessellatePolygon(
+  std::span<const glm::dvec2> vertices,
+  std::span<const std::uint32_t> ringStarts,
+  std::vector<std::uint32_t>& outIndices)
+{
+  if (ringStarts.size() < 2)
+  {
+    return;
+  }
+
+  EarClipper clipper(vertices, outIndices);
+  clipper.run(ringStarts);
+}
+
+} // namespace flb
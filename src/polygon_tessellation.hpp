@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace flb
+{
+
+/**
+ * Triangulates a polygon with holes by ear clipping. vertices holds the outer ring followed by the holes, ring i owns
+ * vertices[ringStarts[i], ringStarts[i + 1]), and ringStarts ends with vertices.size(). Rings may have either winding.
+ *
+ * Holes are first joined to the outer ring by bridge edges, which leaves a single ring to clip. The triangles are
+ * appended to outIndices as indices into vertices, counter-clockwise. Self-intersecting input doesn't fail, but the
+ * parts that can't be clipped are left out.
+ *
+ * Clipping tests every remaining vertex against every ear candidate, which is fine for the tens to hundreds of
+ * vertices of typical zone outlines but quadratic for very large rings.
+ */
+void tessellatePolygon(
+  std::span<const glm::dvec2> vertices,
+  std::span<const std::uint32_t> ringStarts,
+  std::vector<std::uint32_t>& outIndices);
+
+} // namespace flb
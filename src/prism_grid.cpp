@@ -0,0 +1,197 @@
+#include "prism_grid.hpp"
+
+#include "math.hpp"
+
+#include <algorithm>
+
+namespace flb
+{
+namespace
+{
+constexpr double Infinity = std::numeric_limits<double>::infinity();
+} // namespace
+
+void PrismGrid::build(
+  std::span<const glm::dvec2> vertices, std::span<const std::uint32_t> ringStarts, std::span<const Prism> prisms)
+{
+  clear();
+  if (prisms.empty())
+  {
+    return;
+  }
+
+  bottom.reserve(prisms.size());
+  top.reserve(prisms.size());
+  edgeStart.reserve(prisms.size() + 1);
+  edgeStartX.reserve(vertices.size());
+  edgeStartY.reserve(vertices.size());
+  edgeDeltaX.reserve(vertices.size());
+  edgeDeltaY.reserve(vertices.size());
+
+  std::vector<CylinderGrid::Cylinder> bounds;
+  bounds.reserve(prisms.size());
+
+  edgeStart.push_back(0);
+  for (const Prism& prism : prisms)
+  {
+    glm::dvec2 boundsMin{Infinity};
+    glm::dvec2 boundsMax{-Infinity};
+    for (std::uint32_t ring = prism.firstRing; ring < prism.firstRing + prism.ringCount; ++ring)
+    {
+      const std::uint32_t begin = ringStarts[ring];
+      const std::uint32_t end = ringStarts[ring + 1];
+      for (std::uint32_t i = begin, previous = end - 1; i < end; previous = i++)
+      {
+        edgeStartX.push_back(vertices[previous].x);
+        edgeStartY.push_back(vertices[previous].y);
+        edgeDeltaX.push_back(vertices[i].x - vertices[previous].x);
+        edgeDeltaY.push_back(vertices[i].y - vertices[previous].y);
+        boundsMin = glm::min(boundsMin, vertices[i]);
+        boundsMax = glm::max(boundsMax, vertices[i]);
+      }
+    }
+
+    bottom.push_back(prism.bottom);
+    top.push_back(prism.top);
+    edgeStart.push_back(static_cast<std::uint32_t>(edgeStartX.size()));
+    bounds.push_back({
+      .center = 0.5 * (boundsMin + boundsMax),
+      .radius = 0.5 * glm::length(boundsMax - boundsMin),
+      .bottom = prism.bottom,
+      .top = prism.top,
+    });
+  }
+
+  boundsGrid.build(bounds);
+}
+
+void PrismGrid::clear()
+{
+  boundsGrid.clear();
+  bottom.clear();
+  top.clear();
+  edgeStart.clear();
+  edgeStartX.clear();
+  edgeStartY.clear();
+  edgeDeltaX.clear();
+  edgeDeltaY.clear();
+}
+
+void PrismGrid::query(
+  std::span<const glm::dvec3> positions,
+  std::span<const glm::dvec3> velocities,
+  double horizon,
+  std::span<Hit> outHits) const
+{
+  std::vector<double> crossings;
+  const std::size_t count = std::min(positions.size(), outHits.size());
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const glm::dvec3 velocity = i < velocities.size() ? velocities[i] : glm::dvec3{0.0};
+    outHits[i] = empty() ? Hit{} : queryPoint(positions[i], velocity, horizon, crossings);
+  }
+}
+
+PrismGrid::Hit PrismGrid::queryPoint(
+  const glm::dvec3& position, const glm::dvec3& velocity, double horizon, std::vector<double>& crossings) const
+{
+  Hit hit{};
+
+  const glm::dvec2 start{position};
+  const glm::dvec2 end = start + glm::dvec2{velocity} * horizon;
+  boundsGrid.forEachCandidate(
+    glm::min(start, end),
+    glm::max(start, end),
+    [&](std::uint32_t index)
+    {
+      if (position.z >= bottom[index] && position.z <= top[index] && contains(index, start))
+      {
+        hit.containing = index;
+        hit.next = index;
+        hit.timeToEntry = 0.0;
+        return false;
+      }
+
+      const double entryTime = getEntryTime(index, position, velocity, horizon, crossings);
+      if (entryTime < hit.timeToEntry)
+      {
+        hit.next = index;
+        hit.timeToEntry = entryTime;
+      }
+      return true;
+    });
+
+  return hit;
+}
+
+bool PrismGrid::contains(std::uint32_t index, glm::dvec2 point) const
+{
+  // even-odd rule over the edges of all rings, a ray cast towards +x
+  std::uint32_t crossings = 0;
+  for (std::uint32_t edge = edgeStart[index]; edge < edgeStart[index + 1]; ++edge)
+  {
+    const double startY = edgeStartY[edge];
+    const double endY = startY + edgeDeltaY[edge];
+    const bool spans = (startY > point.y) != (endY > point.y);
+    const double x = edgeStartX[edge] + (point.y - startY) * edgeDeltaX[edge] / (spans ? edgeDeltaY[edge] : 1.0);
+    crossings += spans && point.x < x;
+  }
+  return (crossings & 1) != 0;
+}
+
+double PrismGrid::getEntryTime(
+  std::uint32_t index,
+  const glm::dvec3& position,
+  const glm::dvec3& velocity,
+  double horizon,
+  std::vector<double>& crossings) const
+{
+  const Interval vertical = getSlabInterval(position.z, velocity.z, bottom[index], top[index]);
+  const double verticalBegin = glm::max(vertical.begin, 0.0);
+  const double verticalEnd = glm::min(vertical.end, horizon);
+  if (verticalBegin > verticalEnd)
+  {
+    return Infinity;
+  }
+
+  // times at which the horizontal track crosses an edge, the track alternates between inside and outside at each
+  crossings.clear();
+  const glm::dvec2 start{position};
+  if (glm::dot(glm::dvec2{velocity}, glm::dvec2{velocity}) > 1e-12)
+  {
+    for (std::uint32_t edge = edgeStart[index]; edge < edgeStart[index + 1]; ++edge)
+    {
+      const glm::dvec2 offset{edgeStartX[edge] - start.x, edgeStartY[edge] - start.y};
+      const double denominator = velocity.x * edgeDeltaY[edge] - velocity.y * edgeDeltaX[edge];
+      if (glm::abs(denominator) < 1e-12)
+      {
+        continue;
+      }
+
+      const double t = (offset.x * edgeDeltaY[edge] - offset.y * edgeDeltaX[edge]) / denominator;
+      const double u = (offset.x * velocity.y - offset.y * velocity.x) / denominator;
+      if (t > 0.0 && t <= horizon && u >= 0.0 && u < 1.0)
+      {
+        crossings.push_back(t);
+      }
+    }
+    std::sort(crossings.begin(), crossings.end());
+  }
+
+  bool inside = contains(index, start);
+  double begin = 0.0;
+  for (std::size_t i = 0; i <= crossings.size(); ++i)
+  {
+    const double end = i < crossings.size() ? crossings[i] : horizon;
+    if (inside && glm::max(begin, verticalBegin) <= glm::min(end, verticalEnd))
+    {
+      return glm::max(begin, verticalBegin);
+    }
+    inside = !inside;
+    begin = end;
+  }
+
+  return Infinity;
+}
+
+} // namespace flb
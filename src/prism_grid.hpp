@@ -0,0 +1,84 @@
+#pragma once
+
+#include "cylinder_grid.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace flb
+{
+
+/**
+ * Spatial index over vertical prisms with polygonal cross sections, polygons with holes in a local ENU frame. Answers
+ * the same queries as CylinderGrid.
+ *
+ * Every prism is entered into a CylinderGrid by its bounding cylinder, which narrows a query down to a few candidates
+ * that are then tested exactly against their edges. The edges of all prisms are stored back to back as structure of
+ * arrays, prism i owns edges [edgeStart[i], edgeStart[i + 1]).
+ */
+class PrismGrid
+{
+public:
+  using Hit = CylinderGrid::Hit;
+
+  static constexpr std::uint32_t NONE = CylinderGrid::NONE;
+
+  /**
+   * Prism over the rings [firstRing, firstRing + ringCount) of the ring list passed to build(), an outer ring followed
+   * by its holes.
+   */
+  struct Prism
+  {
+    std::uint32_t firstRing;
+    std::uint32_t ringCount;
+    double bottom;
+    double top;
+  };
+
+  /**
+   * Ring i owns vertices[ringStarts[i], ringStarts[i + 1]), the last vertex of a ring connects back to the first.
+   */
+  void build(
+    std::span<const glm::dvec2> vertices, std::span<const std::uint32_t> ringStarts, std::span<const Prism> prisms);
+  void clear();
+  bool empty() const { return bottom.empty(); }
+  std::size_t size() const { return bottom.size(); }
+
+  /**
+   * Same as CylinderGrid::query().
+   */
+  void query(
+    std::span<const glm::dvec3> positions,
+    std::span<const glm::dvec3> velocities,
+    double horizon,
+    std::span<Hit> outHits) const;
+
+private:
+  Hit queryPoint(
+    const glm::dvec3& position, const glm::dvec3& velocity, double horizon, std::vector<double>& crossings) const;
+  bool contains(std::uint32_t index, glm::dvec2 point) const;
+  double getEntryTime(
+    std::uint32_t index,
+    const glm::dvec3& position,
+    const glm::dvec3& velocity,
+    double horizon,
+    std::vector<double>& crossings) const;
+
+  CylinderGrid boundsGrid;
+
+  // prisms, structure of arrays
+  std::vector<double> bottom;
+  std::vector<double> top;
+  std::vector<std::uint32_t> edgeStart;
+
+  // edges of all prisms, structure of arrays
+  std::vector<double> edgeStartX;
+  std::vector<double> edgeStartY;
+  std::vector<double> edgeDeltaX;
+  std::vector<double> edgeDeltaY;
+};
+
+} // namespace flb
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+
+namespace flb
+{
+
+// A fixed-capacity ring buffer that overwrites its oldest element when full. Not thread-safe.
+// Elements are addressed from oldest (index 0) to newest (index size() - 1).
+// Note: This relies on types being DefaultConstructible due to the underlying std::array usage.
+template <typename T, std::size_t Capacity>
+class RingBuffer
+{
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+public:
+  void push(const T& value)
+  {
+    slots[(start + count) & MASK] = value;
+    if (count == Capacity)
+    {
+      start = (start + 1) & MASK;
+    }
+    else
+    {
+      ++count;
+    }
+  }
+
+  void clear()
+  {
+    start = 0;
+    count = 0;
+  }
+
+  // Keeps the oldest newCount elements and drops the newer ones.
+  void truncate(std::size_t newCount)
+  {
+    assert(newCount <= count);
+    count = newCount;
+  }
+
+  const T& operator[](std::size_t index) const
+  {
+    assert(index < count);
+    return slots[(start + index) & MASK];
+  }
+
+  T& operator[](std::size_t index)
+  {
+    assert(index < count);
+    return slots[(start + index) & MASK];
+  }
+
+  const T& front() const { return (*this)[0]; }
+  const T& back() const { return (*this)[count - 1]; }
+
+  std::size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  bool full() const { return count == Capacity; }
+
+  static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+  static constexpr std::size_t MASK = Capacity - 1;
+
+  std::array<T, Capacity> slots{};
+  std::size_t start = 0;
+  std::size_t count = 0;
+};
+
+} // namespace flb
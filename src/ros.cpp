@@ -5,18 +5,30 @@
 
 namespace flb
 {
-void ROS::init()
+void ROS::init(std::span<const std::string> vehicleNamespaces)
 {
   rclcpp::init(0, nullptr);
-  node = std::make_shared<SensorCombinedListener>();
-}
-
-void ROS::update() { rclcpp::spin_some(node); }
+  node = std::make_shared<SensorCombinedListener>(channel, vehicleNamespaces);
 
-void ROS::cleanup() { rclcpp::shutdown(); }
+  executor = std::make_unique<rclcpp::executors::SingleThreadedExecutor>();
+  executor->add_node(node);
+  spinThread = std::thread([this]() { executor->spin(); });
+}
 
-glm::dvec3 ROS::getVehicleCoords() const
+void ROS::cleanup()
 {
-  return {node->getVehicleLat(), node->getVehicleLon(), node->getVehicleAlt()};
+  if (!node)
+  {
+    return;
+  }
+
+  // shutting down the context wakes the executor and makes spin() return, even if it hasn't started spinning yet
+  rclcpp::shutdown();
+  if (spinThread.joinable())
+  {
+    spinThread.join();
+  }
+  executor.reset();
+  node.reset();
 }
 } // namespace flb
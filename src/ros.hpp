@@ -1,21 +1,34 @@
 #pragma once
 
 #include "sensor_combined_listener.hpp"
+#include "telemetry.hpp"
 
 #include <rclcpp/rclcpp.hpp>
 
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+
 namespace flb
 {
+/**
+ * Spins the ROS nodes on a dedicated executor thread. Incoming samples are handed to the frame thread through a
+ * lock-free channel that is drained by the frame thread without ever blocking on ROS.
+ */
 class ROS
 {
 public:
-  void init();
+  void init(std::span<const std::string> vehicleNamespaces);
   void cleanup();
-  void update();
 
-  glm::dvec3 getVehicleCoords() const;
+  TelemetryChannel& getChannel() { return channel; }
 
 private:
+  TelemetryChannel channel;
+
   std::shared_ptr<SensorCombinedListener> node = nullptr;
+  std::unique_ptr<rclcpp::executors::SingleThreadedExecutor> executor = nullptr;
+  std::thread spinThread;
 };
 } // namespace flb
@@ -1,38 +1,74 @@
 #pragma once
+#include "telemetry.hpp"
+#include "time.hpp"
+
 #include <px4_msgs/msg/vehicle_global_position.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <rclcpp/strategies/message_pool_memory_strategy.hpp>
 
 #include <glm/glm.hpp>
 
+#include <span>
+#include <string>
+#include <vector>
+
 /**
  * @brief Sensor Combined uORB topic data callback
+ *
+ * Subscribes to the global position topic of every vehicle namespace, e.g. "px4_1" maps to
+ * "/px4_1/fmu/out/vehicle_global_position" and "/" maps to the un-namespaced topic. The vehicle ID of a sample is the
+ * index of its namespace.
+ *
+ * The callbacks run on the ROS executor thread and only publish into the telemetry channel, they never touch state
+ * that is read by the frame thread. Messages are taken from a fixed pool per subscription so steady-state reception
+ * doesn't allocate.
  */
 class SensorCombinedListener: public rclcpp::Node
 {
 public:
-  explicit SensorCombinedListener() : Node("sensor_combined_listener")
+  using GlobalPosition = px4_msgs::msg::VehicleGlobalPosition;
+
+  SensorCombinedListener(flb::TelemetryChannel& channel, std::span<const std::string> vehicleNamespaces)
+      : Node("sensor_combined_listener")
   {
     rmw_qos_profile_t qos_profile = rmw_qos_profile_sensor_data;
     auto qos = rclcpp::QoS(rclcpp::QoSInitialization(qos_profile.history, 5), qos_profile);
 
-    subGlobalPos = this->create_subscription<px4_msgs::msg::VehicleGlobalPosition>(
-      "fmu/out/vehicle_global_position",
-      qos,
-      [this](const px4_msgs::msg::VehicleGlobalPosition::UniquePtr msg)
-      {
-        vehicleLat = msg->lat;
-        vehicleLon = msg->lon;
-        vehicleAlt = msg->alt;
-      });
+    subGlobalPos.reserve(vehicleNamespaces.size());
+    for (flb::VehicleID vehicleId = 0; vehicleId < vehicleNamespaces.size(); ++vehicleId)
+    {
+      subGlobalPos.push_back(this->create_subscription<GlobalPosition>(
+        getTopicName(vehicleNamespaces[vehicleId]),
+        qos,
+        [&channel, vehicleId](const GlobalPosition& msg)
+        {
+          channel.publish({
+            .vehicleId = vehicleId,
+            .sourceTimestampUs = msg.timestamp,
+            .receivedAt = flb::now(),
+            .latitude = msg.lat,
+            .longitude = msg.lon,
+            .altitude = msg.alt,
+          });
+        },
+        rclcpp::SubscriptionOptions(),
+        std::make_shared<MessagePool>()));
+    }
   }
 
-  double getVehicleLat() const { return vehicleLat; }
-  double getVehicleLon() const { return vehicleLon; }
-  double getVehicleAlt() const { return vehicleAlt; }
-
 private:
-  double vehicleLat;
-  double vehicleLon;
-  double vehicleAlt;
-  rclcpp::Subscription<px4_msgs::msg::VehicleGlobalPosition>::SharedPtr subGlobalPos;
+  static constexpr std::size_t MESSAGE_POOL_SIZE = 8;
+  using MessagePool =
+    rclcpp::strategies::message_pool_memory_strategy::MessagePoolMemoryStrategy<GlobalPosition, MESSAGE_POOL_SIZE>;
+
+  std::vector<rclcpp::Subscription<GlobalPosition>::SharedPtr> subGlobalPos;
+
+  static std::string getTopicName(const std::string& vehicleNamespace)
+  {
+    if (vehicleNamespace.empty() || vehicleNamespace == "/")
+    {
+      return "/fmu/out/vehicle_global_position";
+    }
+    return "/" + vehicleNamespace + "/fmu/out/vehicle_global_position";
+  }
 };
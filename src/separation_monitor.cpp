@@ -0,0 +1,239 @@
+#include "separation_monitor.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <bit>
+
+namespace flb
+{
+namespace
+{
+using Alert = component::SeparationStatus::Alert;
+
+std::uint32_t getBucket(std::int32_t x, std::int32_t y, std::uint32_t bucketMask)
+{
+  const std::uint64_t cellX = static_cast<std::uint32_t>(x);
+  const std::uint64_t cellY = static_cast<std::uint32_t>(y);
+  std::uint64_t value = (cellX << 32) | cellY;
+  value ^= value >> 30;
+  value *= 0xbf58476d1ce4e5b9ULL;
+  value ^= value >> 27;
+  value *= 0x94d049bb133111ebULL;
+  value ^= value >> 31;
+  return static_cast<std::uint32_t>(value) & bucketMask;
+}
+} // namespace
+
+void SeparationMonitor::clear(entt::registry& registry)
+{
+  registry.clear<component::SeparationStatus>();
+}
+
+void SeparationMonitor::update(entt::registry& registry)
+{
+  entities.clear();
+  ids.clear();
+  positions.clear();
+  velocities.clear();
+
+  const auto view = registry.view<component::Vehicle, component::Position>();
+  for (const auto [entity, vehicle, position] : view.each())
+  {
+    const auto* velocity = registry.try_get<component::Velocity>(entity);
+    entities.push_back(entity);
+    ids.push_back(vehicle.id);
+    positions.push_back(position.value);
+    velocities.push_back(velocity ? velocity->value : glm::dvec3{0.0});
+  }
+
+  if (entities.empty())
+  {
+    return;
+  }
+
+  // distances are the same in any frame, the frame only has to be level enough near the vehicles for the cells
+  const ENUFrame& frame = frameCache.get(positions.front());
+  for (std::size_t i = 0; i < entities.size(); ++i)
+  {
+    positions[i] = frame.toENU(positions[i]);
+    velocities[i] = frame.directionToENU(velocities[i]);
+  }
+
+  conflicts.assign(entities.size(), Conflict{});
+  buildCells();
+  findConflicts();
+
+  for (std::size_t i = 0; i < entities.size(); ++i)
+  {
+    const Conflict& conflict = conflicts[i];
+    auto& status = registry.get_or_emplace<component::SeparationStatus>(entities[i]);
+    const VehicleID other = conflict.other != NONE ? ids[conflict.other] : component::SeparationStatus::NO_VEHICLE;
+    if (conflict.alert > status.alert)
+    {
+      if (conflict.alert == Alert::Violation)
+      {
+        SDL_Log("Vehicle %u lost separation with vehicle %u", ids[i], other);
+      }
+      else if (conflict.alert == Alert::Warning)
+      {
+        SDL_Log(
+          "Vehicle %u comes within %.1f m of vehicle %u in %.1f s",
+          ids[i],
+          conflict.closestDistance,
+          other,
+          conflict.timeToClosestApproach);
+      }
+    }
+
+    status.other = other;
+    status.timeToClosestApproach = conflict.timeToClosestApproach;
+    status.closestDistance = conflict.closestDistance;
+    status.alert = conflict.alert;
+  }
+}
+
+void SeparationMonitor::buildCells()
+{
+  const std::size_t count = positions.size();
+  const auto getBox = [this](std::size_t i, glm::dvec2& outMin, glm::dvec2& outMax)
+  {
+    const glm::dvec2 start{positions[i]};
+    const glm::dvec2 end = start + glm::dvec2{velocities[i]} * LOOKAHEAD;
+    outMin = glm::min(start, end) - 0.5 * SEPARATION;
+    outMax = glm::max(start, end) + 0.5 * SEPARATION;
+  };
+
+  // cells about the size of an average box keep both the cells per box and the boxes per cell few
+  double extentSum = 0.0;
+  double maxExtent = 0.0;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    glm::dvec2 min{};
+    glm::dvec2 max{};
+    getBox(i, min, max);
+    const double extent = glm::max(max.x - min.x, max.y - min.y);
+    extentSum += extent;
+    maxExtent = glm::max(maxExtent, extent);
+  }
+  double cellSize = glm::max(extentSum / static_cast<double>(count), SEPARATION);
+  cellSize = glm::max(cellSize, maxExtent / MAX_CELLS_PER_AXIS);
+  const double inverseCellSize = 1.0 / cellSize;
+
+  ranges.resize(count);
+  std::size_t entryCount = 0;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    glm::dvec2 min{};
+    glm::dvec2 max{};
+    getBox(i, min, max);
+    const glm::dvec2 cellMin = glm::floor(min * inverseCellSize);
+    const glm::dvec2 cellMax = glm::floor(max * inverseCellSize);
+    ranges[i] = {
+      .minX = static_cast<std::int32_t>(cellMin.x),
+      .minY = static_cast<std::int32_t>(cellMin.y),
+      .maxX = static_cast<std::int32_t>(cellMax.x),
+      .maxY = static_cast<std::int32_t>(cellMax.y),
+    };
+    entryCount += static_cast<std::size_t>(ranges[i].maxX - ranges[i].minX + 1) * (ranges[i].maxY - ranges[i].minY + 1);
+  }
+
+  // counting sort of the cells into twice as many buckets, filled from the back so bucketStart ends up at the starts
+  const std::uint32_t bucketCount = std::bit_ceil(static_cast<std::uint32_t>(2 * entryCount));
+  const std::uint32_t bucketMask = bucketCount - 1;
+  bucketStart.assign(bucketCount + 1, 0);
+  for (const CellRange& range : ranges)
+  {
+    for (std::int32_t y = range.minY; y <= range.maxY; ++y)
+    {
+      for (std::int32_t x = range.minX; x <= range.maxX; ++x)
+      {
+        ++bucketStart[getBucket(x, y, bucketMask)];
+      }
+    }
+  }
+
+  for (std::uint32_t bucket = 1; bucket <= bucketCount; ++bucket)
+  {
+    bucketStart[bucket] += bucketStart[bucket - 1];
+  }
+
+  entries.resize(entryCount);
+  for (std::uint32_t i = 0; i < count; ++i)
+  {
+    const CellRange& range = ranges[i];
+    for (std::int32_t y = range.minY; y <= range.maxY; ++y)
+    {
+      for (std::int32_t x = range.minX; x <= range.maxX; ++x)
+      {
+        entries[--bucketStart[getBucket(x, y, bucketMask)]] = {x, y, i};
+      }
+    }
+  }
+}
+
+void SeparationMonitor::findConflicts()
+{
+  for (std::size_t bucket = 0; bucket + 1 < bucketStart.size(); ++bucket)
+  {
+    for (std::uint32_t first = bucketStart[bucket]; first < bucketStart[bucket + 1]; ++first)
+    {
+      const CellEntry& a = entries[first];
+      for (std::uint32_t second = first + 1; second < bucketStart[bucket + 1]; ++second)
+      {
+        // buckets can hold several cells, and a pair sharing several cells is only tested in the first of them
+        const CellEntry& b = entries[second];
+        if (a.x != b.x || a.y != b.y)
+        {
+          continue;
+        }
+
+        const CellRange& rangeA = ranges[a.vehicle];
+        const CellRange& rangeB = ranges[b.vehicle];
+        if (a.x == std::max(rangeA.minX, rangeB.minX) && a.y == std::max(rangeA.minY, rangeB.minY))
+        {
+          testPair(a.vehicle, b.vehicle);
+        }
+      }
+    }
+  }
+}
+
+void SeparationMonitor::testPair(std::uint32_t a, std::uint32_t b)
+{
+  const glm::dvec3 offset = positions[b] - positions[a];
+  const glm::dvec3 relativeVelocity = velocities[b] - velocities[a];
+
+  const double speedSquared = glm::dot(relativeVelocity, relativeVelocity);
+  const double time =
+    speedSquared > 1e-12 ? glm::clamp(-glm::dot(offset, relativeVelocity) / speedSquared, 0.0, LOOKAHEAD) : 0.0;
+  const double closestDistance = glm::length(offset + relativeVelocity * time);
+  const Alert alert = glm::dot(offset, offset) < SEPARATION * SEPARATION ? Alert::Violation
+                      : closestDistance < SEPARATION                   ? Alert::Warning
+                                                                       : Alert::None;
+  if (alert == Alert::None)
+  {
+    return;
+  }
+
+  // violations first, then the sooner and the closer approach
+  const auto record = [&](Conflict& conflict, std::uint32_t other)
+  {
+    const bool moreUrgent = alert != conflict.alert                 ? alert > conflict.alert
+                            : time != conflict.timeToClosestApproach ? time < conflict.timeToClosestApproach
+                                                                     : closestDistance < conflict.closestDistance;
+    if (moreUrgent)
+    {
+      conflict = {
+        .other = other,
+        .timeToClosestApproach = time,
+        .closestDistance = closestDistance,
+        .alert = alert,
+      };
+    }
+  };
+  record(conflicts[a], b);
+  record(conflicts[b], a);
+}
+
+} // namespace flb
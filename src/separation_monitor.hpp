@@ -0,0 +1,85 @@
+#pragma once
+
+#include "components.hpp"
+#include "math.hpp"
+
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace flb
+{
+
+/**
+ * Checks every pair of vehicles for loss of separation on their current velocities.
+ *
+ * Vehicles are moved into an ENU frame near them, where each one sweeps a box along its velocity over LOOKAHEAD
+ * seconds, grown by half of SEPARATION on every side. Two vehicles can only come closer than SEPARATION if their boxes
+ * overlap, so the boxes are hashed into square cells and only vehicles sharing a cell are tested, which keeps the work
+ * linear in the number of vehicles while they are spread out. A pair sharing several cells is only tested in the first
+ * of them. For every candidate pair the closest point of approach within the lookahead follows from the relative
+ * position and velocity.
+ *
+ * update() gives every vehicle a component::SeparationStatus with its most urgent conflict, a violation if another
+ * vehicle is closer than SEPARATION and a warning if one will be within LOOKAHEAD seconds.
+ */
+class SeparationMonitor
+{
+public:
+  static constexpr double SEPARATION = 50.0;
+  static constexpr double LOOKAHEAD = 30.0;
+  // cells a box may span along each axis, larger boxes make all cells larger
+  static constexpr std::uint32_t MAX_CELLS_PER_AXIS = 8;
+
+  void clear(entt::registry& registry);
+
+  void update(entt::registry& registry);
+
+private:
+  static constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+
+  struct CellRange
+  {
+    std::int32_t minX;
+    std::int32_t minY;
+    std::int32_t maxX;
+    std::int32_t maxY;
+  };
+
+  struct CellEntry
+  {
+    std::int32_t x;
+    std::int32_t y;
+    std::uint32_t vehicle;
+  };
+
+  struct Conflict
+  {
+    std::uint32_t other = NONE;
+    double timeToClosestApproach = std::numeric_limits<double>::infinity();
+    double closestDistance = std::numeric_limits<double>::infinity();
+    component::SeparationStatus::Alert alert = component::SeparationStatus::Alert::None;
+  };
+
+  void buildCells();
+  void findConflicts();
+  void testPair(std::uint32_t a, std::uint32_t b);
+
+  ENUFrameCache frameCache;
+
+  // per-update scratch buffers, indexed by vehicle
+  std::vector<entt::entity> entities;
+  std::vector<VehicleID> ids;
+  std::vector<glm::dvec3> positions;
+  std::vector<glm::dvec3> velocities;
+  std::vector<CellRange> ranges;
+  std::vector<Conflict> conflicts;
+  // cells of all boxes, sorted by their hash bucket
+  std::vector<CellEntry> entries;
+  std::vector<std::uint32_t> bucketStart;
+};
+
+} // namespace flb
@@ -0,0 +1,143 @@
+#include "shared_telemetry.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+
+namespace flb
+{
+
+std::uint64_t sharedtelemetry::getMonotonicNs()
+{
+  timespec time{};
+  ::clock_gettime(CLOCK_MONOTONIC, &time);
+  return static_cast<std::uint64_t>(time.tv_sec) * 1'000'000'000 + static_cast<std::uint64_t>(time.tv_nsec);
+}
+
+std::string sharedtelemetry::getObjectName(std::string_view name)
+{
+  return name.starts_with('/') ? std::string{name} : "/" + std::string{name};
+}
+
+void SharedTelemetryReader::open(std::string_view name)
+{
+  close();
+  this->name = sharedtelemetry::getObjectName(name);
+  nextAttempt = 0;
+  tryMap();
+}
+
+void SharedTelemetryReader::close()
+{
+  if (header != nullptr)
+  {
+    ::munmap(const_cast<sharedtelemetry::Header*>(header), mappedSize);
+  }
+  header = nullptr;
+  slots = nullptr;
+  mappedSize = 0;
+  capacity = 0;
+  name.clear();
+  loggedFailure = false;
+}
+
+bool SharedTelemetryReader::tryMap()
+{
+  const TimePoint currentTime = now();
+  if (name.empty() || currentTime < nextAttempt)
+  {
+    return false;
+  }
+  nextAttempt = currentTime + fromSeconds(RETRY_INTERVAL);
+
+  const int descriptor = ::shm_open(name.c_str(), O_RDONLY, 0);
+  if (descriptor < 0)
+  {
+    if (!loggedFailure)
+    {
+      SDL_Log("Waiting for shared telemetry %s: %s", name.c_str(), std::strerror(errno));
+      loggedFailure = true;
+    }
+    return false;
+  }
+
+  // an object smaller than the header is still being set up by its writer
+  struct stat status{};
+  void* memory = MAP_FAILED;
+  if (::fstat(descriptor, &status) == 0 && static_cast<std::size_t>(status.st_size) >= sizeof(sharedtelemetry::Header))
+  {
+    memory = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+  }
+  ::close(descriptor);
+  if (memory == MAP_FAILED)
+  {
+    return false;
+  }
+
+  const auto* mappedHeader = static_cast<const sharedtelemetry::Header*>(memory);
+  const std::size_t size = static_cast<std::size_t>(status.st_size);
+  const std::uint32_t mappedCapacity = mappedHeader->capacity;
+  const bool valid = std::memcmp(mappedHeader->magic, sharedtelemetry::MAGIC, sizeof(sharedtelemetry::MAGIC)) == 0 &&
+                     mappedHeader->version == sharedtelemetry::VERSION &&
+                     mappedHeader->headerSize == sizeof(sharedtelemetry::Header) &&
+                     mappedHeader->slotSize == sizeof(sharedtelemetry::Slot) && std::has_single_bit(mappedCapacity) &&
+                     sharedtelemetry::getSize(mappedCapacity) <= size;
+  if (!valid)
+  {
+    if (!loggedFailure)
+    {
+      SDL_Log("Shared telemetry %s isn't a version %u ring", name.c_str(), sharedtelemetry::VERSION);
+      loggedFailure = true;
+    }
+    ::munmap(memory, size);
+    return false;
+  }
+
+  header = mappedHeader;
+  slots = reinterpret_cast<const sharedtelemetry::Slot*>(static_cast<const std::byte*>(memory) + sizeof(*header));
+  mappedSize = size;
+  capacity = mappedCapacity;
+  readGeneration = NO_GENERATION;
+  loggedFailure = false;
+  SDL_Log("Reading shared telemetry %s with %u slots", name.c_str(), capacity);
+  return true;
+}
+
+bool SharedTelemetryReader::readSample(
+  std::uint64_t index, std::uint64_t monotonicNow, TimePoint localNow, TelemetrySample& outSample) const
+{
+  const sharedtelemetry::Slot& slot = slots[index & (capacity - 1)];
+  const std::uint64_t sequence = 2 * index + 2;
+  if (slot.sequence.load(std::memory_order_acquire) != sequence)
+  {
+    return false;
+  }
+
+  const std::uint64_t writeTimeNs = slot.writeTimeNs.load(std::memory_order_relaxed);
+  outSample.vehicleId = static_cast<VehicleID>(slot.vehicleId.load(std::memory_order_relaxed));
+  outSample.sourceTimestampUs = slot.sourceTimestampUs.load(std::memory_order_relaxed);
+  outSample.latitude = std::bit_cast<double>(slot.latitude.load(std::memory_order_relaxed));
+  outSample.longitude = std::bit_cast<double>(slot.longitude.load(std::memory_order_relaxed));
+  outSample.altitude = std::bit_cast<double>(slot.altitude.load(std::memory_order_relaxed));
+
+  // the writer started on the slot again while it was being copied
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+  {
+    return false;
+  }
+
+  // the sample arrived when it was written, not when the frame got around to reading it
+  const double age = monotonicNow > writeTimeNs ? static_cast<double>(monotonicNow - writeTimeNs) * 1e-9 : 0.0;
+  outSample.receivedAt = localNow - std::min(fromSeconds(age), localNow);
+  return true;
+}
+
+} // namespace flb
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "telemetry.hpp"
+#include "time.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+namespace flb
+{
+
+/**
+ * Shared memory telemetry ring, for simulators running on the same host.
+ *
+ * The POSIX shared memory object is a Header followed by capacity Slots, capacity being a power of two. All fields
+ * are little endian and naturally aligned, the header and every slot take whole cache lines. Sample i goes into slot
+ * i % capacity, and writeCount is the number of samples written so far.
+ *
+ * Every writer that takes the ring over, including one restarting on the same object, starts a new generation: it
+ * makes generation odd, sets writeCount to zero, then makes generation even again with release order. A reader loads
+ * generation with acquire order, then writeCount, and after an acquire fence generation again. It only uses
+ * writeCount if both loads returned the same even value, and starts over from sample 0 when the value differs from
+ * the generation it was reading.
+ *
+ * A single writer publishes sample i by storing 2i + 1 into the sequence of its slot, then the fields, then 2i + 2
+ * into the sequence with release order, and finally i + 1 into writeCount with release order. The writer never waits
+ * for readers, it overwrites the oldest samples instead. A reader holding sample i valid checks, with acquire order,
+ * that the sequence is 2i + 2 before and after copying the fields, any other value means the sample was overwritten.
+ * Every field is a 64-bit atomic accessed with relaxed order, doubles by their bits, so readers never race.
+ *
+ * writeTimeNs is CLOCK_MONOTONIC at the time of writing, which the reader maps onto its own clock for the
+ * receivedAt of the sample. vehicleId is the index of the vehicle in the vehicles file, as with the other links.
+ */
+namespace sharedtelemetry
+{
+constexpr char MAGIC[8] = {'F', 'L', 'B', 'T', 'E', 'L', 'E', 'M'};
+constexpr std::uint32_t VERSION = 2;
+// several seconds of 1000 vehicles at 50 Hz
+constexpr std::uint32_t DEFAULT_CAPACITY = 1 << 18;
+
+struct alignas(64) Header
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t headerSize;
+  std::uint32_t slotSize;
+  std::uint32_t capacity;
+  std::atomic<std::uint64_t> generation;
+  alignas(64) std::atomic<std::uint64_t> writeCount;
+};
+
+struct alignas(64) Slot
+{
+  std::atomic<std::uint64_t> sequence;
+  std::atomic<std::uint64_t> writeTimeNs;
+  std::atomic<std::uint64_t> vehicleId;
+  std::atomic<std::uint64_t> sourceTimestampUs;
+  std::atomic<std::uint64_t> latitude;
+  std::atomic<std::uint64_t> longitude;
+  std::atomic<std::uint64_t> altitude;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "the ring is shared between processes");
+static_assert(sizeof(Header) == 128);
+static_assert(sizeof(Slot) == 64);
+
+/**
+ * Size of the shared memory object of a ring with capacity slots.
+ */
+constexpr std::size_t getSize(std::uint32_t capacity)
+{
+  return sizeof(Header) + std::size_t{capacity} * sizeof(Slot);
+}
+
+std::uint64_t getMonotonicNs();
+
+/**
+ * Name of the shared memory object of the ring named name, which is name with "/" prepended if it doesn't start with
+ * one.
+ */
+std::string getObjectName(std::string_view name);
+} // namespace sharedtelemetry
+
+/**
+ * Reads the ring on the frame thread. drain() is wait-free: it copies at most capacity samples, each checked once,
+ * and never waits for the writer. Samples the writer overwrote before they were read are counted and reported as
+ * dropped.
+ *
+ * The ring doesn't have to exist when the reader is opened, drain() tries to map it every RETRY_INTERVAL seconds
+ * until it does. Reading starts at the newest sample. When a writer takes the ring over, which drain() sees by the
+ * generation changing, reading starts over at its first sample.
+ */
+class SharedTelemetryReader
+{
+public:
+  static constexpr double RETRY_INTERVAL = 1.0;
+
+  ~SharedTelemetryReader() { close(); }
+
+  /**
+   * Reads the ring named name, "/" is prepended if it doesn't start with one.
+   */
+  void open(std::string_view name);
+  void close();
+
+  // Called only from the frame thread. Passes every sample written since the last call to the callback in order.
+  template <typename Func>
+  std::size_t drain(Func callback)
+  {
+    if (header == nullptr && !tryMap())
+    {
+      return 0;
+    }
+
+    // a write count of a single generation, the writer is resetting the ring otherwise
+    const std::uint64_t generation = header->generation.load(std::memory_order_acquire);
+    const std::uint64_t writeCount = header->writeCount.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (generation % 2 != 0 || header->generation.load(std::memory_order_relaxed) != generation)
+    {
+      return 0;
+    }
+
+    if (generation != readGeneration)
+    {
+      // right after mapping the ring, skip what was written before
+      if (readGeneration == NO_GENERATION)
+      {
+        readCount = writeCount;
+      }
+      else
+      {
+        SDL_Log("Shared telemetry %s restarted", name.c_str());
+        readCount = 0;
+      }
+      readGeneration = generation;
+    }
+    if (writeCount - readCount > capacity)
+    {
+      droppedSamples += writeCount - readCount - capacity;
+      readCount = writeCount - capacity;
+    }
+
+    const std::uint64_t monotonicNow = sharedtelemetry::getMonotonicNs();
+    const TimePoint localNow = now();
+    std::size_t count = 0;
+    TelemetrySample sample;
+    for (; readCount < writeCount; ++readCount)
+    {
+      if (!readSample(readCount, monotonicNow, localNow, sample))
+      {
+        ++droppedSamples;
+        continue;
+      }
+      callback(sample);
+      ++count;
+    }
+
+    if (droppedSamples != reportedDroppedSamples)
+    {
+      SDL_Log(
+        "Shared telemetry overran, %llu samples dropped",
+        static_cast<unsigned long long>(droppedSamples - reportedDroppedSamples));
+      reportedDroppedSamples = droppedSamples;
+    }
+
+    return count;
+  }
+
+private:
+  static constexpr std::uint64_t NO_GENERATION = std::numeric_limits<std::uint64_t>::max();
+
+  bool tryMap();
+  bool readSample(std::uint64_t index, std::uint64_t monotonicNow, TimePoint localNow, TelemetrySample& outSample)
+    const;
+
+  std::string name;
+  TimePoint nextAttempt = 0;
+  bool loggedFailure = false;
+
+  const sharedtelemetry::Header* header = nullptr;
+  const sharedtelemetry::Slot* slots = nullptr;
+  std::size_t mappedSize = 0;
+  std::uint32_t capacity = 0;
+
+  // generation readCount counts samples of
+  std::uint64_t readGeneration = NO_GENERATION;
+  std::uint64_t readCount = 0;
+  std::uint64_t droppedSamples = 0;
+  std::uint64_t reportedDroppedSamples = 0;
+};
+
+} // namespace flb
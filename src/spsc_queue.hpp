@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <utility>
+
+namespace flb
+{
+
+// A fixed-capacity lock-free ring buffer for exactly one producer thread and one consumer thread.
+// Both push and pop are wait-free: they never block and never retry, so the consumer can drain it from the frame
+// thread without ever stalling on the producer.
+// Note: This relies on types being DefaultConstructible and trivially copyable is preferred, since slots are reused.
+template <typename T, std::size_t Capacity>
+class SPSCQueue
+{
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+public:
+  SPSCQueue() = default;
+  SPSCQueue(const SPSCQueue&) = delete;
+  SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+  // Producer side. Returns false if the queue is full, the value is not written in that case.
+  bool push(const T& value)
+  {
+    const std::size_t tail = tailIndex.load(std::memory_order_relaxed);
+    if (tail - cachedHead == Capacity)
+    {
+      cachedHead = headIndex.load(std::memory_order_acquire);
+      if (tail - cachedHead == Capacity)
+      {
+        return false;
+      }
+    }
+
+    slots[tail & MASK] = value;
+    tailIndex.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns std::nullopt if the queue is empty.
+  std::optional<T> pop()
+  {
+    const std::size_t head = headIndex.load(std::memory_order_relaxed);
+    if (head == cachedTail)
+    {
+      cachedTail = tailIndex.load(std::memory_order_acquire);
+      if (head == cachedTail)
+      {
+        return std::nullopt;
+      }
+    }
+
+    T value = slots[head & MASK];
+    headIndex.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+  // Consumer side. Pops every element that was visible at the time of the call and passes it to the callback.
+  // Returns the number of consumed elements.
+  template <typename Func>
+  std::size_t drain(Func callback)
+  {
+    const std::size_t head = headIndex.load(std::memory_order_relaxed);
+    const std::size_t tail = tailIndex.load(std::memory_order_acquire);
+    cachedTail = tail;
+
+    for (std::size_t i = head; i != tail; ++i)
+    {
+      callback(std::as_const(slots[i & MASK]));
+    }
+
+    headIndex.store(tail, std::memory_order_release);
+    return tail - head;
+  }
+
+  // Approximate when called concurrently with push or pop.
+  std::size_t size() const
+  {
+    return tailIndex.load(std::memory_order_acquire) - headIndex.load(std::memory_order_acquire);
+  }
+
+  static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+  static constexpr std::size_t MASK = Capacity - 1;
+  static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+  // Producer and consumer indices live on separate cache lines so the two threads don't false share. Each side also
+  // keeps a cached copy of the other side's index so the shared line is only touched when the queue looks full/empty.
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tailIndex{0};
+  std::size_t cachedHead = 0;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> headIndex{0};
+  std::size_t cachedTail = 0;
+
+  alignas(CACHE_LINE_SIZE) std::array<T, Capacity> slots{};
+};
+
+} // namespace flb
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "spsc_queue.hpp"
+#include "time.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace flb
+{
+
+using VehicleID = std::uint32_t;
+
+/**
+ * A single vehicle position report as it arrives from the telemetry link.
+ *
+ * sourceTimestampUs is the vehicle's own clock (PX4 boot time in microseconds), receivedAt is the local
+ * performance counter value at the moment the sample was handed to flightboard.
+ */
+struct TelemetrySample
+{
+  VehicleID vehicleId = 0;
+  std::uint64_t sourceTimestampUs = 0;
+  TimePoint receivedAt = 0;
+  double latitude = 0.0;
+  double longitude = 0.0;
+  double altitude = 0.0;
+};
+
+/**
+ * Carries samples from the telemetry thread to the frame thread. Sized to hold several seconds of 250 Hz telemetry
+ * for a handful of vehicles so that even long frame hitches don't drop samples.
+ */
+struct TelemetryChannel
+{
+  static constexpr std::size_t CAPACITY = 16384;
+
+  SPSCQueue<TelemetrySample, CAPACITY> queue;
+  std::atomic<std::uint64_t> droppedSamples{0};
+
+  // Called only from the telemetry thread.
+  void publish(const TelemetrySample& sample)
+  {
+    if (!queue.push(sample))
+    {
+      droppedSamples.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // Called only from the frame thread. Passes every pending sample to the callback in arrival order.
+  template <typename Func>
+  std::size_t drain(Func callback)
+  {
+    const std::size_t count = queue.drain(callback);
+
+    const std::uint64_t dropped = droppedSamples.load(std::memory_order_relaxed);
+    if (dropped != reportedDroppedSamples)
+    {
+      SDL_Log(
+        "Telemetry channel overflowed, %llu samples dropped",
+        static_cast<unsigned long long>(dropped - reportedDroppedSamples));
+      reportedDroppedSamples = dropped;
+    }
+
+    return count;
+  }
+
+private:
+  std::uint64_t reportedDroppedSamples = 0;
+};
+
+} // namespace flb
@@ -0,0 +1,20 @@
+#pragma once
+
+#ifdef FLIGHTBOARD_WITH_ROS
+#include "ros.hpp"
+#else
+#include "mavlink.hpp"
+#endif
+
+namespace flb
+{
+/**
+ * Source of live telemetry, ROS when it is built in and MAVLink over UDP otherwise. Both spin on their own thread and
+ * are used through init(vehicleNamespaces), cleanup() and getChannel().
+ */
+#ifdef FLIGHTBOARD_WITH_ROS
+using TelemetryLink = ROS;
+#else
+using TelemetryLink = MAVLink;
+#endif
+} // namespace flb
@@ -1,39 +1,23 @@
 #pragma once
 
 #include "culling.hpp"
+#include "geodesy.hpp"
 #include "gpu/pipeline.hpp"
 #include "math.hpp"
+#include "tile_range.hpp"
 
+#include <array>
 #include <filesystem>
-#include <vector>
 
 namespace flb
 {
 
-static std::vector<NodeCoords> getIntersectingTileCoords(const TilesetDescription& description)
+/**
+ * The tiles intersecting the zoom region at each zoom level of the description, generated lazily in Morton order.
+ */
+static TileCoordsRange getIntersectingTileCoords(const TilesetDescription& description)
 {
-  std::vector<NodeCoords> coords;
-  BBOX bounds = description.zoomRegion;
-  for (std::uint32_t zoom = description.zoomMin; zoom <= description.zoomMax; ++zoom)
-  {
-    NodeCoords sw = geoToTileCoords(bounds.min, zoom);
-    NodeCoords ne = geoToTileCoords(bounds.max, zoom);
-
-    auto minx = sw.x;
-    auto miny = ne.y;
-
-    auto maxx = ne.x;
-    auto maxy = sw.y;
-
-    for (std::uint32_t x = minx; x <= maxx; ++x)
-    {
-      for (std::uint32_t y = miny; y <= maxy; ++y)
-      {
-        coords.emplace_back(zoom, x, y);
-      }
-    }
-  }
-  return coords;
+  return TileCoordsRange(description);
 }
 
 static std::filesystem::path getTilePath(const std::filesystem::path& root, const NodeCoords& coords)
@@ -56,11 +40,6 @@ static void generateTileVertices(
   const double coordx = static_cast<double>(childTile.x);
   const double coordy = static_cast<double>(childTile.y);
 
-  const double n = glm::pow(2.0, childTile.level);
-  constexpr double a = SEMI_MAJOR;
-  constexpr double b = SEMI_MINOR;
-  constexpr double e2 = 1.0 - (b * b) / (a * a);
-
   // If no fallback occurred, levelDiff is 0, scale is 1.0, and offsets are 0.0
   const std::uint32_t levelDiff = childTile.level - parentTile.level;
   const double uvScale = 1.0 / static_cast<double>(1 << levelDiff);
@@ -71,27 +50,26 @@ static void generateTileVertices(
   h = (h ^ (h >> 13)) * 1274126177U;
   glm::vec3 tileColor{((h >> 16) & 0xFF) / 255.0f, ((h >> 8) & 0xFF) / 255.0f, (h & 0xFF) / 255.0f};
 
+  // the latitude terms only change along the rows and the longitude terms along the columns
+  std::array<double, GRID_RESOLUTION + 1> tileX;
+  std::array<double, GRID_RESOLUTION + 1> tileY;
   for (gpu::Index i = 0; i <= GRID_RESOLUTION; ++i)
   {
-    const double v = static_cast<double>(i) / GRID_RESOLUTION;
-    const double tile_y = coordy + v;
+    tileX[i] = coordx + static_cast<double>(i) / GRID_RESOLUTION;
+    tileY[i] = coordy + static_cast<double>(i) / GRID_RESOLUTION;
+  }
+  std::array<ECEFCoords, NUM_VERTICES_PER_TILE> positions;
+  tileGridToECEF(childTile.level, tileX, tileY, positions);
 
-    const double lat = glm::atan(glm::sinh(PI * (1.0 - 2.0 * tile_y / n)));
-    const double sin_lat = glm::sin(lat);
-    const double cos_lat = glm::cos(lat);
-    const double N = a / glm::sqrt(1.0 - e2 * sin_lat * sin_lat);
-    const double z = N * (1.0 - e2) * sin_lat;
+  for (gpu::Index i = 0; i <= GRID_RESOLUTION; ++i)
+  {
+    const double v = static_cast<double>(i) / GRID_RESOLUTION;
 
     for (gpu::Index j = 0; j <= GRID_RESOLUTION; ++j)
     {
       const double u = static_cast<double>(j) / GRID_RESOLUTION;
-      const double tile_x = coordx + u;
 
-      const double lon = (tile_x / n) * 2.0 * PI - PI;
-      const double x = N * cos_lat * glm::cos(lon);
-      const double y = N * cos_lat * glm::sin(lon);
-
-      const glm::dvec3 posDouble{x, y, z};
+      const glm::dvec3 posDouble = positions[i * (GRID_RESOLUTION + 1) + j];
       const glm::dvec3 localPosDouble = posDouble - tileCenter;
       const glm::vec3 position = glm::vec3(localPosDouble);
 
@@ -295,6 +273,7 @@ static glm::dvec3 generateHorizonCullingPointLoose(const BoundingSphere& boundin
  * Generates indices for a tile grid based on the specified resolution.
  * The indices define two triangles for each quad in the grid, which will be used for rendering the tile.
  * The provided span should have a size of GRID_RESOLUTION * GRID_RESOLUTION * 6 to accommodate all the indices.
+ * Every tile is drawn with them, see optimizeVertexCache() for reordering them for the vertex cache.
  */
 constexpr std::size_t TILE_NUM_INDICES = GRID_RESOLUTION * GRID_RESOLUTION * 6;
 constexpr std::size_t TILE_INDEX_BUFFER_SIZE = TILE_NUM_INDICES * sizeof(gpu::Index);
@@ -321,17 +300,12 @@ static void generateTileIndices(std::span<gpu::Index>& indices)
   }
 }
 
-static std::vector<glm::dvec3> getTileOrigins(const std::vector<NodeCoords>& tileCoords)
+/**
+ * The center of the tile on the ellipsoid, the origin its vertices are relative to. Computed per tile so that the
+ * origins of a TileCoordsRange are generated along with it.
+ */
+static glm::dvec3 getTileOrigin(const NodeCoords& coords)
 {
-  std::vector<glm::dvec3> origins;
-  origins.reserve(tileCoords.size());
-  for (const auto& coords : tileCoords)
-  {
-    double coordx = static_cast<double>(coords.x);
-    double coordy = static_cast<double>(coords.y);
-    glm::dvec3 tileCenter = tileToECEF(coords.level, coordx + 0.5, coordy + 0.5);
-    origins.push_back(tileCenter);
-  }
-  return origins;
+  return tileToECEF(coords.level, static_cast<double>(coords.x) + 0.5, static_cast<double>(coords.y) + 0.5);
 }
 } // namespace flb
@@ -8,14 +8,15 @@
 #include "quadtree.hpp"
 #include "texture_manager.hpp"
 #include "tile_generator.hpp"
+#include "tileset.hpp"
 #include "time.hpp"
 #include "utils.hpp"
 
 #include <entt/entt.hpp>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/norm.hpp>
+#include <glm/gtc/constants.hpp>
 
 #include <cstdint>
+#include <filesystem>
 
 namespace flb
 {
@@ -23,13 +24,43 @@ class TileManager
 {
 public:
   static constexpr std::size_t CAPACITY = 8192;
-
-  void init(entt::registry* registry, gpu::Allocator* allocator, TextureManager* textureManager)
+  static constexpr std::size_t TEXTURE_CAPACITY = 4096;
+  static constexpr std::uint32_t TILE_IMAGE_SIZE = 256;
+  static constexpr std::uint32_t FALLBACK_MAX_ZOOM = 19;
+  // about the tile density of the former distance based split on a 1080p view with the default field of view
+  static constexpr float DEFAULT_MAX_SCREEN_SPACE_ERROR = 1.3f;
+
+  /**
+   * Largest size, in pixels, a texel of a tile may cover on screen before the tile is split into its children.
+   */
+  float maxScreenSpaceError = DEFAULT_MAX_SCREEN_SPACE_ERROR;
+
+  /**
+   * Tiles are split and loaded only where the descriptions in tilesetPath have images, from the root of each. Without
+   * a valid tileset file every tile down to FALLBACK_MAX_ZOOM is tried, as if the tiles directory next to tilesetPath
+   * had images of the whole world.
+   */
+  void init(
+    entt::registry* registry,
+    gpu::Allocator* allocator,
+    TextureManager* textureManager,
+    const std::filesystem::path& tilesetPath = "content/tileset.txt")
   {
     this->registry = registry;
     this->allocator = allocator;
     this->textureManager = textureManager;
 
+    if (!tileset.load(tilesetPath, TILE_IMAGE_SIZE) || tileset.empty())
+    {
+      tileset.add({
+        .tileImageSize = TILE_IMAGE_SIZE,
+        .zoomMin = 0,
+        .zoomMax = FALLBACK_MAX_ZOOM,
+        .zoomRegion = {{MIN_LATITUDE, MIN_LONGITUDE}, {MAX_LATITUDE, MAX_LONGITUDE}},
+        .root = tilesetPath.parent_path() / "tiles",
+      });
+    }
+
     registry->group<component::Position, component::VertexBuffer, component::Texture>();
   }
 
@@ -43,23 +74,31 @@ public:
           destroyTile(entity);
         }
       });
+    textureCache.clear([this](NodeCoords /*key*/, TileTexture texture) { textureManager->release(texture.handle); });
   }
 
-  void update(const Camera& camera, TimePoint currentTime)
+  /**
+   * Selects the tiles to draw for a view viewportHeight pixels high. A tile is split while its screen space error, the
+   * size of one of its texels projected at its nearest distance, exceeds maxScreenSpaceError, so the number of tiles
+   * follows the resolution of the view and the projection of the camera.
+   */
+  void update(const Camera& camera, float viewportHeight, TimePoint currentTime)
   {
     registry->clear<component::Visible>();
 
     const auto cameraPosition = camera.position;
     const auto frustum = camera.createFrustum();
+    // screen scale is relative to half the viewport height
+    const double pixelScale = 0.5 * static_cast<double>(viewportHeight);
+    const double maxError = static_cast<double>(maxScreenSpaceError);
 
     QuadTree quadtree;
     {
       // Timer quadTreeTimer("QuadTree build");
-      constexpr std::uint32_t MAX_DEPTH = 19;
       quadtree.build(
-        [cameraPosition, frustum](NodeCoords coords)
+        [this, &camera, cameraPosition, frustum, pixelScale, maxError](NodeCoords coords)
         {
-          if (coords.level == MAX_DEPTH)
+          if (!tileset.hasDeeperImages(coords))
             return false;
 
           if (coords.level < 1)
@@ -70,13 +109,11 @@ public:
           if (isOccluded(cameraPosition, frustum, boundingSphere, horizonCullingPoint))
             return false;
 
-          const auto distance2 = glm::distance2(cameraPosition, boundingSphere.position);
-          const double splitThreshold = boundingSphere.radius * 4.0;
-
-          if (distance2 > splitThreshold * splitThreshold)
-            return false;
-
-          return true;
+          // the sphere passes through the corners, so the tile edge is about sqrt(2) times its radius
+          const double texelSize = boundingSphere.radius * glm::root_two<double>() / TILE_IMAGE_SIZE;
+          const double distance =
+            glm::max(glm::distance(cameraPosition, boundingSphere.position) - boundingSphere.radius, 0.0);
+          return texelSize * camera.getScreenScale(distance) * pixelScale > maxError;
         });
     }
     {
@@ -122,26 +159,25 @@ public:
   }
 
 private:
+  /**
+   * The texture of a tile, either its own image or that of its nearest ancestor with one, which source names for the
+   * UV mapping.
+   */
+  struct TileTexture
+  {
+    TextureHandle handle{};
+    NodeCoords source{};
+  };
+
   static constexpr std::size_t PROBE_LIMIT = 16;
 
   entt::registry* registry = nullptr;
   gpu::Allocator* allocator = nullptr;
   TextureManager* textureManager = nullptr;
+  Tileset tileset;
 
   struct NodeCoordsHasher
   {
-    // Generates a 64-bit Morton Code (Quadkey)
-    static constexpr std::uint64_t splitBy1(std::uint32_t a)
-    {
-      std::uint64_t x = a & 0x00000000FFFFFFFF;
-      x = (x | (x << 16)) & 0x0000FFFF0000FFFF;
-      x = (x | (x << 8)) & 0x00FF00FF00FF00FF;
-      x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0F;
-      x = (x | (x << 2)) & 0x3333333333333333;
-      x = (x | (x << 1)) & 0x5555555555555555;
-      return x;
-    }
-
     static constexpr std::uint64_t hash(std::uint64_t value)
     {
       value ^= value >> 30;
@@ -154,7 +190,8 @@ private:
 
     static constexpr std::uint64_t getKey(std::uint32_t zoom, std::uint32_t x, std::uint32_t y)
     {
-      std::uint64_t morton = splitBy1(x) | (splitBy1(y) << 1);
+      // 64-bit Morton code (quadkey)
+      std::uint64_t morton = encodeMorton(x, y);
       return (static_cast<std::uint64_t>(zoom) << 56) | morton;
     }
 
@@ -162,19 +199,35 @@ private:
   };
 
   LRUCache<NodeCoords, entt::entity, CAPACITY, NodeCoordsHasher, PROBE_LIMIT> cache;
-
-  entt::entity createTile(const NodeCoords coords, TimePoint currentTime)
+  // textures of tiles and of the ancestors they fall back to, apart from the tiles so that a missing image doesn't
+  // build vertex buffers and entities for its ancestors. Every entry holds a reference to its texture
+  LRUCache<NodeCoords, TileTexture, TEXTURE_CAPACITY, NodeCoordsHasher, PROBE_LIMIT> textureCache;
+
+  /**
+   * Finds the texture of the tile at coords, loading its image if the tileset has one and borrowing the texture of its
+   * parent otherwise. The handle is invalid if neither the tile nor any of its ancestors has an image. The reference
+   * belongs to the texture cache, callers keeping the handle add their own.
+   */
+  TileTexture getTileTexture(NodeCoords coords, TimePoint currentTime)
   {
-    NodeCoords loadedCoords = coords;
-    TextureHandle finalTextureHandle;
+    auto cachedValue = textureCache.get(coords, currentTime);
+    if (cachedValue.has_value())
+    {
+      return cachedValue.value();
+    }
 
-    // the tile image present on the disk, use it
-    const auto tilePath = getTilePath("content/tiles/eskisehir", coords);
-    auto rawFile = loadFileBinary(tilePath);
+    TileTexture tileTexture{.source = coords};
+
+    // the tile image present on the disk, use it. Tiles outside the tileset don't have one, skip looking for it
+    std::vector<std::byte> rawFile;
+    if (const TilesetDescription* description = tileset.findImage(coords))
+    {
+      rawFile = loadFileBinary(getTilePath(description->root, coords));
+    }
     if (!rawFile.empty())
     {
-      finalTextureHandle = textureManager->allocate(256, 256);
-      auto texture = textureManager->get(finalTextureHandle);
+      tileTexture.handle = textureManager->allocate(TILE_IMAGE_SIZE, TILE_IMAGE_SIZE);
+      auto texture = textureManager->get(tileTexture.handle);
       const std::span<std::byte> memory = allocator->allocateTexture(texture);
       loadJPG(rawFile, memory);
     }
@@ -183,21 +236,35 @@ private:
     else if (coords.level > 0)
     {
       const NodeCoords parentCoords{coords.level - 1, coords.x / 2, coords.y / 2};
-
-      auto parent = getOrCreateTile(parentCoords, currentTime);
-      if (parent != entt::null)
+      tileTexture = getTileTexture(parentCoords, currentTime);
+      if (tileTexture.handle.isValid())
       {
-        finalTextureHandle = registry->get<component::TextureHandle>(parent).value;
-        textureManager->addRef(finalTextureHandle);
-        loadedCoords = registry->get<NodeCoords>(parent);
+        textureManager->addRef(tileTexture.handle);
       }
     }
 
+    // tiles without any texture are cached too, so that their images aren't looked for again
+    auto evicted = textureCache.insert(coords, tileTexture, currentTime);
+    if (evicted.has_value())
+    {
+      textureManager->release(evicted.value().second.handle);
+    }
+
+    return tileTexture;
+  }
+
+  entt::entity createTile(const NodeCoords coords, TimePoint currentTime)
+  {
+    const TileTexture tileTexture = getTileTexture(coords, currentTime);
+
     // no texture found for the tile in disk or from parents
-    if (!finalTextureHandle.isValid())
+    if (!tileTexture.handle.isValid())
     {
       return entt::null;
     }
+    textureManager->addRef(tileTexture.handle);
+    const TextureHandle finalTextureHandle = tileTexture.handle;
+    const NodeCoords loadedCoords = tileTexture.source;
 
     const auto vertexBuffer = allocator->createVertexBuffer(VERTEX_BUFFER_SIZE_PER_TILE);
     std::span<std::byte> vertexBufferMemory = allocator->allocateBuffer(vertexBuffer);
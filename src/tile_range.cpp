@@ -0,0 +1,170 @@
+#include "tile_range.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace flb
+{
+namespace
+{
+constexpr std::uint64_t EvenBits = 0x5555555555555555;
+constexpr std::uint64_t OddBits = 0xAAAAAAAAAAAAAAAA;
+constexpr std::uint64_t NoCodeLimit = std::numeric_limits<std::uint64_t>::max();
+// deepest zoom level whose tile coordinates fit into 32 bits
+constexpr std::uint32_t MaxBlockLevel = 31;
+} // namespace
+
+std::uint64_t TileCoordsRange::TileRect::nextCode(std::uint64_t code) const
+{
+  std::uint64_t low = firstCode();
+  std::uint64_t high = lastCode();
+  std::uint64_t bigMin = high;
+  for (int bit = 63; bit >= 0; --bit)
+  {
+    const std::uint64_t mask = std::uint64_t{1} << bit;
+    // the lower bits of the same coordinate
+    const std::uint64_t below = (bit % 2 == 0 ? EvenBits : OddBits) & (mask - 1);
+    const bool codeBit = (code & mask) != 0;
+    const bool lowBit = (low & mask) != 0;
+    const bool highBit = (high & mask) != 0;
+
+    if (!codeBit && !lowBit && highBit)
+    {
+      // the answer is either in the lower half of the rectangle or the first code of its upper half
+      bigMin = (low | mask) & ~below;
+      high = (high & ~mask) | below;
+    }
+    else if (!codeBit && lowBit && highBit)
+    {
+      return low;
+    }
+    else if (codeBit && !lowBit && !highBit)
+    {
+      return bigMin;
+    }
+    else if (codeBit && !lowBit && highBit)
+    {
+      low = (low | mask) & ~below;
+    }
+  }
+  return bigMin;
+}
+
+std::size_t TileCoordsRange::TileRect::countTiles(
+  std::uint32_t level, std::uint64_t block, std::uint64_t low, std::uint64_t high) const
+{
+  const std::uint64_t begin = block << (2 * level);
+  const std::uint64_t end = (block + 1) << (2 * level);
+  if (end <= low || begin >= high)
+  {
+    return 0;
+  }
+
+  if (begin < low || end > high)
+  {
+    std::size_t count = 0;
+    for (std::uint64_t child = 0; child < 4; ++child)
+    {
+      count += countTiles(level - 1, block * 4 + child, low, high);
+    }
+    return count;
+  }
+
+  const std::uint64_t blockX = decodeMortonX(block);
+  const std::uint64_t blockY = decodeMortonY(block);
+  const std::uint64_t fromX = std::max<std::uint64_t>(blockX << level, minX);
+  const std::uint64_t fromY = std::max<std::uint64_t>(blockY << level, minY);
+  const std::uint64_t toX = std::min<std::uint64_t>(((blockX + 1) << level) - 1, maxX);
+  const std::uint64_t toY = std::min<std::uint64_t>(((blockY + 1) << level) - 1, maxY);
+  if (fromX > toX || fromY > toY)
+  {
+    return 0;
+  }
+  return static_cast<std::size_t>((toX - fromX + 1) * (toY - fromY + 1));
+}
+
+TileCoordsRange::TileCoordsRange(const TilesetDescription& description)
+  : region(description.zoomRegion)
+  , first{description.zoomMin, 0}
+  , last{description.zoomMax + 1, 0}
+{
+  for (std::uint32_t zoom = description.zoomMin; zoom <= description.zoomMax; ++zoom)
+  {
+    const TileRect rect = TileRect::at(region, zoom);
+    if (!rect.empty())
+    {
+      tileCount += static_cast<std::size_t>(rect.maxX - rect.minX + 1) * (rect.maxY - rect.minY + 1);
+    }
+  }
+}
+
+std::vector<TileCoordsRange> TileCoordsRange::split(std::size_t maxTilesPerChunk) const
+{
+  maxTilesPerChunk = std::max<std::size_t>(maxTilesPerChunk, 1);
+
+  // chunks are built from the quadtree nodes blockLevel levels above the tiles, the largest that fit into one
+  std::uint32_t blockLevel = 0;
+  while (blockLevel < MaxBlockLevel && (std::uint64_t{1} << (2 * (blockLevel + 1))) <= maxTilesPerChunk)
+  {
+    ++blockLevel;
+  }
+
+  std::vector<TileCoordsRange> chunks;
+  TileCursor chunkFirst = first;
+  std::size_t chunkTiles = 0;
+  for (std::uint32_t zoom = first.zoom; TileCursor{zoom, 0} < last; ++zoom)
+  {
+    const TileRect rect = TileRect::at(region, zoom);
+    if (rect.empty())
+    {
+      continue;
+    }
+
+    const std::uint64_t low = zoom == first.zoom ? first.code : 0;
+    const std::uint64_t high = zoom == last.zoom ? last.code : NoCodeLimit;
+    const std::uint32_t level = std::min(blockLevel, zoom);
+    const TileRect blocks{
+      .minX = rect.minX >> level,
+      .minY = rect.minY >> level,
+      .maxX = rect.maxX >> level,
+      .maxY = rect.maxY >> level,
+    };
+
+    for (std::uint64_t block = blocks.firstCode(); block <= blocks.lastCode(); ++block)
+    {
+      if (!blocks.contains(decodeMortonX(block), decodeMortonY(block)))
+      {
+        block = blocks.nextCode(block);
+      }
+
+      const std::uint64_t blockBegin = block << (2 * level);
+      if (blockBegin >= high)
+      {
+        break;
+      }
+
+      const std::size_t tiles = rect.countTiles(level, block, low, high);
+      if (tiles == 0)
+      {
+        continue;
+      }
+
+      if (chunkTiles > 0 && chunkTiles + tiles > maxTilesPerChunk)
+      {
+        const TileCursor boundary{zoom, std::max(blockBegin, low)};
+        chunks.push_back({region, chunkFirst, boundary, chunkTiles});
+        chunkFirst = boundary;
+        chunkTiles = 0;
+      }
+      chunkTiles += tiles;
+    }
+  }
+
+  if (chunkTiles > 0)
+  {
+    chunks.push_back({region, chunkFirst, last, chunkTiles});
+  }
+  return chunks;
+}
+
+} // namespace flb
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "math.hpp"
+#include "quadtree.hpp"
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace flb
+{
+
+/**
+ * Interleaves the bits of x and y, x in the even bits, into a Morton code. Ordering the tiles of a zoom level by it
+ * walks them along a Z curve, on which the tiles of every quadtree node are consecutive.
+ */
+constexpr std::uint64_t encodeMorton(std::uint32_t x, std::uint32_t y)
+{
+  const auto splitBy1 = [](std::uint32_t a)
+  {
+    std::uint64_t v = a;
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFF;
+    v = (v | (v << 8)) & 0x00FF00FF00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0F;
+    v = (v | (v << 2)) & 0x3333333333333333;
+    v = (v | (v << 1)) & 0x5555555555555555;
+    return v;
+  };
+  return splitBy1(x) | (splitBy1(y) << 1);
+}
+
+constexpr std::uint32_t decodeMortonX(std::uint64_t code)
+{
+  std::uint64_t v = code & 0x5555555555555555;
+  v = (v | (v >> 1)) & 0x3333333333333333;
+  v = (v | (v >> 2)) & 0x0F0F0F0F0F0F0F0F;
+  v = (v | (v >> 4)) & 0x00FF00FF00FF00FF;
+  v = (v | (v >> 8)) & 0x0000FFFF0000FFFF;
+  v = (v | (v >> 16)) & 0x00000000FFFFFFFF;
+  return static_cast<std::uint32_t>(v);
+}
+
+constexpr std::uint32_t decodeMortonY(std::uint64_t code)
+{
+  return decodeMortonX(code >> 1);
+}
+
+/**
+ * The tiles of a tileset description, every zoom level from zoomMin to zoomMax in turn and the tiles of each level in
+ * Morton order. Tiles are generated while iterating, so enumerating a region at deep zoom levels takes no memory.
+ *
+ * split() divides the range into chunks of consecutive tiles, which can be iterated independently, for example by the
+ * jobs of a parallel preload.
+ */
+class TileCoordsRange
+{
+  struct TileCursor
+  {
+    std::uint32_t zoom = 0;
+    std::uint64_t code = 0;
+
+    constexpr auto operator<=>(const TileCursor& other) const = default;
+  };
+
+  /**
+   * The tiles a region intersects at a zoom level, empty if the region is inverted.
+   */
+  struct TileRect
+  {
+    std::uint32_t minX = 1;
+    std::uint32_t minY = 1;
+    std::uint32_t maxX = 0;
+    std::uint32_t maxY = 0;
+
+    static TileRect at(const BBOX& region, std::uint32_t zoom)
+    {
+      const NodeCoords southWest = geoToTileCoords(region.min, zoom);
+      const NodeCoords northEast = geoToTileCoords(region.max, zoom);
+      return {.minX = southWest.x, .minY = northEast.y, .maxX = northEast.x, .maxY = southWest.y};
+    }
+
+    bool empty() const { return minX > maxX || minY > maxY; }
+    bool contains(std::uint32_t x, std::uint32_t y) const { return x >= minX && x <= maxX && y >= minY && y <= maxY; }
+    std::uint64_t firstCode() const { return encodeMorton(minX, minY); }
+    std::uint64_t lastCode() const { return encodeMorton(maxX, maxY); }
+
+    /**
+     * The smallest Morton code above code inside the rectangle, for a code between firstCode() and lastCode() that is
+     * outside of it. This is the BIGMIN search of Tropf and Herzog, which skips the runs of the Z curve that leave the
+     * rectangle instead of stepping through them.
+     */
+    std::uint64_t nextCode(std::uint64_t code) const;
+
+    /**
+     * Number of tiles of the rectangle inside the quadtree node level levels above the tiles with the Morton code
+     * block, counting only tiles with codes in [low, high).
+     */
+    std::size_t countTiles(std::uint32_t level, std::uint64_t block, std::uint64_t low, std::uint64_t high) const;
+  };
+
+public:
+  class Iterator
+  {
+  public:
+    using iterator_concept = std::forward_iterator_tag;
+    using value_type = NodeCoords;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() = default;
+
+    NodeCoords operator*() const { return {zoom, decodeMortonX(code), decodeMortonY(code)}; }
+
+    Iterator& operator++()
+    {
+      ++code;
+      seek();
+      return *this;
+    }
+
+    Iterator operator++(int)
+    {
+      Iterator previous = *this;
+      ++*this;
+      return previous;
+    }
+
+    bool operator==(const Iterator& other) const
+    {
+      return done == other.done && (done || (zoom == other.zoom && code == other.code));
+    }
+
+    bool operator==(std::default_sentinel_t) const { return done; }
+
+  private:
+    friend class TileCoordsRange;
+
+    Iterator(const BBOX& region, TileCursor begin, TileCursor end)
+      : region(region)
+      , end(end)
+      , rect(TileRect::at(region, begin.zoom))
+      , zoom(begin.zoom)
+      , code(begin.code)
+      , done(false)
+    {
+      seek();
+    }
+
+    /**
+     * Moves to the first tile at or after the current code, going on to the next zoom levels when the current one has
+     * no more tiles.
+     */
+    void seek()
+    {
+      while (TileCursor{zoom, code} < end)
+      {
+        if (!rect.empty() && code <= rect.lastCode())
+        {
+          if (code < rect.firstCode())
+          {
+            code = rect.firstCode();
+          }
+          else if (!rect.contains(decodeMortonX(code), decodeMortonY(code)))
+          {
+            code = rect.nextCode(code);
+          }
+
+          if (TileCursor{zoom, code} < end)
+          {
+            return;
+          }
+          break;
+        }
+
+        ++zoom;
+        code = 0;
+        rect = TileRect::at(region, zoom);
+      }
+      done = true;
+    }
+
+    BBOX region{};
+    TileCursor end{};
+    TileRect rect{};
+    std::uint32_t zoom = 0;
+    std::uint64_t code = 0;
+    bool done = true;
+  };
+
+  explicit TileCoordsRange(const TilesetDescription& description);
+
+  Iterator begin() const { return {region, first, last}; }
+  std::default_sentinel_t end() const { return {}; }
+
+  std::size_t size() const { return tileCount; }
+  bool empty() const { return tileCount == 0; }
+
+  /**
+   * Divides the range into consecutive chunks of at most maxTilesPerChunk tiles, which together hold the tiles of the
+   * range in the same order. Chunks are made of whole quadtree nodes wherever the range allows, so each is a compact
+   * area of a zoom level or a run of the smaller levels.
+   */
+  std::vector<TileCoordsRange> split(std::size_t maxTilesPerChunk) const;
+
+private:
+  TileCoordsRange(const BBOX& region, TileCursor first, TileCursor last, std::size_t tileCount)
+    : region(region)
+    , first(first)
+    , last(last)
+    , tileCount(tileCount)
+  {
+  }
+
+  BBOX region;
+  // the range covers the tiles from first up to, but excluding, last
+  TileCursor first;
+  TileCursor last;
+  std::size_t tileCount = 0;
+};
+
+} // namespace flb
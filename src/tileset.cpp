@@ -0,0 +1,112 @@
+#include "tileset.hpp"
+
+#include <SDL3/SDL_log.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace flb
+{
+namespace
+{
+// deepest zoom level whose tile coordinates still fit the 32-bit node coordinates
+constexpr std::uint32_t MaxZoom = 30;
+} // namespace
+
+bool Tileset::load(const std::filesystem::path& path, std::uint32_t tileImageSize)
+{
+  regions.clear();
+
+  std::ifstream file(path);
+  if (!file.is_open())
+  {
+    SDL_Log("Failed to open tileset file: %s", path.string().c_str());
+    return false;
+  }
+
+  std::string line;
+  std::size_t lineNumber = 0;
+  while (std::getline(file, line))
+  {
+    ++lineNumber;
+    if (line.find_first_not_of(" \t\r\n") == std::string::npos)
+    {
+      continue;
+    }
+
+    std::istringstream lineStream(line);
+    TilesetDescription description{.tileImageSize = tileImageSize};
+    BBOX& region = description.zoomRegion;
+    if (
+      !(lineStream >> description.root >> description.zoomMin >> description.zoomMax >> region.min.latitude >>
+        region.min.longitude >> region.max.latitude >> region.max.longitude) ||
+      description.zoomMin > description.zoomMax || description.zoomMax > MaxZoom ||
+      region.min.latitude > region.max.latitude || region.min.longitude > region.max.longitude)
+    {
+      SDL_Log("Invalid tileset description at line %zu", lineNumber);
+      regions.clear();
+      return false;
+    }
+
+    description.root = path.parent_path() / description.root;
+    add(description);
+  }
+
+  return true;
+}
+
+void Tileset::add(const TilesetDescription& description)
+{
+  Region& region = regions.emplace_back();
+  region.description = description;
+  region.levels.reserve(description.zoomMax + 1);
+  for (std::uint32_t zoom = 0; zoom <= description.zoomMax; ++zoom)
+  {
+    const NodeCoords southWest = geoToTileCoords(description.zoomRegion.min, zoom);
+    const NodeCoords northEast = geoToTileCoords(description.zoomRegion.max, zoom);
+    region.levels.push_back({.minX = southWest.x, .minY = northEast.y, .maxX = northEast.x, .maxY = southWest.y});
+  }
+}
+
+const TilesetDescription* Tileset::findImage(NodeCoords coords) const
+{
+  const Region* best = nullptr;
+  for (const Region& region : regions)
+  {
+    const TilesetDescription& description = region.description;
+    if (
+      coords.level < description.zoomMin || coords.level > description.zoomMax ||
+      !region.levels[coords.level].contains(coords))
+    {
+      continue;
+    }
+
+    if (best == nullptr)
+    {
+      best = &region;
+      continue;
+    }
+    const std::uint64_t tileCount = region.levels[coords.level].getTileCount();
+    const std::uint64_t bestTileCount = best->levels[coords.level].getTileCount();
+    if (tileCount < bestTileCount || (tileCount == bestTileCount && description.zoomMax > best->description.zoomMax))
+    {
+      best = &region;
+    }
+  }
+  return best != nullptr ? &best->description : nullptr;
+}
+
+bool Tileset::hasDeeperImages(NodeCoords coords) const
+{
+  for (const Region& region : regions)
+  {
+    if (coords.level < region.description.zoomMax && region.levels[coords.level].contains(coords))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace flb
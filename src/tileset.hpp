@@ -0,0 +1,75 @@
+#pragma once
+
+#include "math.hpp"
+#include "quadtree.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace flb
+{
+
+/**
+ * The tiles a tile set has images for, the union of the regions and zoom ranges of its descriptions. The tile manager
+ * only splits tiles that have images deeper down and only looks for images of tiles inside a region, so nothing is
+ * split or probed on disk outside of the data.
+ */
+class Tileset
+{
+public:
+  /**
+   * Reads one description per line, "root zoomMin zoomMax minLatitude minLongitude maxLatitude maxLongitude", all with
+   * images of tileImageSize pixels. A relative root is relative to the directory of the file, a root with spaces is
+   * quoted. Returns false, keeping no descriptions, if the file can't be read or a line is invalid.
+   */
+  bool load(const std::filesystem::path& path, std::uint32_t tileImageSize);
+
+  void add(const TilesetDescription& description);
+
+  /**
+   * The most specific description whose images include the tile: the one whose region covers the fewest tiles at the
+   * tile's zoom level, then the one reaching the deepest zoom level, then the first one added. Descriptions overlap,
+   * like a whole world base layer under a detailed city, and the detailed images are preferred wherever both have one.
+   * Null if the tile is outside every region or zoom range.
+   */
+  const TilesetDescription* findImage(NodeCoords coords) const;
+
+  /**
+   * Whether a region covering the tile has images at deeper zoom levels, that is whether splitting the tile can add
+   * detail.
+   */
+  bool hasDeeperImages(NodeCoords coords) const;
+
+  bool empty() const { return regions.empty(); }
+
+private:
+  struct TileRange
+  {
+    std::uint32_t minX;
+    std::uint32_t minY;
+    std::uint32_t maxX;
+    std::uint32_t maxY;
+
+    bool contains(NodeCoords coords) const
+    {
+      return coords.x >= minX && coords.x <= maxX && coords.y >= minY && coords.y <= maxY;
+    }
+
+    std::uint64_t getTileCount() const
+    {
+      return std::uint64_t{maxX - minX + 1} * std::uint64_t{maxY - minY + 1};
+    }
+  };
+
+  struct Region
+  {
+    TilesetDescription description;
+    // tiles the region intersects at each zoom level up to zoomMax
+    std::vector<TileRange> levels;
+  };
+
+  std::vector<Region> regions;
+};
+
+} // namespace flb
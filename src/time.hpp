@@ -15,6 +15,8 @@ static TimePoint now() { return SDL_GetPerformanceCounter(); }
 
 static double toSeconds(Duration duration) { return static_cast<double>(duration) / frequency; }
 
+static Duration fromSeconds(double seconds) { return static_cast<Duration>(seconds * frequency); }
+
 static double toMilliseconds(Duration duration) { return (static_cast<double>(duration) * 1000.0) / frequency; }
 
 class Timer
@@ -0,0 +1,289 @@
+#include "traffic_manager.hpp"
+
+#include "components.hpp"
+#include "mesh_cache.hpp"
+#include "model_culling.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace flb
+{
+namespace
+{
+const glm::vec4 TrafficColor{1.0f, 0.75f, 0.0f, 1.0f};
+
+/**
+ * Seconds from since to currentTime, zero if since is later, as reports can be received after the frame started.
+ */
+double getAge(TimePoint since, TimePoint currentTime)
+{
+  return currentTime > since ? toSeconds(currentTime - since) : 0.0;
+}
+} // namespace
+
+SDL_AppResult TrafficManager::init(
+  entt::registry& registry,
+  MeshManager& meshManager,
+  gpu::Allocator& allocator,
+  const std::filesystem::path& modelPath)
+{
+  clear(registry);
+
+  const MeshHandle meshHandle = loadCachedMesh(meshManager, modelPath);
+  if (!meshHandle.isValid())
+  {
+    SDL_Log("Failed to load traffic mesh %s", modelPath.string().c_str());
+    return SDL_APP_FAILURE;
+  }
+
+  const gpu::BufferHandle instanceBuffer = allocator.createVertexBuffer(CAPACITY * sizeof(gpu::Instance));
+  if (instanceBuffer.buffer == nullptr)
+  {
+    meshManager.release(meshHandle);
+    return SDL_APP_FAILURE;
+  }
+
+  this->allocator = &allocator;
+  indicatorEntity = registry.create();
+  registry.emplace<component::IndicatorInstances>(
+    indicatorEntity, IndicatorModel{&meshManager, meshHandle, TrafficColor}, instanceBuffer);
+
+  aircraft.reserve(CAPACITY);
+  slots.assign(SLOT_COUNT, EMPTY);
+  return SDL_APP_CONTINUE;
+}
+
+void TrafficManager::clear(entt::registry& registry)
+{
+  for (const Aircraft& target : aircraft)
+  {
+    if (target.entity != entt::null)
+    {
+      registry.destroy(target.entity);
+    }
+  }
+  aircraft.clear();
+  std::fill(slots.begin(), slots.end(), EMPTY);
+  reportedFull = false;
+
+  if (indicatorEntity != entt::null)
+  {
+    allocator->releaseBuffer(registry.get<component::IndicatorInstances>(indicatorEntity).instanceBuffer.buffer);
+    registry.destroy(indicatorEntity);
+    indicatorEntity = entt::null;
+  }
+}
+
+void TrafficManager::ingest(const TrafficReport& report)
+{
+  const std::size_t slot = findSlot(report.address);
+  if (slots[slot] == EMPTY)
+  {
+    if (aircraft.size() == CAPACITY)
+    {
+      if (!reportedFull)
+      {
+        SDL_Log("Traffic table is full, ignoring aircraft beyond the first %zu", CAPACITY);
+        reportedFull = true;
+      }
+      return;
+    }
+
+    slots[slot] = static_cast<std::uint32_t>(aircraft.size());
+    aircraft.push_back({.address = report.address});
+  }
+
+  Aircraft& target = aircraft[slots[slot]];
+  target.lastSeen = std::max(target.lastSeen, report.receivedAt);
+  if (report.fields & TrafficReport::CALLSIGN)
+  {
+    target.callsign = report.callsign;
+  }
+  if (report.fields & TrafficReport::ALTITUDE)
+  {
+    target.altitude = report.altitude;
+  }
+  if (report.fields & TrafficReport::VELOCITY)
+  {
+    target.groundSpeed = report.groundSpeed;
+    target.track = report.track;
+  }
+  if (report.fields & TrafficReport::VERTICAL_RATE)
+  {
+    target.verticalRate = report.verticalRate;
+  }
+  if (report.fields & TrafficReport::POSITION)
+  {
+    target.coords = {report.latitude, report.longitude};
+    target.positionTime = report.receivedAt;
+  }
+
+  target.fields |= report.fields;
+  target.changed = target.changed || (report.fields & ~TrafficReport::CALLSIGN) != 0;
+}
+
+void TrafficManager::update(entt::registry& registry, TimePoint currentTime)
+{
+  // removing swaps the last aircraft in, which going backwards has already been checked
+  for (std::size_t i = aircraft.size(); i-- > 0;)
+  {
+    if (getAge(aircraft[i].lastSeen, currentTime) > EXPIRY)
+    {
+      remove(registry, i);
+    }
+  }
+
+  for (Aircraft& target : aircraft)
+  {
+    if (!(target.fields & TrafficReport::POSITION))
+    {
+      continue;
+    }
+
+    const bool changed = target.changed;
+    if (changed)
+    {
+      updateKinematics(target);
+      target.changed = false;
+    }
+
+    const double elapsed = std::min(getAge(target.positionTime, currentTime), MAX_EXTRAPOLATION);
+    const ECEFCoords position = target.position + target.velocity * elapsed;
+    if (target.entity == entt::null)
+    {
+      target.entity = registry.create();
+      registry.emplace<component::Traffic>(target.entity, target.address);
+      registry.emplace<component::Position>(target.entity, position);
+      registry.emplace<component::Transform>(target.entity, target.transform);
+      continue;
+    }
+
+    registry.get<component::Position>(target.entity).value = position;
+    if (changed)
+    {
+      registry.get<component::Transform>(target.entity).value = target.transform;
+    }
+  }
+}
+
+void TrafficManager::uploadInstances(entt::registry& registry, const Camera& camera)
+{
+  if (indicatorEntity == entt::null)
+  {
+    return;
+  }
+
+  auto& drawn = registry.get<component::IndicatorInstances>(indicatorEntity);
+  drawn.origin = camera.position;
+  drawn.count = 0;
+
+  // room for every aircraft, only the visible ones are drawn
+  const auto memory = allocator->allocateBufferRegion(
+    drawn.instanceBuffer, 0, static_cast<Uint32>(aircraft.size() * sizeof(gpu::Instance)));
+  if (memory.empty())
+  {
+    return;
+  }
+
+  const Mesh mesh = drawn.indicator.getMesh();
+  const auto frustum = camera.createFrustum();
+  auto* instances = reinterpret_cast<gpu::Instance*>(memory.data());
+  for (const Aircraft& target : aircraft)
+  {
+    if (target.entity == entt::null)
+    {
+      continue;
+    }
+
+    const glm::dvec3& position = registry.get<component::Position>(target.entity).value;
+    const auto& transform = registry.get<component::Transform>(target.entity);
+    const BoundingSphere boundingSphere = getWorldBoundingSphere(mesh, position, &transform);
+    if (isOccluded(camera.position, frustum, boundingSphere, generateHorizonCullingPointLoose(boundingSphere)))
+    {
+      continue;
+    }
+
+    instances[drawn.count++] = {
+      .position = glm::vec3{position - camera.position},
+      .transform = transform.value,
+    };
+  }
+}
+
+std::size_t TrafficManager::getHomeSlot(std::uint32_t address)
+{
+  // Fibonacci hashing, the top bits of the product depend on all bits of the address
+  constexpr int SlotBits = std::countr_zero(SLOT_COUNT);
+  return static_cast<std::uint32_t>(address * 0x9e3779b1u) >> (32 - SlotBits);
+}
+
+std::size_t TrafficManager::findSlot(std::uint32_t address) const
+{
+  // the index is never more than half full, so probing always ends at the aircraft or a free slot
+  std::size_t slot = getHomeSlot(address);
+  while (slots[slot] != EMPTY && aircraft[slots[slot]].address != address)
+  {
+    slot = (slot + 1) & (SLOT_COUNT - 1);
+  }
+  return slot;
+}
+
+void TrafficManager::remove(entt::registry& registry, std::size_t index)
+{
+  if (aircraft[index].entity != entt::null)
+  {
+    registry.destroy(aircraft[index].entity);
+  }
+
+  // backward shift deletion, later entries of the probe sequence move into the hole unless it lies before their home
+  constexpr std::size_t Mask = SLOT_COUNT - 1;
+  std::size_t hole = findSlot(aircraft[index].address);
+  for (std::size_t next = (hole + 1) & Mask; slots[next] != EMPTY; next = (next + 1) & Mask)
+  {
+    const std::size_t home = getHomeSlot(aircraft[slots[next]].address);
+    if (((next - home) & Mask) >= ((next - hole) & Mask))
+    {
+      slots[hole] = slots[next];
+      hole = next;
+    }
+  }
+  slots[hole] = EMPTY;
+
+  const std::size_t last = aircraft.size() - 1;
+  if (index != last)
+  {
+    aircraft[index] = aircraft[last];
+    slots[findSlot(aircraft[index].address)] = static_cast<std::uint32_t>(index);
+  }
+  aircraft.pop_back();
+}
+
+void TrafficManager::updateKinematics(Aircraft& target)
+{
+  const double height = (target.fields & TrafficReport::ALTITUDE) ? target.altitude : 0.0;
+  target.position = geoToECEF(target.coords, height);
+
+  // the model's +X points along the track, +Z up
+  const glm::dmat3 basis = getSurfaceBasis(target.coords);
+  const double track = glm::radians(static_cast<double>(target.track));
+  const glm::dvec3 forward{std::sin(track), std::cos(track), 0.0};
+  const glm::dvec3 left{-forward.y, forward.x, 0.0};
+  target.transform = glm::mat3(basis * glm::dmat3{forward, left, glm::dvec3{0.0, 0.0, 1.0}});
+
+  glm::dvec3 velocity{0.0};
+  if (target.fields & TrafficReport::VELOCITY)
+  {
+    velocity += forward * static_cast<double>(target.groundSpeed);
+  }
+  if (target.fields & TrafficReport::VERTICAL_RATE)
+  {
+    velocity.z += static_cast<double>(target.verticalRate);
+  }
+  target.velocity = basis * velocity;
+}
+
+} // namespace flb
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "adsb_receiver.hpp"
+#include "camera.hpp"
+#include "gpu/allocator.hpp"
+#include "math.hpp"
+#include "mesh_manager.hpp"
+#include "time.hpp"
+
+#include <SDL3/SDL_init.h>
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <vector>
+
+namespace flb
+{
+
+/**
+ * Keeps the aircraft reported by the ADS-B feed in a table of fixed capacity and draws each of them as an indicator.
+ *
+ * Aircraft are stored densely and found by address through an open addressing index twice as large, which is
+ * updated by backward shifting when an aircraft expires, so the table never allocates after init(). An aircraft not
+ * heard from for EXPIRY seconds is dropped, reports of new aircraft while the table is full are ignored.
+ *
+ * Every aircraft with a known position gets an entity with component::Traffic, a position dead reckoned from its last
+ * reported position and velocity for up to MAX_EXTRAPOLATION seconds and a transform facing its track. Barometric
+ * altitudes are used as heights above the ellipsoid.
+ *
+ * The aircraft are drawn as instances of one indicator, in a single draw per pass however many there are. Each frame
+ * the aircraft inside the frustum and above the horizon are written to an instance buffer relative to the camera,
+ * which an entity with component::IndicatorInstances hands to the renderer.
+ */
+class TrafficManager
+{
+public:
+  static constexpr std::size_t CAPACITY = 8192;
+  static constexpr double EXPIRY = 60.0;
+  static constexpr double MAX_EXTRAPOLATION = 10.0;
+
+  SDL_AppResult init(
+    entt::registry& registry,
+    MeshManager& meshManager,
+    gpu::Allocator& allocator,
+    const std::filesystem::path& modelPath = "content/models/floatplane/floatplane.obj");
+
+  void clear(entt::registry& registry);
+
+  /**
+   * Merges the fields of a report into its aircraft, adding the aircraft if it is new.
+   */
+  void ingest(const TrafficReport& report);
+
+  /**
+   * Drops expired aircraft and moves the entities of the others to where they are at currentTime.
+   */
+  void update(entt::registry& registry, TimePoint currentTime);
+
+  /**
+   * Writes the aircraft the camera sees to the instance buffer. Has to run after the camera and the aircraft moved and
+   * before the allocator uploads for the frame.
+   */
+  void uploadInstances(entt::registry& registry, const Camera& camera);
+
+  std::size_t getAircraftCount() const { return aircraft.size(); }
+
+private:
+  static constexpr std::size_t SLOT_COUNT = 2 * CAPACITY;
+  static constexpr std::uint32_t EMPTY = std::numeric_limits<std::uint32_t>::max();
+
+  struct Aircraft
+  {
+    std::uint32_t address = 0;
+    // TrafficReport fields reported so far
+    std::uint8_t fields = 0;
+    // reported since the position, velocity and transform were last derived
+    bool changed = false;
+    std::array<char, 8> callsign{};
+    TimePoint lastSeen = 0;
+    TimePoint positionTime = 0;
+    GeoCoords coords{};
+    double altitude = 0.0;
+    float groundSpeed = 0.0f;
+    float track = 0.0f;
+    float verticalRate = 0.0f;
+
+    // derived from the reports at positionTime, in ECEF
+    ECEFCoords position{0.0};
+    glm::dvec3 velocity{0.0};
+    glm::mat3 transform{1.0f};
+    entt::entity entity = entt::null;
+  };
+
+  static std::size_t getHomeSlot(std::uint32_t address);
+  std::size_t findSlot(std::uint32_t address) const;
+  void remove(entt::registry& registry, std::size_t index);
+  static void updateKinematics(Aircraft& aircraft);
+
+  gpu::Allocator* allocator = nullptr;
+  // holds the indicator and the instance buffer
+  entt::entity indicatorEntity = entt::null;
+  std::vector<Aircraft> aircraft;
+  // indices into aircraft, EMPTY for free slots
+  std::vector<std::uint32_t> slots;
+  bool reportedFull = false;
+};
+
+} // namespace flb
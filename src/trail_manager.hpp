@@ -0,0 +1,75 @@
+#pragma once
+
+#include "components.hpp"
+#include "gpu/allocator.hpp"
+#include "vehicle_trail.hpp"
+
+#include <entt/entt.hpp>
+
+namespace flb
+{
+
+/**
+ * Grows a trail behind every vehicle that has a position and keeps the GPU copies of the trails up to date.
+ */
+class TrailManager
+{
+public:
+  void init(entt::registry* registry, gpu::Allocator* allocator)
+  {
+    this->registry = registry;
+    this->allocator = allocator;
+  }
+
+  void cleanup()
+  {
+    for (const auto [entity, trail] : registry->view<component::Trail>().each())
+    {
+      allocator->releaseBuffer(trail.value.vertexBuffer.buffer);
+    }
+    registry->clear<component::Trail>();
+  }
+
+  /**
+   * Appends the current vehicle positions to their trails. Has to run before the allocator uploads for the frame.
+   */
+  void update()
+  {
+    const auto view = registry->view<component::Vehicle, component::Position>();
+    for (const auto [entity, vehicle, position] : view.each())
+    {
+      auto* trail = registry->try_get<component::Trail>(entity);
+      if (trail == nullptr)
+      {
+        const gpu::BufferHandle vertexBuffer = allocator->createVertexBuffer(VehicleTrail::VERTEX_BUFFER_SIZE);
+        if (vertexBuffer.buffer == nullptr)
+        {
+          continue;
+        }
+
+        trail = &registry->emplace<component::Trail>(entity);
+        trail->value.vertexBuffer = vertexBuffer;
+      }
+
+      trail->value.append(position.value);
+      trail->value.upload(*allocator);
+    }
+  }
+
+  /**
+   * Drops all trail points but keeps the vertex buffers, e.g. when the replay clock jumps.
+   */
+  void reset()
+  {
+    for (const auto [entity, trail] : registry->view<component::Trail>().each())
+    {
+      trail.value.clear();
+    }
+  }
+
+private:
+  entt::registry* registry = nullptr;
+  gpu::Allocator* allocator = nullptr;
+};
+
+} // namespace flb
@@ -0,0 +1,145 @@
+#include "vehicle_registry.hpp"
+
+#include "components.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace flb
+{
+
+SDL_AppResult VehicleRegistry::init(
+  entt::registry& registry,
+  const std::unordered_map<std::string, Model>& models,
+  const std::filesystem::path& vehiclesPath)
+{
+  clear(registry);
+
+  std::vector<VehicleDefinition> vehicles;
+  if (!parseVehiclesFile(vehiclesPath, vehicles))
+  {
+    return SDL_APP_FAILURE;
+  }
+
+  if (vehicles.empty())
+  {
+    SDL_Log("No vehicles loaded from %s", vehiclesPath.string().c_str());
+    return SDL_APP_CONTINUE;
+  }
+
+  namespaces.reserve(vehicles.size());
+  vehicleEntities.reserve(vehicles.size());
+  for (const VehicleDefinition& vehicle : vehicles)
+  {
+    const auto model = models.find(vehicle.modelName);
+    if (model == models.end())
+    {
+      SDL_Log("Unknown vehicle model %s for %s", vehicle.modelName.c_str(), vehicle.vehicleNamespace.c_str());
+      clear(registry);
+      return SDL_APP_FAILURE;
+    }
+
+    // Position and Transform are added once the first sample arrives, until then the vehicle isn't drawn.
+    const entt::entity entity = registry.create();
+    registry.emplace<component::Vehicle>(entity, static_cast<VehicleID>(vehicleEntities.size()));
+    registry.emplace<component::VehicleEstimator>(entity);
+    registry.emplace<component::Model>(entity, model->second);
+
+    namespaces.push_back(vehicle.vehicleNamespace);
+    vehicleEntities.push_back(entity);
+  }
+
+  return SDL_APP_CONTINUE;
+}
+
+void VehicleRegistry::clear(entt::registry& registry)
+{
+  for (const entt::entity vehicle : vehicleEntities)
+  {
+    if (registry.valid(vehicle))
+    {
+      registry.destroy(vehicle);
+    }
+  }
+  vehicleEntities.clear();
+  namespaces.clear();
+}
+
+void VehicleRegistry::ingest(entt::registry& registry, const TelemetrySample& sample)
+{
+  const entt::entity entity = getEntity(sample.vehicleId);
+  if (entity == entt::null)
+  {
+    return;
+  }
+
+  registry.get<component::VehicleEstimator>(entity).value.addSample(sample);
+
+  // the surface frame changes too slowly to need interpolation
+  const GeoCoords coords{sample.latitude, sample.longitude};
+  registry.emplace_or_replace<component::Transform>(entity, getSurfaceAlignedTransform(coords));
+}
+
+void VehicleRegistry::updatePoses(entt::registry& registry, TimePoint frameTime)
+{
+  const auto view = registry.view<component::VehicleEstimator>();
+  for (const auto [entity, estimator] : view.each())
+  {
+    if (!estimator.value.hasState())
+    {
+      continue;
+    }
+
+    const VehicleStateEstimator::State state = estimator.value.evaluate(frameTime);
+    registry.emplace_or_replace<component::Position>(entity, state.position);
+    registry.emplace_or_replace<component::Velocity>(entity, state.velocity);
+  }
+}
+
+void VehicleRegistry::resetStates(entt::registry& registry)
+{
+  for (const entt::entity vehicle : vehicleEntities)
+  {
+    registry.get<component::VehicleEstimator>(vehicle).value = {};
+    registry.remove<component::Position, component::Velocity>(vehicle);
+  }
+}
+
+bool VehicleRegistry::parseVehiclesFile(
+  const std::filesystem::path& vehiclesPath, std::vector<VehicleDefinition>& outVehicles)
+{
+  std::ifstream file(vehiclesPath);
+  if (!file.is_open())
+  {
+    SDL_Log("Failed to open vehicles file: %s", vehiclesPath.string().c_str());
+    return false;
+  }
+
+  std::string line;
+  std::size_t lineNumber = 0;
+  while (std::getline(file, line))
+  {
+    ++lineNumber;
+    if (line.find_first_not_of(" \t\r\n") == std::string::npos)
+    {
+      continue;
+    }
+
+    VehicleDefinition vehicle{};
+    std::istringstream lineStream(line);
+    if (!(lineStream >> vehicle.vehicleNamespace >> vehicle.modelName))
+    {
+      SDL_Log("Invalid vehicle entry at line %zu", lineNumber);
+      return false;
+    }
+
+    outVehicles.push_back(std::move(vehicle));
+  }
+
+  return true;
+}
+
+} // namespace flb
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "math.hpp"
+#include "model.hpp"
+#include "telemetry.hpp"
+#include "time.hpp"
+
+#include <SDL3/SDL_init.h>
+#include <entt/entt.hpp>
+
+#include <filesystem>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace flb
+{
+
+/**
+ * Keeps track of every vehicle listed in the vehicles file and maps incoming telemetry onto their entities.
+ *
+ * Each line of the vehicles file is "<namespace> <model>", where namespace is the PX4 ROS namespace of the vehicle
+ * ("/" for the un-namespaced topics) and model is one of the names passed to init(). Vehicle IDs are assigned in file
+ * order.
+ */
+class VehicleRegistry
+{
+public:
+  SDL_AppResult init(
+    entt::registry& registry,
+    const std::unordered_map<std::string, Model>& models,
+    const std::filesystem::path& vehiclesPath = "content/vehicles.txt");
+
+  void clear(entt::registry& registry);
+
+  /**
+   * Passes a sample to the estimator of its vehicle. Samples with unknown vehicle IDs are ignored.
+   */
+  void ingest(entt::registry& registry, const TelemetrySample& sample);
+
+  /**
+   * Moves every vehicle that has received telemetry to its estimated position and velocity at frameTime.
+   */
+  void updatePoses(entt::registry& registry, TimePoint frameTime);
+
+  /**
+   * Forgets all received telemetry, e.g. when the telemetry clock jumps during replay seeking.
+   */
+  void resetStates(entt::registry& registry);
+
+  std::span<const std::string> getNamespaces() const { return namespaces; }
+  entt::entity getEntity(VehicleID id) const { return id < vehicleEntities.size() ? vehicleEntities[id] : entt::null; }
+  std::size_t size() const { return vehicleEntities.size(); }
+
+private:
+  struct VehicleDefinition
+  {
+    std::string vehicleNamespace;
+    std::string modelName;
+  };
+
+  static bool parseVehiclesFile(const std::filesystem::path& vehiclesPath, std::vector<VehicleDefinition>& outVehicles);
+
+  std::vector<std::string> namespaces;
+  std::vector<entt::entity> vehicleEntities;
+};
+
+} // namespace flb
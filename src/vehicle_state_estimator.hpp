@@ -0,0 +1,167 @@
+#pragma once
+
+#include "math.hpp"
+#include "ring_buffer.hpp"
+#include "telemetry.hpp"
+#include "time.hpp"
+
+#include <glm/glm.hpp>
+
+namespace flb
+{
+
+/**
+ * Turns irregular, jittery telemetry samples into a smooth ECEF trajectory that can be sampled at any frame time.
+ *
+ * Samples are placed on the local clock using the vehicle's own timestamps, so arrival jitter of the link doesn't show
+ * up as motion jitter. The vehicle is displayed a fixed delay in the past and interpolated with a cubic Hermite spline
+ * between the two samples around that time. If the next sample is late, the last known velocity is used to
+ * dead-reckon for up to MAX_EXTRAPOLATION seconds.
+ */
+class VehicleStateEstimator
+{
+public:
+  static constexpr double DEFAULT_RENDER_DELAY = 0.1;
+  static constexpr double MAX_EXTRAPOLATION = 1.0;
+
+  struct State
+  {
+    ECEFCoords position{0.0};
+    glm::dvec3 velocity{0.0};
+  };
+
+  double renderDelay = DEFAULT_RENDER_DELAY;
+
+  void addSample(const TelemetrySample& sample)
+  {
+    const double receivedTime = toSeconds(sample.receivedAt);
+    double time = receivedTime;
+
+    if (sample.sourceTimestampUs != 0)
+    {
+      // The smallest observed (receive - source) difference is the link latency with the least queuing delay, it
+      // maps the source clock onto the local clock without the jitter. The offset is allowed to creep forward slowly
+      // so it follows clock drift and link latency increases instead of sticking to one lucky sample.
+      const double sourceTime = static_cast<double>(sample.sourceTimestampUs) * 1e-6;
+      const double measuredOffset = receivedTime - sourceTime;
+      const double previousOffset = clockOffset;
+      if (!hasClockOffset || measuredOffset < clockOffset || measuredOffset - clockOffset > MAX_CLOCK_OFFSET_ERROR)
+      {
+        clockOffset = measuredOffset;
+      }
+      else
+      {
+        clockOffset += (measuredOffset - clockOffset) * CLOCK_OFFSET_CREEP;
+      }
+
+      // The history was placed with the previous offset, moving it along keeps the spacing of the source clock so a
+      // new minimum doesn't make the next sample look older than the ones before it.
+      if (hasClockOffset)
+      {
+        for (std::size_t i = 0; i < samples.size(); ++i)
+        {
+          samples[i].time += clockOffset - previousOffset;
+        }
+      }
+      hasClockOffset = true;
+
+      time = sourceTime + clockOffset;
+    }
+
+    if (!samples.empty() && time <= samples.back().time)
+    {
+      // out of order or duplicated source timestamp
+      return;
+    }
+
+    const GeoCoords coords{sample.latitude, sample.longitude};
+    samples.push({time, geoToECEF(coords, sample.altitude)});
+  }
+
+  bool hasState() const { return !samples.empty(); }
+
+  /**
+   * Returns the displayed state at the given local frame time. hasState() must be true.
+   */
+  State evaluate(TimePoint frameTime) const
+  {
+    const double time = toSeconds(frameTime) - renderDelay;
+    const std::size_t count = samples.size();
+
+    if (count == 1 || time <= samples.front().time)
+    {
+      return {samples.front().position, count == 1 ? glm::dvec3{0.0} : getTangent(0)};
+    }
+
+    if (time >= samples.back().time)
+    {
+      const glm::dvec3 velocity = getTangent(count - 1);
+      const double extrapolation = glm::min(time - samples.back().time, MAX_EXTRAPOLATION);
+      return {samples.back().position + velocity * extrapolation, velocity};
+    }
+
+    // samples are few and sorted, a linear scan from the newest end is the cheapest search
+    std::size_t i = count - 2;
+    while (samples[i].time > time)
+    {
+      --i;
+    }
+
+    const Sample& p0 = samples[i];
+    const Sample& p1 = samples[i + 1];
+    const glm::dvec3 m0 = getTangent(i);
+    const glm::dvec3 m1 = getTangent(i + 1);
+
+    const double h = p1.time - p0.time;
+    const double s = (time - p0.time) / h;
+    const double s2 = s * s;
+    const double s3 = s2 * s;
+
+    const double h00 = 2.0 * s3 - 3.0 * s2 + 1.0;
+    const double h10 = s3 - 2.0 * s2 + s;
+    const double h01 = -2.0 * s3 + 3.0 * s2;
+    const double h11 = s3 - s2;
+
+    // derivatives of the basis with respect to s
+    const double d00 = 6.0 * s2 - 6.0 * s;
+    const double d10 = 3.0 * s2 - 4.0 * s + 1.0;
+    const double d01 = -6.0 * s2 + 6.0 * s;
+    const double d11 = 3.0 * s2 - 2.0 * s;
+
+    return {
+      .position = h00 * p0.position + h10 * h * m0 + h01 * p1.position + h11 * h * m1,
+      .velocity = (d00 * p0.position + d01 * p1.position) / h + d10 * m0 + d11 * m1,
+    };
+  }
+
+private:
+  static constexpr double MAX_CLOCK_OFFSET_ERROR = 1.0;
+  static constexpr double CLOCK_OFFSET_CREEP = 0.01;
+
+  struct Sample
+  {
+    double time = 0.0;
+    ECEFCoords position{0.0};
+  };
+
+  RingBuffer<Sample, 16> samples;
+  double clockOffset = 0.0;
+  bool hasClockOffset = false;
+
+  // Velocity at a sample, central difference for interior samples and one-sided at the ends (Catmull-Rom tangents
+  // for non-uniform spacing).
+  glm::dvec3 getTangent(std::size_t index) const
+  {
+    const std::size_t count = samples.size();
+    const std::size_t prev = index == 0 ? 0 : index - 1;
+    const std::size_t next = index + 1 == count ? index : index + 1;
+    if (prev == next)
+    {
+      return glm::dvec3{0.0};
+    }
+
+    return (samples[next].position - samples[prev].position) / (samples[next].time - samples[prev].time);
+  }
+};
+
+} // namespace flb
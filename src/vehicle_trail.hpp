@@ -0,0 +1,239 @@
+#pragma once
+
+#include "gpu/allocator.hpp"
+#include "gpu/pipeline.hpp"
+#include "math.hpp"
+#include "ring_buffer.hpp"
+
+#include <glm/glm.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/norm.hpp>
+
+#include <cstdint>
+#include <limits>
+
+namespace flb
+{
+
+/**
+ * Breadcrumb trail of a single vehicle.
+ *
+ * The CPU keeps the trail as a ring of ECEF positions in double precision. The GPU copy is a ring of float offsets
+ * from a per-trail origin, which keeps the vertices precise no matter where on the globe the vehicle flies; the origin
+ * is moved (and the whole ring re-uploaded) only when the vehicle gets REBASE_DISTANCE away from it. Otherwise only
+ * the points appended since the last upload are copied to the GPU.
+ *
+ * Points are decimated by travelled distance: a point is only added once the vehicle moved MIN_SPACING meters, and a
+ * point that lies on the straight line between its neighbours is merged away, so straight legs and hovering cost
+ * almost nothing. Older points are decimated further instead of being overwritten: when the ring is full, every other
+ * point of its older half is dropped and the ring is re-uploaded. A point is thinned again each time it falls into the
+ * older half, so the spacing grows with age and no history is lost. At 30 m/s through turns the last five minutes
+ * keep MIN_SPACING, points ten minutes old are 8 m apart and fifteen minutes old 16 m apart.
+ *
+ * The vertex buffer has one extra slot after the ring which mirrors slot 0, so a wrapped ring can be drawn as two line
+ * strips without a gap between them.
+ */
+class VehicleTrail
+{
+public:
+  static constexpr Uint32 CAPACITY = 8192;
+  static constexpr Uint32 VERTEX_BUFFER_SIZE = (CAPACITY + 1) * sizeof(gpu::LineVertex);
+  static constexpr double MIN_SPACING = 2.0;
+  static constexpr double MAX_SEGMENT_LENGTH = 250.0;
+  static constexpr double COLLINEAR_TOLERANCE = 0.5;
+  static constexpr double REBASE_DISTANCE = 20000.0;
+
+  gpu::BufferHandle vertexBuffer{};
+  ECEFCoords origin{0.0};
+
+  void append(const ECEFCoords& point)
+  {
+    if (points.empty() || glm::distance2(point, origin) > REBASE_DISTANCE * REBASE_DISTANCE)
+    {
+      origin = point;
+      fullUploadRequired = true;
+    }
+
+    if (!points.empty())
+    {
+      const ECEFCoords& last = points.back();
+      if (glm::distance2(point, last) < MIN_SPACING * MIN_SPACING)
+      {
+        return;
+      }
+
+      if (points.size() >= 2 && canMerge(points[points.size() - 2], last, point))
+      {
+        points[points.size() - 1] = point;
+        markDirty(totalAppended - 1);
+        return;
+      }
+    }
+
+    if (points.full())
+    {
+      thin();
+    }
+
+    points.push(point);
+    ++totalAppended;
+    markDirty(totalAppended - 1);
+  }
+
+  void clear()
+  {
+    points.clear();
+    totalAppended = 0;
+    firstDirty = NOT_DIRTY;
+    fullUploadRequired = false;
+  }
+
+  /**
+   * Copies the points changed since the last call into the vertex buffer.
+   */
+  void upload(gpu::Allocator& allocator)
+  {
+    if (vertexBuffer.buffer == nullptr || points.empty())
+    {
+      return;
+    }
+
+    const std::uint64_t oldest = totalAppended - points.size();
+    if (fullUploadRequired)
+    {
+      firstDirty = oldest;
+      fullUploadRequired = false;
+    }
+
+    if (firstDirty == NOT_DIRTY)
+    {
+      return;
+    }
+
+    const std::uint64_t first = glm::max(firstDirty, oldest);
+    const Uint32 startSlot = static_cast<Uint32>(first % CAPACITY);
+    const Uint32 count = static_cast<Uint32>(totalAppended - first);
+
+    if (startSlot + count <= CAPACITY)
+    {
+      uploadSlots(allocator, startSlot, count, first);
+    }
+    else
+    {
+      const Uint32 firstPart = CAPACITY - startSlot;
+      uploadSlots(allocator, startSlot, firstPart, first);
+      uploadSlots(allocator, 0, count - firstPart, first + firstPart);
+    }
+
+    firstDirty = NOT_DIRTY;
+  }
+
+  /**
+   * Calls callback(firstVertex, vertexCount) for every line strip that has to be drawn, oldest first.
+   */
+  template <typename Func>
+  void forEachDrawRange(Func callback) const
+  {
+    const Uint32 count = static_cast<Uint32>(points.size());
+    if (count < 2)
+    {
+      return;
+    }
+
+    const Uint32 oldestSlot = static_cast<Uint32>((totalAppended - count) % CAPACITY);
+    if (oldestSlot + count <= CAPACITY)
+    {
+      callback(oldestSlot, count);
+      return;
+    }
+
+    // the first strip ends with the mirror of slot 0, which is where the second strip starts
+    const Uint32 wrapped = oldestSlot + count - CAPACITY;
+    callback(oldestSlot, CAPACITY - oldestSlot + 1);
+    if (wrapped >= 2)
+    {
+      callback(0u, wrapped);
+    }
+  }
+
+private:
+  static constexpr std::uint64_t NOT_DIRTY = std::numeric_limits<std::uint64_t>::max();
+
+  RingBuffer<ECEFCoords, CAPACITY> points;
+  // absolute index of the next point, the point with absolute index i lives in slot i % CAPACITY
+  std::uint64_t totalAppended = 0;
+  std::uint64_t firstDirty = NOT_DIRTY;
+  bool fullUploadRequired = false;
+
+  void markDirty(std::uint64_t index) { firstDirty = glm::min(firstDirty, index); }
+
+  // Drops every other point of the older half of the full ring, moving the rest down in place. The oldest point keeps
+  // its slot, the ones after it all move, so the ring is uploaded again.
+  void thin()
+  {
+    constexpr std::size_t Half = CAPACITY / 2;
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < Half; i += 2)
+    {
+      points[kept++] = points[i];
+    }
+    for (std::size_t i = Half; i < CAPACITY; ++i)
+    {
+      points[kept++] = points[i];
+    }
+
+    const std::uint64_t oldest = totalAppended - CAPACITY;
+    points.truncate(kept);
+    totalAppended = oldest + kept;
+    fullUploadRequired = true;
+  }
+
+  // The middle point can be dropped if it is within tolerance of the straight segment from start to end.
+  static bool canMerge(const ECEFCoords& start, const ECEFCoords& middle, const ECEFCoords& end)
+  {
+    const glm::dvec3 segment = end - start;
+    const double segmentLength2 = glm::length2(segment);
+    if (segmentLength2 > MAX_SEGMENT_LENGTH * MAX_SEGMENT_LENGTH)
+    {
+      return false;
+    }
+
+    const glm::dvec3 toMiddle = middle - start;
+    if (glm::dot(toMiddle, segment) <= 0.0)
+    {
+      return false;
+    }
+
+    const double distance2 = glm::length2(glm::cross(segment, toMiddle)) / segmentLength2;
+    return distance2 < COLLINEAR_TOLERANCE * COLLINEAR_TOLERANCE;
+  }
+
+  void uploadSlots(gpu::Allocator& allocator, Uint32 startSlot, Uint32 count, std::uint64_t firstIndex)
+  {
+    const std::span<std::byte> memory = allocator.allocateBufferRegion(
+      vertexBuffer, startSlot * sizeof(gpu::LineVertex), count * sizeof(gpu::LineVertex));
+    if (memory.empty())
+    {
+      return;
+    }
+
+    const std::uint64_t oldest = totalAppended - points.size();
+    std::span<gpu::LineVertex> vertices(reinterpret_cast<gpu::LineVertex*>(memory.data()), count);
+    for (Uint32 i = 0; i < count; ++i)
+    {
+      vertices[i].position = glm::vec3(points[firstIndex + i - oldest] - origin);
+    }
+
+    if (startSlot == 0)
+    {
+      const std::span<std::byte> mirror = allocator.allocateBufferRegion(
+        vertexBuffer, CAPACITY * sizeof(gpu::LineVertex), sizeof(gpu::LineVertex));
+      if (!mirror.empty())
+      {
+        reinterpret_cast<gpu::LineVertex*>(mirror.data())->position = vertices[0].position;
+      }
+    }
+  }
+};
+
+} // namespace flb
@@ -0,0 +1,429 @@
+#include "zone_loader.hpp"
+
+#include "utils.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <charconv>
+#include <optional>
+#include <string_view>
+
+namespace flb
+{
+namespace
+{
+/**
+ * Forward-only JSON reader over an in-memory buffer. Values are consumed as they are read and nothing is kept besides
+ * the read position, so copying a cursor is a cheap way to come back to a value later. A syntax error moves the
+ * cursor to the end, which turns every later read into a no-op.
+ */
+class JsonCursor
+{
+public:
+  JsonCursor(const char* begin, const char* end) : begin(begin), ptr(begin), end(end) {}
+
+  bool hasFailed() const { return errorPtr != nullptr; }
+  std::size_t getErrorLine() const { return 1 + std::count(begin, errorPtr != nullptr ? errorPtr : ptr, '\n'); }
+
+  bool atEnd()
+  {
+    skipWhitespace();
+    return ptr >= end;
+  }
+
+  char peek()
+  {
+    skipWhitespace();
+    return ptr < end ? *ptr : '\0';
+  }
+
+  bool consume(char c)
+  {
+    if (peek() != c)
+    {
+      return false;
+    }
+    ++ptr;
+    return true;
+  }
+
+  void expect(char c)
+  {
+    if (!consume(c))
+    {
+      fail();
+    }
+  }
+
+  /**
+   * Escape sequences are skipped over but not decoded, which is enough to compare keys and type names.
+   */
+  std::string_view parseString()
+  {
+    if (peek() != '"')
+    {
+      fail();
+      return {};
+    }
+
+    const char* start = ++ptr;
+    while (ptr < end && *ptr != '"')
+    {
+      ptr += *ptr == '\\' ? 2 : 1;
+    }
+    if (ptr >= end)
+    {
+      fail();
+      return {};
+    }
+
+    return {start, static_cast<std::size_t>(ptr++ - start)};
+  }
+
+  double parseNumber()
+  {
+    skipWhitespace();
+    double value = 0.0;
+    const auto [next, error] = std::from_chars(ptr, end, value);
+    if (error != std::errc{})
+    {
+      fail();
+      return 0.0;
+    }
+    ptr = next;
+    return value;
+  }
+
+  bool isNumber()
+  {
+    const char c = peek();
+    return c == '-' || (c >= '0' && c <= '9');
+  }
+
+  /**
+   * Skips the next value. Nested objects and arrays are only matched by their brackets, not validated.
+   */
+  void skipValue()
+  {
+    const char c = peek();
+    if (c == '"')
+    {
+      parseString();
+    }
+    else if (c == '{' || c == '[')
+    {
+      std::size_t depth = 0;
+      while (ptr < end)
+      {
+        if (*ptr == '"')
+        {
+          parseString();
+          continue;
+        }
+
+        const char token = *ptr++;
+        if (token == '{' || token == '[')
+        {
+          ++depth;
+        }
+        else if ((token == '}' || token == ']') && --depth == 0)
+        {
+          return;
+        }
+      }
+      fail();
+    }
+    else if (c == 't' || c == 'f' || c == 'n')
+    {
+      while (ptr < end && *ptr >= 'a' && *ptr <= 'z')
+      {
+        ++ptr;
+      }
+    }
+    else
+    {
+      parseNumber();
+    }
+  }
+
+  /**
+   * Calls func(key) for every member of the next object, func has to read or skip the member value.
+   */
+  template <typename Func>
+  void forEachMember(Func func)
+  {
+    expect('{');
+    if (consume('}'))
+    {
+      return;
+    }
+
+    do
+    {
+      const std::string_view key = parseString();
+      expect(':');
+      if (hasFailed())
+      {
+        return;
+      }
+      func(key);
+    } while (consume(','));
+    expect('}');
+  }
+
+  /**
+   * Calls func() for every element of the next array, func has to read or skip the element.
+   */
+  template <typename Func>
+  void forEachElement(Func func)
+  {
+    expect('[');
+    if (consume(']'))
+    {
+      return;
+    }
+
+    do
+    {
+      if (hasFailed())
+      {
+        return;
+      }
+      func();
+    } while (consume(','));
+    expect(']');
+  }
+
+private:
+  void skipWhitespace()
+  {
+    while (ptr < end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\n' || *ptr == '\r'))
+    {
+      ++ptr;
+    }
+  }
+
+  void fail()
+  {
+    if (errorPtr == nullptr)
+    {
+      errorPtr = ptr;
+    }
+    ptr = end;
+  }
+
+  const char* begin;
+  const char* ptr;
+  const char* end;
+  const char* errorPtr = nullptr;
+};
+
+class GeoJSONReader
+{
+public:
+  GeoJSONReader(JsonCursor& json, double defaultCeiling, PolygonZoneCollection& zones)
+      : json(json), defaultCeiling(defaultCeiling), zones(zones)
+  {
+  }
+
+  /**
+   * Reads any GeoJSON object, a FeatureCollection, a Feature or a geometry. Members may come in any order, so the
+   * coordinates are only read once the type is known and the heights are applied once the object is complete.
+   */
+  void readObject()
+  {
+    const std::size_t firstZone = zones.zones.size();
+    std::string_view type;
+    std::optional<JsonCursor> coordinates;
+    std::optional<double> floor;
+    std::optional<double> ceiling;
+
+    json.forEachMember(
+      [&](std::string_view key)
+      {
+        if (key == "type")
+        {
+          type = json.parseString();
+        }
+        else if (key == "features" || key == "geometries")
+        {
+          json.forEachElement([&] { readObject(); });
+        }
+        else if (key == "geometry" && json.peek() == '{')
+        {
+          readObject();
+        }
+        else if (key == "coordinates")
+        {
+          coordinates = json;
+          json.skipValue();
+        }
+        else if (key == "properties" && json.peek() == '{')
+        {
+          readHeights(floor, ceiling);
+        }
+        else
+        {
+          json.skipValue();
+        }
+      });
+
+    if (coordinates)
+    {
+      if (type == "Polygon")
+      {
+        readPolygon(*coordinates);
+      }
+      else if (type == "MultiPolygon")
+      {
+        coordinates->forEachElement([&] { readPolygon(*coordinates); });
+      }
+      coordinatesFailed = coordinatesFailed || coordinates->hasFailed();
+    }
+
+    for (std::size_t i = firstZone; i < zones.zones.size(); ++i)
+    {
+      zones.zones[i].floor = floor.value_or(zones.zones[i].floor);
+      zones.zones[i].ceiling = ceiling.value_or(zones.zones[i].ceiling);
+    }
+  }
+
+  bool hasFailed() const { return json.hasFailed() || coordinatesFailed; }
+
+private:
+  void readHeights(std::optional<double>& outFloor, std::optional<double>& outCeiling)
+  {
+    json.forEachMember(
+      [&](std::string_view key)
+      {
+        if (key == "floor" && json.isNumber())
+        {
+          outFloor = json.parseNumber();
+        }
+        else if (key == "ceiling" && json.isNumber())
+        {
+          outCeiling = json.parseNumber();
+        }
+        else
+        {
+          json.skipValue();
+        }
+      });
+  }
+
+  void readPolygon(JsonCursor& cursor)
+  {
+    PolygonZone zone{
+      .firstRing = static_cast<std::uint32_t>(zones.ringStarts.size() - 1),
+      .floor = 0.0,
+      .ceiling = defaultCeiling,
+    };
+
+    // holes of a degenerate outer ring are dropped along with it
+    bool outerValid = true;
+    cursor.forEachElement(
+      [&]
+      {
+        if (!outerValid)
+        {
+          cursor.skipValue();
+          return;
+        }
+
+        const bool ringValid = readRing(cursor);
+        outerValid = ringValid || zone.ringCount > 0;
+        zone.ringCount += ringValid ? 1 : 0;
+      });
+
+    if (zone.ringCount > 0)
+    {
+      zones.zones.push_back(zone);
+    }
+    else
+    {
+      zones.ringStarts.resize(zone.firstRing + 1);
+      zones.vertices.resize(zones.ringStarts.back());
+    }
+  }
+
+  bool readRing(JsonCursor& cursor)
+  {
+    const std::size_t start = zones.vertices.size();
+    cursor.forEachElement(
+      [&]
+      {
+        // positions are [longitude, latitude] with an optional altitude, which is ignored
+        GeoCoords& vertex = zones.vertices.emplace_back(GeoCoords{0.0, 0.0});
+        std::size_t axis = 0;
+        cursor.forEachElement(
+          [&]
+          {
+            const double value = cursor.parseNumber();
+            if (axis == 0)
+            {
+              vertex.longitude = value;
+            }
+            else if (axis == 1)
+            {
+              vertex.latitude = value;
+            }
+            ++axis;
+          });
+      });
+
+    const auto isSame = [](const GeoCoords& a, const GeoCoords& b)
+    { return a.latitude == b.latitude && a.longitude == b.longitude; };
+    if (zones.vertices.size() - start > 1 && isSame(zones.vertices[start], zones.vertices.back()))
+    {
+      zones.vertices.pop_back();
+    }
+
+    if (zones.vertices.size() - start < 3)
+    {
+      zones.vertices.resize(start);
+      return false;
+    }
+
+    zones.ringStarts.push_back(static_cast<std::uint32_t>(zones.vertices.size()));
+    return true;
+  }
+
+  JsonCursor& json;
+  double defaultCeiling;
+  PolygonZoneCollection& zones;
+  bool coordinatesFailed = false;
+};
+} // namespace
+
+void PolygonZoneCollection::clear()
+{
+  vertices.clear();
+  ringStarts.assign(1, 0);
+  zones.clear();
+}
+
+bool loadGeoJSONZones(const std::filesystem::path& path, double defaultCeiling, PolygonZoneCollection& outZones)
+{
+  const std::string content = loadFileText(path);
+  if (content.empty())
+  {
+    return false;
+  }
+
+  // a coordinate pair takes at least about 30 characters in practice
+  outZones.vertices.reserve(outZones.vertices.size() + content.size() / 32);
+
+  JsonCursor json(content.data(), content.data() + content.size());
+  GeoJSONReader reader(json, defaultCeiling, outZones);
+  reader.readObject();
+  if (reader.hasFailed() || !json.atEnd())
+  {
+    SDL_Log("Invalid GeoJSON in %s at line %zu", path.string().c_str(), json.getErrorLine());
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace flb
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "math.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace flb
+{
+
+/**
+ * A polygonal no-fly zone, an outer ring followed by its holes, extruded between two heights above the ellipsoid.
+ */
+struct PolygonZone
+{
+  std::uint32_t firstRing = 0;
+  std::uint32_t ringCount = 0;
+  double floor = 0.0;
+  double ceiling = 0.0;
+};
+
+/**
+ * Flat storage of many polygonal zones. Ring i owns vertices[ringStarts[i], ringStarts[i + 1]), the closing vertex of
+ * a ring is not repeated.
+ */
+struct PolygonZoneCollection
+{
+  std::vector<GeoCoords> vertices;
+  std::vector<std::uint32_t> ringStarts{0};
+  std::vector<PolygonZone> zones;
+
+  std::uint32_t getRingSize(std::uint32_t ring) const { return ringStarts[ring + 1] - ringStarts[ring]; }
+  void clear();
+};
+
+/**
+ * Reads Polygon and MultiPolygon zones from a GeoJSON file in a single pass. The file may hold a FeatureCollection, a
+ * single Feature or a bare geometry, other geometry types are skipped. The optional "floor" and "ceiling" properties
+ * of a feature give the zone heights in meters, zones without them span [0, defaultCeiling].
+ *
+ * Zones are appended to outZones. Returns false if the file can't be read or isn't valid JSON.
+ */
+bool loadGeoJSONZones(
+  const std::filesystem::path& path, double defaultCeiling, PolygonZoneCollection& outZones);
+
+} // namespace flb
@@ -0,0 +1,357 @@
+#include "obj_loader.hpp"
+
+#include <SDL3/SDL_log.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+/**
+ * Times loadOBJ() against the loader it replaced, on the given OBJ file and on a generated one that is large enough
+ * to be split into chunks, with every thread count up to the number of hardware threads.
+ *
+ * Usage: obj_loader_benchmark <file.obj> [iterations]
+ */
+
+namespace
+{
+using flb::gpu::Vertex;
+using flb::gpu::WideIndex;
+using Clock = std::chrono::steady_clock;
+
+// rows and columns of vertices of the generated grid, about 30 MB of OBJ
+constexpr int GridSize = 512;
+
+inline const char* skipSpace(const char* ptr, const char* end)
+{
+  while (ptr < end && (*ptr == ' ' || *ptr == '\t'))
+  {
+    ptr++;
+  }
+  return ptr;
+}
+
+inline const char* nextLine(const char* ptr, const char* end)
+{
+  while (ptr < end && *ptr != '\n' && *ptr != '\r')
+  {
+    ptr++;
+  }
+  // Skip potential \r\n or just \n
+  if (ptr < end && *ptr == '\r')
+    ptr++;
+  if (ptr < end && *ptr == '\n')
+    ptr++;
+  return ptr;
+}
+
+inline const char* parseFloat(const char* ptr, const char* end, float& value)
+{
+  ptr = skipSpace(ptr, end);
+  auto res = std::from_chars(ptr, end, value);
+  return res.ptr;
+}
+
+inline const char* parseInt(const char* ptr, const char* end, int& value)
+{
+  auto res = std::from_chars(ptr, end, value);
+  return res.ptr;
+}
+
+/**
+ * The loader before the hashed vertex table and the pre-scan, kept as the baseline. Only the index type differs, so
+ * that files with more than 65536 vertices load.
+ */
+std::pair<std::vector<Vertex>, std::vector<WideIndex>> loadOBJReference(const std::filesystem::path& path)
+{
+  const auto content = flb::loadFileText(path);
+  const char* ptr = content.data();
+  const char* end = content.data() + content.size();
+
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> normals;
+  std::vector<glm::vec2> texCoords;
+  std::vector<glm::vec3> colors;
+
+  std::vector<Vertex> vertices;
+  std::vector<WideIndex> indices;
+
+  std::map<std::tuple<int, int, int>, WideIndex> uniqueVertices;
+
+  while (ptr < end)
+  {
+    ptr = skipSpace(ptr, end);
+    if (ptr >= end)
+      break;
+
+    if (*ptr == '#')
+    {
+      ptr = nextLine(ptr, end);
+      continue;
+    }
+
+    if (*ptr == 'v')
+    {
+      char type = (ptr + 1 < end) ? *(ptr + 1) : '\0';
+
+      if (type == ' ')
+      {
+        ptr += 2;
+        glm::vec3 v;
+        ptr = parseFloat(ptr, end, v.x);
+        ptr = parseFloat(ptr, end, v.y);
+        ptr = parseFloat(ptr, end, v.z);
+        positions.push_back(v);
+
+        const char* lineEnd = ptr;
+        while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r')
+          lineEnd++;
+
+        const char* check = skipSpace(ptr, lineEnd);
+        if (check < lineEnd)
+        {
+          glm::vec3 c;
+          ptr = parseFloat(ptr, end, c.r);
+          ptr = parseFloat(ptr, end, c.g);
+          ptr = parseFloat(ptr, end, c.b);
+          colors.push_back(c);
+        }
+        else
+        {
+          colors.emplace_back(1.0f);
+        }
+      }
+      else if (type == 'n')
+      {
+        ptr += 3;
+        glm::vec3 vn;
+        ptr = parseFloat(ptr, end, vn.x);
+        ptr = parseFloat(ptr, end, vn.y);
+        ptr = parseFloat(ptr, end, vn.z);
+        normals.push_back(vn);
+      }
+      else if (type == 't')
+      {
+        ptr += 3;
+        glm::vec2 vt;
+        ptr = parseFloat(ptr, end, vt.x);
+        ptr = parseFloat(ptr, end, vt.y);
+        vt.y = 1.0f - vt.y;
+        texCoords.push_back(vt);
+      }
+
+      ptr = nextLine(ptr, end);
+    }
+    else if (*ptr == 'f' && (ptr + 1 < end && *(ptr + 1) == ' '))
+    {
+      ptr += 2;
+      const char* lineEnd = ptr;
+      while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r')
+        lineEnd++;
+
+      std::vector<std::tuple<int, int, int>> faceIndices;
+
+      while (ptr < lineEnd)
+      {
+        ptr = skipSpace(ptr, lineEnd);
+        if (ptr >= lineEnd)
+          break;
+
+        int vIdx = -1, vtIdx = -1, vnIdx = -1;
+        ptr = parseInt(ptr, lineEnd, vIdx);
+        if (ptr < lineEnd && *ptr == '/')
+        {
+          ptr++;
+          if (ptr < lineEnd && *ptr == '/')
+          {
+            ptr++;
+            ptr = parseInt(ptr, lineEnd, vnIdx);
+          }
+          else
+          {
+            ptr = parseInt(ptr, lineEnd, vtIdx);
+            if (ptr < lineEnd && *ptr == '/')
+            {
+              ptr++;
+              ptr = parseInt(ptr, lineEnd, vnIdx);
+            }
+          }
+        }
+
+        if (vIdx > 0)
+          vIdx--;
+        if (vtIdx > 0)
+          vtIdx--;
+        if (vnIdx > 0)
+          vnIdx--;
+
+        faceIndices.emplace_back(vIdx, vtIdx, vnIdx);
+      }
+
+      for (size_t i = 1; i + 1 < faceIndices.size(); ++i)
+      {
+        std::tuple<int, int, int> triVerts[3] = {faceIndices[0], faceIndices[i], faceIndices[i + 1]};
+
+        for (const auto& key : triVerts)
+        {
+          auto it = uniqueVertices.find(key);
+          if (it == uniqueVertices.end())
+          {
+            Vertex vertex{};
+            auto [v, vt, vn] = key;
+
+            if (v >= 0 && v < static_cast<int>(positions.size()))
+              vertex.position = positions[v];
+            if (v >= 0 && v < static_cast<int>(colors.size()))
+              vertex.color = colors[v];
+            else
+              vertex.color = {1.0f, 1.0f, 1.0f};
+            if (vt >= 0 && vt < static_cast<int>(texCoords.size()))
+              vertex.uv = texCoords[vt];
+            if (vn >= 0 && vn < static_cast<int>(normals.size()))
+              vertex.normal = normals[vn];
+
+            WideIndex newIndex = static_cast<WideIndex>(vertices.size());
+            uniqueVertices[key] = newIndex;
+            vertices.push_back(vertex);
+            indices.push_back(newIndex);
+          }
+          else
+          {
+            indices.push_back(it->second);
+          }
+        }
+      }
+
+      ptr = nextLine(lineEnd, end);
+    }
+    else
+    {
+      ptr = nextLine(ptr, end);
+    }
+  }
+
+  return {vertices, indices};
+}
+
+/**
+ * Writes a square grid of quads with positions, uvs and normals, the way exporters write them.
+ */
+bool writeGridOBJ(const std::filesystem::path& path)
+{
+  std::ofstream file(path, std::ios::binary);
+  file.setf(std::ios::fixed);
+  file.precision(6);
+  for (int y = 0; y < GridSize; ++y)
+  {
+    for (int x = 0; x < GridSize; ++x)
+    {
+      file << "v " << x * 0.25 << ' ' << 0.01 * ((x * 7 + y * 13) % 17) << ' ' << y * -0.25 << '\n';
+    }
+  }
+  for (int y = 0; y < GridSize; ++y)
+  {
+    for (int x = 0; x < GridSize; ++x)
+    {
+      file << "vt " << x / (GridSize - 1.0) << ' ' << y / (GridSize - 1.0) << '\n';
+    }
+  }
+  file << "vn 0.000000 1.000000 0.000000\n";
+  for (int y = 0; y + 1 < GridSize; ++y)
+  {
+    for (int x = 0; x + 1 < GridSize; ++x)
+    {
+      const int a = y * GridSize + x + 1;
+      const int b = a + GridSize;
+      file << "f " << a << '/' << a << "/1 " << b << '/' << b << "/1 " << b + 1 << '/' << b + 1 << "/1 " << a + 1
+           << '/' << a + 1 << "/1\n";
+    }
+  }
+  return static_cast<bool>(file);
+}
+
+/**
+ * Fastest of iterations runs of load in milliseconds, the fastest is the least disturbed by the rest of the system.
+ */
+template <typename Load>
+double timeLoad(int iterations, const Load& load, std::size_t& vertexCount, std::size_t& indexCount)
+{
+  double best = std::numeric_limits<double>::max();
+  for (int i = 0; i < iterations; ++i)
+  {
+    const Clock::time_point start = Clock::now();
+    const auto [vertices, indices] = load();
+    const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    best = std::min(best, elapsed.count());
+    vertexCount = vertices.size();
+    indexCount = indices.size();
+  }
+  return best;
+}
+
+/**
+ * Times the reference and the new loader on path, and the new one with every thread count. Returns false if the
+ * loaders disagree.
+ */
+bool benchmark(const std::filesystem::path& path, int iterations, unsigned int maxThreads)
+{
+  SDL_Log("%s, %ju bytes", path.c_str(), static_cast<std::uintmax_t>(std::filesystem::file_size(path)));
+
+  std::size_t referenceVertices = 0;
+  std::size_t referenceIndices = 0;
+  const double reference =
+    timeLoad(iterations, [&] { return loadOBJReference(path); }, referenceVertices, referenceIndices);
+  SDL_Log("  reference    %8.2f ms, %zu vertices, %zu indices", reference, referenceVertices, referenceIndices);
+
+  bool matches = true;
+  for (unsigned int threads = 1; threads <= maxThreads; threads *= 2)
+  {
+    std::size_t vertexCount = 0;
+    std::size_t indexCount = 0;
+    const double elapsed = timeLoad(iterations, [&] { return flb::loadOBJ(path, threads); }, vertexCount, indexCount);
+    SDL_Log("  %2u thread(s) %8.2f ms, %.2fx", threads, elapsed, reference / elapsed);
+    matches = matches && vertexCount == referenceVertices && indexCount == referenceIndices;
+  }
+
+  if (!matches)
+  {
+    SDL_Log("  loadOBJ and the reference loader disagree");
+  }
+  return matches;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    SDL_Log("Usage: %s <file.obj> [iterations]", argv[0]);
+    return EXIT_FAILURE;
+  }
+  const int iterations = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 10;
+
+  // powers of two up to the hardware threads, at least two so that the chunked path always runs
+  const unsigned int maxThreads = std::max(std::thread::hardware_concurrency(), 2u);
+
+  bool matches = benchmark(argv[1], iterations, maxThreads);
+
+  const std::filesystem::path gridPath = std::filesystem::temp_directory_path() / "obj_loader_benchmark_grid.obj";
+  if (!writeGridOBJ(gridPath))
+  {
+    SDL_Log("Can't write %s", gridPath.c_str());
+    return EXIT_FAILURE;
+  }
+  matches = benchmark(gridPath, std::max(iterations / 5, 1), maxThreads) && matches;
+  std::filesystem::remove(gridPath);
+
+  return matches ? EXIT_SUCCESS : EXIT_FAILURE;
+}
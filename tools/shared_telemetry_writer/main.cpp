@@ -0,0 +1,91 @@
+#include "shared_telemetry_writer.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <numbers>
+#include <thread>
+
+/**
+ * Simulates vehicles flying circles and writes their positions to a shared memory telemetry ring, which flightboard
+ * reads with --shm-telemetry <name>. Runs for the given number of seconds, or until killed if it is zero.
+ *
+ * Usage: shared_telemetry_writer <name> [vehicles] [rate in Hz] [seconds]
+ */
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr double CenterLatitude = 39.78;
+constexpr double CenterLongitude = 30.52;
+constexpr double MetersPerDegree = 111'320.0;
+constexpr double CircleRadius = 500.0;
+constexpr double CircleSpeed = 20.0;
+
+/**
+ * Position of a vehicle at time seconds, on a circle of its own around the center, each one a bit further out and
+ * higher up.
+ */
+flb::TelemetrySample simulate(flb::VehicleID vehicleId, double seconds)
+{
+  const double radius = CircleRadius + 50.0 * vehicleId;
+  const double angle = seconds * CircleSpeed / radius + vehicleId;
+  const double north = radius * std::cos(angle);
+  const double east = radius * std::sin(angle);
+  const double cosLatitude = std::cos(CenterLatitude * std::numbers::pi / 180.0);
+
+  return {
+    .vehicleId = vehicleId,
+    .sourceTimestampUs = static_cast<std::uint64_t>(seconds * 1e6),
+    .latitude = CenterLatitude + north / MetersPerDegree,
+    .longitude = CenterLongitude + east / (MetersPerDegree * cosLatitude),
+    .altitude = 100.0 + 10.0 * vehicleId,
+  };
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    SDL_Log("Usage: %s <name> [vehicles] [rate in Hz] [seconds]", argv[0]);
+    return EXIT_FAILURE;
+  }
+  const int vehicles = argc > 2 ? std::atoi(argv[2]) : 4;
+  const double rate = argc > 3 ? std::atof(argv[3]) : 50.0;
+  const double duration = argc > 4 ? std::atof(argv[4]) : 0.0;
+  if (vehicles <= 0 || rate <= 0.0 || duration < 0.0)
+  {
+    SDL_Log("Invalid vehicle count, rate or duration");
+    return EXIT_FAILURE;
+  }
+
+  flb::SharedTelemetryWriter writer;
+  if (!writer.create(argv[1]))
+  {
+    return EXIT_FAILURE;
+  }
+  SDL_Log("Writing %d vehicles at %.1f Hz to shared telemetry %s", vehicles, rate, argv[1]);
+
+  const Clock::time_point start = Clock::now();
+  const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate));
+  for (std::uint64_t tick = 0;; ++tick)
+  {
+    const double seconds = static_cast<double>(tick) / rate;
+    if (duration > 0.0 && seconds >= duration)
+    {
+      break;
+    }
+
+    for (int vehicle = 0; vehicle < vehicles; ++vehicle)
+    {
+      writer.publish(simulate(static_cast<flb::VehicleID>(vehicle), seconds));
+    }
+    std::this_thread::sleep_until(start + period * (tick + 1));
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+#include "shared_telemetry_writer.hpp"
+
+#include <SDL3/SDL.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+namespace flb
+{
+
+bool SharedTelemetryWriter::create(std::string_view name, std::uint32_t capacity)
+{
+  close();
+
+  if (!std::has_single_bit(capacity))
+  {
+    SDL_Log("Shared telemetry capacity %u isn't a power of two", capacity);
+    return false;
+  }
+
+  const std::string objectName = sharedtelemetry::getObjectName(name);
+  const int descriptor = ::shm_open(objectName.c_str(), O_CREAT | O_RDWR, 0644);
+  if (descriptor < 0)
+  {
+    SDL_Log("Failed to create shared telemetry %s: %s", objectName.c_str(), std::strerror(errno));
+    return false;
+  }
+
+  // resizing a ring that readers have mapped would cut their mappings short
+  const std::size_t size = sharedtelemetry::getSize(capacity);
+  struct stat status{};
+  const bool sized = ::fstat(descriptor, &status) == 0 &&
+                     (status.st_size == 0 ? ::ftruncate(descriptor, static_cast<off_t>(size)) == 0
+                                          : static_cast<std::size_t>(status.st_size) == size);
+  void* memory = sized ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0) : MAP_FAILED;
+  ::close(descriptor);
+  if (memory == MAP_FAILED)
+  {
+    SDL_Log(
+      "Failed to map shared telemetry %s of %zu bytes, it may exist with another capacity",
+      objectName.c_str(),
+      size);
+    return false;
+  }
+
+  header = static_cast<sharedtelemetry::Header*>(memory);
+  slots = reinterpret_cast<sharedtelemetry::Slot*>(static_cast<std::byte*>(memory) + sizeof(*header));
+  mappedSize = size;
+  this->capacity = capacity;
+
+  header->version = sharedtelemetry::VERSION;
+  header->headerSize = sizeof(sharedtelemetry::Header);
+  header->slotSize = sizeof(sharedtelemetry::Slot);
+  header->capacity = capacity;
+
+  // a new generation, odd while the write count is reset. One a crashed writer left odd is moved past
+  const std::uint64_t previousGeneration = header->generation.load(std::memory_order_relaxed);
+  const std::uint64_t resetGeneration = previousGeneration + (previousGeneration % 2 == 0 ? 1 : 2);
+  header->generation.store(resetGeneration, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  header->writeCount.store(0, std::memory_order_relaxed);
+  header->generation.store(resetGeneration + 1, std::memory_order_release);
+
+  // readers check the magic first, it is written once the rest of the header is in place
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(header->magic, sharedtelemetry::MAGIC, sizeof(sharedtelemetry::MAGIC));
+  return true;
+}
+
+void SharedTelemetryWriter::close()
+{
+  if (header != nullptr)
+  {
+    ::munmap(header, mappedSize);
+  }
+  header = nullptr;
+  slots = nullptr;
+  mappedSize = 0;
+  capacity = 0;
+}
+
+void SharedTelemetryWriter::publish(const TelemetrySample& sample)
+{
+  const std::uint64_t index = header->writeCount.load(std::memory_order_relaxed);
+  sharedtelemetry::Slot& slot = slots[index & (capacity - 1)];
+
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.writeTimeNs.store(sharedtelemetry::getMonotonicNs(), std::memory_order_relaxed);
+  slot.vehicleId.store(sample.vehicleId, std::memory_order_relaxed);
+  slot.sourceTimestampUs.store(sample.sourceTimestampUs, std::memory_order_relaxed);
+  slot.latitude.store(std::bit_cast<std::uint64_t>(sample.latitude), std::memory_order_relaxed);
+  slot.longitude.store(std::bit_cast<std::uint64_t>(sample.longitude), std::memory_order_relaxed);
+  slot.altitude.store(std::bit_cast<std::uint64_t>(sample.altitude), std::memory_order_relaxed);
+  slot.sequence.store(2 * index + 2, std::memory_order_release);
+
+  header->writeCount.store(index + 1, std::memory_order_release);
+}
+
+} // namespace flb
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "shared_telemetry.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace flb
+{
+
+/**
+ * Reference writer for the shared memory telemetry ring read by SharedTelemetryReader, for simulators to link against
+ * or copy. publish() is wait-free and may only be called from one thread at a time.
+ */
+class SharedTelemetryWriter
+{
+public:
+  ~SharedTelemetryWriter() { close(); }
+
+  /**
+   * Creates the ring named name, or takes over an existing one of the same capacity, and starts a new generation
+   * writing from zero. capacity has to be a power of two.
+   */
+  bool create(std::string_view name, std::uint32_t capacity = sharedtelemetry::DEFAULT_CAPACITY);
+
+  /**
+   * Unmaps the ring, which stays in place for readers until it is unlinked with shm_unlink().
+   */
+  void close();
+
+  /**
+   * Writes a sample, its receivedAt is ignored.
+   */
+  void publish(const TelemetrySample& sample);
+
+private:
+  sharedtelemetry::Header* header = nullptr;
+  sharedtelemetry::Slot* slots = nullptr;
+  std::size_t mappedSize = 0;
+  std::uint32_t capacity = 0;
+};
+
+} // namespace flb